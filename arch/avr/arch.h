@@ -36,6 +36,9 @@
 #include <assert.h> /* for assert */
 #include <string.h> /* for memcpy */
 
+/** AVR has no data cache, prevents padding of cacheline_aligned data */
+#define CACHELINE_SIZE 1
+
 void __attribute__ ((noreturn)) abort(void);
 
 #endif
@@ -0,0 +1,156 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include "arch.h"
+#include "crc.h"
+#include "circfifo.h"
+
+unsigned arch_cpu_features = 0;
+
+static uint16_t arch_crc16_update_stub(uint16_t crc, const void *buff, unsigned size)
+{
+   arch_init();
+   return arch_dispatch.crc16_update(crc, buff, size);
+}
+
+static const uint8_t* arch_circfifo_scan_stub(const uint8_t *buff, unsigned size, uint8_t byte)
+{
+   arch_init();
+   return (arch_dispatch.circfifo_scan)(buff, size, byte);
+}
+
+static void arch_crc16_update_multi_stub(crc16_job_t *jobs, unsigned cnt)
+{
+   arch_init();
+   arch_dispatch.crc16_update_multi(jobs, cnt);
+}
+
+arch_dispatch_t arch_dispatch = {
+   .crc16_update = arch_crc16_update_stub,
+   .circfifo_scan = arch_circfifo_scan_stub,
+   .crc16_update_multi = arch_crc16_update_multi_stub,
+};
+
+static const struct {
+   const char *name;
+   unsigned feature;
+} arch_cpu_names[] = {
+   { "sse2", ARCH_CPU_SSE2 },
+   { "sse4.2", ARCH_CPU_SSE42 },
+   { "pclmul", ARCH_CPU_PCLMUL },
+   { "avx2", ARCH_CPU_AVX2 },
+   { "avx512", ARCH_CPU_AVX512 },
+};
+
+static unsigned arch_cpu_detect(void)
+{
+   unsigned features = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+   __builtin_cpu_init();
+   features |= __builtin_cpu_supports("sse2") ? ARCH_CPU_SSE2 : 0;
+   features |= __builtin_cpu_supports("sse4.2") ? ARCH_CPU_SSE42 : 0;
+   features |= __builtin_cpu_supports("pclmul") ? ARCH_CPU_PCLMUL : 0;
+   features |= __builtin_cpu_supports("avx2") ? ARCH_CPU_AVX2 : 0;
+   features |= (__builtin_cpu_supports("avx512f") &&
+                __builtin_cpu_supports("avx512bw")) ? ARCH_CPU_AVX512 : 0;
+#endif
+
+   return features;
+}
+
+/* parses GENERICS_CPU, returns the mask of allowed features */
+static unsigned arch_cpu_allowed(void)
+{
+   const char *env = getenv("GENERICS_CPU");
+   unsigned allowed = 0;
+   unsigned i;
+
+   if( NULL == env )
+   {
+      return ~0u;
+   }
+   while( '\0' != *env )
+   {
+      size_t len = strcspn(env, ",");
+
+      for( i = 0; i < sizeof(arch_cpu_names) / sizeof(arch_cpu_names[0]); i++ )
+      {
+         if( (strlen(arch_cpu_names[i].name) == len) &&
+             (0 == strncmp(arch_cpu_names[i].name, env, len)) )
+         {
+            allowed |= arch_cpu_names[i].feature;
+         }
+      }
+      env += len + ((',' == env[len]) ? 1 : 0);
+   }
+
+   return allowed;
+}
+
+void __attribute__((constructor)) arch_init(void)
+{
+   unsigned features = arch_cpu_detect() & arch_cpu_allowed();
+   uint16_t (*crc16)(uint16_t, const void*, unsigned) = crc16_update_slice8;
+   const uint8_t* (*scan)(const uint8_t*, unsigned, uint8_t) = circfifo_scan_scalar;
+   void (*crc16_multi)(crc16_job_t*, unsigned) = crc16_update_multi_scalar;
+
+#if defined(__x86_64__) || defined(__i386__)
+   if( (features & (ARCH_CPU_SSE2 | ARCH_CPU_PCLMUL)) == (ARCH_CPU_SSE2 | ARCH_CPU_PCLMUL) )
+   {
+      crc16 = crc16_update_pclmul;
+   }
+   if( features & ARCH_CPU_AVX512 )
+   {
+      crc16_multi = crc16_update_multi_avx512;
+   }
+   else if( features & ARCH_CPU_AVX2 )
+   {
+      crc16_multi = crc16_update_multi_avx2;
+   }
+   if( features & ARCH_CPU_AVX2 )
+   {
+      scan = circfifo_scan_avx2;
+   }
+   else if( features & ARCH_CPU_SSE2 )
+   {
+      scan = circfifo_scan_sse2;
+   }
+#endif
+
+   /* other threads may already call through the table, each entry is
+    * replaced atomically and both old and new implementation are valid */
+   __atomic_store_n(&arch_cpu_features, features, __ATOMIC_RELAXED);
+   __atomic_store_n(&arch_dispatch.crc16_update, crc16, __ATOMIC_RELEASE);
+   __atomic_store_n(&arch_dispatch.circfifo_scan, scan, __ATOMIC_RELEASE);
+   __atomic_store_n(&arch_dispatch.crc16_update_multi, crc16_multi, __ATOMIC_RELEASE);
+}
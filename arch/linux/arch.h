@@ -0,0 +1,90 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __ARCH_H_
+#define __ARCH_H_ 1
+
+#include <stdint.h> /* for uint8_t */
+#include <stdbool.h> /* for bool */
+#include <assert.h> /* for assert */
+#include <string.h> /* for memcpy */
+
+/** size of L1 data cache line in bytes */
+#define CACHELINE_SIZE 64
+
+/**
+ * CPU features detected at startup, used to choose the implementation of hot
+ * routines. Detected set can be narrowed by GENERICS_CPU environment variable,
+ * the comma separated list of allowed features (sse2, sse4.2, pclmul, avx2,
+ * avx512) or "generic" for portable C code only. Features which CPU does not
+ * have are ignored. Used for benchmarking of particular implementations.
+ */
+#define ARCH_CPU_SSE2 (1u << 0)
+#define ARCH_CPU_SSE42 (1u << 1)
+#define ARCH_CPU_PCLMUL (1u << 2)
+#define ARCH_CPU_AVX2 (1u << 3)
+/** AVX-512 F and BW */
+#define ARCH_CPU_AVX512 (1u << 4)
+
+/**
+ * Table of implementations chosen for current CPU, each routine which has
+ * arch specific variants calls through this table. Until arch_init() runs the
+ * entries point to stubs which call it, so the table can be used also from
+ * other constructors.
+ */
+struct crc16_job_tag;
+
+typedef struct arch_dispatch_tag {
+   uint16_t (*crc16_update)(uint16_t crc, const void *buff, unsigned size);
+   const uint8_t* (*circfifo_scan)(const uint8_t *buff, unsigned size, uint8_t byte);
+   void (*crc16_update_multi)(struct crc16_job_tag *jobs, unsigned cnt);
+} arch_dispatch_t;
+
+#define ARCH_DISPATCH 1
+
+extern arch_dispatch_t arch_dispatch;
+extern unsigned arch_cpu_features;
+
+/**
+ * Function detects CPU features and fills arch_dispatch. Called automatically
+ * at startup, can be called again after GENERICS_CPU was changed.
+ */
+void arch_init(void);
+
+/**
+ * \return true if all given ARCH_CPU_ features are available
+ */
+static inline bool arch_cpu_has(unsigned features)
+{
+   return (arch_cpu_features & features) == features;
+}
+
+#endif
@@ -0,0 +1,282 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "circfifo_file.h"
+#include "crc.h"
+#include "gmacros.h"
+
+#define CIRCFIFO_FILE_HDR_SIZE 4096
+
+/* distance from index from to index to in data area */
+static uint32_t circfifo_file_dist(const circfifo_file_t *cf, uint32_t from, uint32_t to)
+{
+   return (to >= from) ? to - from : to + cf->hdr->size - from;
+}
+
+static uint32_t circfifo_file_put_at(circfifo_file_t *cf, uint32_t pos, const void *src, uint32_t n)
+{
+   uint32_t first = min(n, cf->hdr->size - pos);
+
+   memcpy(&cf->buff[pos], src, first);
+   memcpy(cf->buff, (const uint8_t*)src + first, n - first);
+   pos += n;
+   return (pos >= cf->hdr->size) ? pos - cf->hdr->size : pos;
+}
+
+static uint32_t circfifo_file_get_at(const circfifo_file_t *cf, uint32_t pos, void *dst, uint32_t n)
+{
+   uint32_t first = min(n, cf->hdr->size - pos);
+
+   memcpy(dst, &cf->buff[pos], first);
+   memcpy((uint8_t*)dst + first, cf->buff, n - first);
+   pos += n;
+   return (pos >= cf->hdr->size) ? pos - cf->hdr->size : pos;
+}
+
+/* CRC16 over sequence number, length and payload at index pos */
+static uint16_t circfifo_file_crc(const circfifo_file_t *cf, const circfifo_file_rec_t *rec, uint32_t pos)
+{
+   uint16_t crc = crc16_update(0xFFFF, rec, offsetof(circfifo_file_rec_t, crc));
+   uint32_t first = min((uint32_t)rec->len, cf->hdr->size - pos);
+
+   crc = crc16_update(crc, &cf->buff[pos], first);
+   return crc16_update(crc, cf->buff, rec->len - first);
+}
+
+/* flushes the range of data area [from, to) which can wrap */
+static int circfifo_file_msync(circfifo_file_t *cf, uint32_t from, uint32_t to)
+{
+   long page = sysconf(_SC_PAGESIZE);
+   uintptr_t start, end;
+   int ret = 0;
+
+   if( from == to )
+   {
+      return 0;
+   }
+   if( to < from )
+   {
+      ret = circfifo_file_msync(cf, 0, to);
+      to = cf->hdr->size;
+   }
+   start = (uintptr_t)&cf->buff[from] & ~(uintptr_t)(page - 1);
+   end = (uintptr_t)&cf->buff[to];
+   if( 0 != msync((void*)start, end - start, MS_SYNC) )
+   {
+      ret = -errno;
+   }
+   return ret;
+}
+
+/* finds the last valid record after the read index */
+static void circfifo_file_recover(circfifo_file_t *cf)
+{
+   circfifo_file_hdr_t *hdr = cf->hdr;
+   circfifo_file_rec_t rec;
+   uint32_t pos = hdr->rd;
+   uint32_t seq = hdr->rd_seq;
+   uint32_t used = 0;
+   uint32_t next;
+
+   cf->recovered = 0;
+   while( used + sizeof(rec) < hdr->size )
+   {
+      next = circfifo_file_get_at(cf, pos, &rec, sizeof(rec));
+      if( (rec.seq != seq) || (used + sizeof(rec) + rec.len >= hdr->size) ||
+          (rec.crc != circfifo_file_crc(cf, &rec, next)) )
+      {
+         break;
+      }
+      used += sizeof(rec) + rec.len;
+      pos = next + rec.len;
+      pos -= (pos >= hdr->size) ? hdr->size : 0;
+      seq++;
+      cf->recovered++;
+   }
+   hdr->wr = pos;
+   hdr->wr_seq = seq;
+   cf->synced = pos;
+}
+
+int circfifo_file_open(circfifo_file_t *cf, const char *path, unsigned size, unsigned sync_bytes)
+{
+   struct stat st;
+   void *map;
+   int ret;
+
+   assert((size > sizeof(circfifo_file_rec_t)) && (size <= UINT32_MAX / 2));
+
+   memset(cf, 0, sizeof(*cf));
+   cf->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+   if( cf->fd < 0 )
+   {
+      return -errno;
+   }
+   cf->map_size = CIRCFIFO_FILE_HDR_SIZE + size;
+   cf->sync_bytes = sync_bytes;
+   if( 0 != fstat(cf->fd, &st) )
+   {
+      ret = -errno;
+      goto err;
+   }
+   if( (0 != st.st_size) && (st.st_size != (off_t)cf->map_size) )
+   {
+      ret = -EINVAL;
+      goto err;
+   }
+   if( (0 == st.st_size) && (0 != ftruncate(cf->fd, cf->map_size)) )
+   {
+      ret = -errno;
+      goto err;
+   }
+   map = mmap(NULL, cf->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, cf->fd, 0);
+   if( MAP_FAILED == map )
+   {
+      ret = -errno;
+      goto err;
+   }
+   cf->hdr = map;
+   cf->buff = (uint8_t*)map + CIRCFIFO_FILE_HDR_SIZE;
+
+   if( 0 == cf->hdr->magic )
+   {
+      /* new file, or crash before the header was initialized */
+      cf->hdr->version = CIRCFIFO_FILE_VERSION;
+      cf->hdr->size = size;
+      cf->hdr->rd = cf->hdr->rd_seq = 0;
+      cf->hdr->wr = cf->hdr->wr_seq = 0;
+      cf->hdr->magic = CIRCFIFO_FILE_MAGIC;
+   }
+   else if( (CIRCFIFO_FILE_MAGIC != cf->hdr->magic) || (CIRCFIFO_FILE_VERSION != cf->hdr->version) ||
+            (size != cf->hdr->size) || (cf->hdr->rd >= size) )
+   {
+      munmap(map, cf->map_size);
+      ret = -EINVAL;
+      goto err;
+   }
+
+   circfifo_file_recover(cf);
+   ret = circfifo_file_sync(cf);
+   if( 0 != ret )
+   {
+      circfifo_file_close(cf);
+   }
+   return ret;
+
+err:
+   close(cf->fd);
+   cf->fd = -1;
+   return ret;
+}
+
+void circfifo_file_close(circfifo_file_t *cf)
+{
+   (void)circfifo_file_sync(cf);
+   munmap(cf->hdr, cf->map_size);
+   close(cf->fd);
+   cf->fd = -1;
+}
+
+bool circfifo_file_put(circfifo_file_t *cf, const void *buff, unsigned len)
+{
+   circfifo_file_hdr_t *hdr = cf->hdr;
+   circfifo_file_rec_t rec;
+   uint32_t wr = hdr->wr;
+   uint32_t rd = __atomic_load_n(&hdr->rd, __ATOMIC_ACQUIRE);
+   uint32_t pos;
+
+   if( (len > UINT16_MAX) ||
+       (circfifo_file_dist(cf, rd, wr) + sizeof(rec) + len >= hdr->size) )
+   {
+      return false;
+   }
+
+   rec.seq = hdr->wr_seq;
+   rec.len = len;
+   pos = circfifo_file_put_at(cf, wr, &rec, sizeof(rec));
+   pos = circfifo_file_put_at(cf, pos, buff, len);
+   rec.crc = circfifo_file_crc(cf, &rec, (wr + sizeof(rec)) % hdr->size);
+   (void)circfifo_file_put_at(cf, (wr + offsetof(circfifo_file_rec_t, crc)) % hdr->size,
+                              &rec.crc, sizeof(rec.crc));
+   hdr->wr_seq++;
+   /* record including its CRC is visible to consumer before the index */
+   __atomic_store_n(&hdr->wr, pos, __ATOMIC_RELEASE);
+
+   if( circfifo_file_dist(cf, cf->synced, pos) >= cf->sync_bytes )
+   {
+      (void)circfifo_file_sync(cf);
+   }
+   return true;
+}
+
+int circfifo_file_get(circfifo_file_t *cf, void *buff, unsigned size)
+{
+   circfifo_file_hdr_t *hdr = cf->hdr;
+   circfifo_file_rec_t rec;
+   uint32_t rd = hdr->rd;
+   uint32_t pos;
+
+   if( rd == __atomic_load_n(&hdr->wr, __ATOMIC_ACQUIRE) )
+   {
+      return -1;
+   }
+   pos = circfifo_file_get_at(cf, rd, &rec, sizeof(rec));
+   if( rec.len <= size )
+   {
+      pos = circfifo_file_get_at(cf, pos, buff, rec.len);
+      hdr->rd_seq++;
+      /* producer can reuse the space only after the record was copied */
+      __atomic_store_n(&hdr->rd, pos, __ATOMIC_RELEASE);
+   }
+   return rec.len;
+}
+
+int circfifo_file_sync(circfifo_file_t *cf)
+{
+   int ret;
+
+   ret = circfifo_file_msync(cf, cf->synced, cf->hdr->wr);
+   /* header last, after the data it refers to */
+   if( (0 == ret) && (0 != msync(cf->hdr, CIRCFIFO_FILE_HDR_SIZE, MS_SYNC)) )
+   {
+      ret = -errno;
+   }
+   if( 0 == ret )
+   {
+      cf->synced = cf->hdr->wr;
+   }
+   return ret;
+}
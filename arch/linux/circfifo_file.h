@@ -0,0 +1,128 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CIRCFIFO_FILE_H_
+#define __CIRCFIFO_FILE_H_ 1
+
+#include "arch.h"
+
+/*
+ * Crash durable record fifo kept in memory mapped file.
+ *
+ * File starts with the header page which holds the read and write indexes,
+ * followed by the data area. Each record is stored with its sequence number,
+ * length and CRC16 (crc16_update() over all of them and the payload), so
+ * records which were not completely written before the crash are detected.
+ *
+ * Writes go to the mapped memory and are flushed with msync() when
+ * sync_bytes of new data were written, or explicitly by circfifo_file_sync().
+ * Indexes stored in the header may be older than the data, so on open the
+ * records are scanned forward from the read index and the write index is
+ * placed after the last valid record. Data is delivered at least once, records
+ * read after the last sync may be read again after the crash.
+ *
+ * One producer and one consumer in the same process, which can be different
+ * threads. Like circfifo_t, each side publishes its index in the header with
+ * release and reads the index of the other side with acquire, there is no
+ * internal locking. circfifo_file_sync() belongs to the producer side.
+ */
+
+#define CIRCFIFO_FILE_MAGIC 0x46494643u /* "CFIF" */
+#define CIRCFIFO_FILE_VERSION 1
+
+/** header stored in the first page of file */
+typedef struct circfifo_file_hdr_tag
+{
+   uint32_t magic;
+   uint32_t version;
+   /** size of data area */
+   uint32_t size;
+   /** index and sequence number of the next record to read */
+   uint32_t rd;
+   uint32_t rd_seq;
+   /** index and sequence number of the next record to write, hint only */
+   uint32_t wr;
+   uint32_t wr_seq;
+} circfifo_file_hdr_t;
+
+/** header of each record in the data area */
+typedef struct circfifo_file_rec_tag
+{
+   uint32_t seq;
+   uint16_t len;
+   uint16_t crc;
+} circfifo_file_rec_t;
+
+typedef struct circfifo_file_tag
+{
+   circfifo_file_hdr_t *hdr;
+   uint8_t *buff;
+   size_t map_size;
+   int fd;
+   /** msync() when this number of bytes was written since last sync */
+   unsigned sync_bytes;
+   /** write index at last sync */
+   uint32_t synced;
+   /** number of records found by recovery on open */
+   unsigned recovered;
+} circfifo_file_t;
+
+/**
+ * Function opens or creates the fifo file, data area has size bytes. Existing
+ * file has to be created with the same size.
+ * \return 0 on success or negative errno
+ */
+int circfifo_file_open(circfifo_file_t *cf, const char *path, unsigned size, unsigned sync_bytes);
+
+/**
+ * Function flushes the data and closes the file
+ */
+void circfifo_file_close(circfifo_file_t *cf);
+
+/**
+ * Function appends the whole record or nothing
+ * \return true if record was written, false if there is not enough space
+ */
+bool circfifo_file_put(circfifo_file_t *cf, const void *buff, unsigned len);
+
+/**
+ * Function reads the next record, record longer than size stays in fifo
+ * \return length of the record or -1 if fifo is empty
+ */
+int circfifo_file_get(circfifo_file_t *cf, void *buff, unsigned size);
+
+/**
+ * Function makes all written records and the read index durable
+ * \return 0 on success or negative errno
+ */
+int circfifo_file_sync(circfifo_file_t *cf);
+
+#endif /* __CIRCFIFO_FILE_H_ */
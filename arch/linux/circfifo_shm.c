@@ -0,0 +1,208 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "circfifo_shm.h"
+
+#define CIRCFIFO_SHM_DATA_OFF cacheline_roundup(sizeof(circfifo_shm_hdr_t))
+
+static int circfifo_shm_map(circfifo_shm_t *cs, int fd, size_t size)
+{
+   void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+   if( MAP_FAILED == map )
+   {
+      return -errno;
+   }
+   cs->hdr = map;
+   cs->map_size = size;
+   return 0;
+}
+
+int circfifo_shm_create(circfifo_shm_t *cs, const char *name, unsigned size)
+{
+   size_t map_size = CIRCFIFO_SHM_DATA_OFF + size;
+   int fd;
+   int ret;
+
+   assert(size >= 2);
+
+   fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+   if( fd < 0 )
+   {
+      return -errno;
+   }
+   ret = (0 == ftruncate(fd, map_size)) ? circfifo_shm_map(cs, fd, map_size) : -errno;
+   close(fd);
+   if( 0 != ret )
+   {
+      shm_unlink(name);
+      return ret;
+   }
+
+   cs->hdr->version = CIRCFIFO_SHM_VERSION;
+   cs->hdr->size = size;
+   cs->hdr->data_off = CIRCFIFO_SHM_DATA_OFF;
+   cs->hdr->wr = 0;
+   cs->hdr->rd = 0;
+   /* header is valid for other processes when they see the magic */
+   __atomic_store_n(&cs->hdr->magic, CIRCFIFO_SHM_MAGIC, __ATOMIC_RELEASE);
+   cs->buff = (uint8_t*)cs->hdr + CIRCFIFO_SHM_DATA_OFF;
+   cs->size = size;
+
+   return 0;
+}
+
+int circfifo_shm_attach(circfifo_shm_t *cs, const char *name)
+{
+   circfifo_shm_hdr_t *hdr;
+   struct stat st;
+   uint32_t size;
+   uint32_t data_off;
+   int fd;
+   int ret;
+
+   fd = shm_open(name, O_RDWR, 0);
+   if( fd < 0 )
+   {
+      return -errno;
+   }
+   if( 0 != fstat(fd, &st) )
+   {
+      ret = -errno;
+   }
+   else if( (size_t)st.st_size < sizeof(circfifo_shm_hdr_t) )
+   {
+      /* creator did not set the size yet */
+      ret = -EINVAL;
+   }
+   else
+   {
+      ret = circfifo_shm_map(cs, fd, st.st_size);
+   }
+   close(fd);
+   if( 0 != ret )
+   {
+      return ret;
+   }
+
+   /* each field is read once, the values checked are the values used */
+   hdr = cs->hdr;
+   if( CIRCFIFO_SHM_MAGIC != __atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) )
+   {
+      circfifo_shm_detach(cs);
+      return -EINVAL;
+   }
+   size = __atomic_load_n(&hdr->size, __ATOMIC_RELAXED);
+   data_off = __atomic_load_n(&hdr->data_off, __ATOMIC_RELAXED);
+   if( (CIRCFIFO_SHM_VERSION != hdr->version) ||
+       (data_off < sizeof(circfifo_shm_hdr_t)) || (size < 2) ||
+       ((size_t)data_off + size > cs->map_size) ||
+       (__atomic_load_n(&hdr->wr, __ATOMIC_RELAXED) >= size) ||
+       (__atomic_load_n(&hdr->rd, __ATOMIC_RELAXED) >= size) )
+   {
+      circfifo_shm_detach(cs);
+      return -EINVAL;
+   }
+   cs->buff = (uint8_t*)hdr + data_off;
+   cs->size = size;
+
+   return 0;
+}
+
+void circfifo_shm_detach(circfifo_shm_t *cs)
+{
+   munmap(cs->hdr, cs->map_size);
+   cs->hdr = NULL;
+   cs->buff = NULL;
+}
+
+int circfifo_shm_unlink(const char *name)
+{
+   return (0 == shm_unlink(name)) ? 0 : -errno;
+}
+
+/* size validated by create or attach is used, header and indexes can be
+ * overwritten by the other process at any time, so each index is loaded once
+ * and fifo with index out of range is treated as empty and full */
+unsigned circfifo_shm_in(circfifo_shm_t *cs, const void *buff, unsigned req_cnt)
+{
+   circfifo_shm_hdr_t *hdr = cs->hdr;
+   uint32_t size = cs->size;
+   uint32_t wr = __atomic_load_n(&hdr->wr, __ATOMIC_RELAXED);
+   uint32_t rd = __atomic_load_n(&hdr->rd, __ATOMIC_ACQUIRE);
+   uint32_t space;
+   uint32_t first;
+
+   if( (wr >= size) || (rd >= size) )
+   {
+      return 0;
+   }
+   space = (rd > wr) ? rd - wr - 1 : size - wr + rd - 1;
+   req_cnt = min(req_cnt, space);
+   first = min(req_cnt, size - wr);
+   memcpy(&cs->buff[wr], buff, first);
+   memcpy(cs->buff, (const uint8_t*)buff + first, req_cnt - first);
+   wr += req_cnt;
+   wr -= (wr >= size) ? size : 0;
+   __atomic_store_n(&hdr->wr, wr, __ATOMIC_RELEASE);
+
+   return req_cnt;
+}
+
+unsigned circfifo_shm_out(circfifo_shm_t *cs, void *buff, unsigned req_cnt)
+{
+   circfifo_shm_hdr_t *hdr = cs->hdr;
+   uint32_t size = cs->size;
+   uint32_t rd = __atomic_load_n(&hdr->rd, __ATOMIC_RELAXED);
+   uint32_t wr = __atomic_load_n(&hdr->wr, __ATOMIC_ACQUIRE);
+   uint32_t avail;
+   uint32_t first;
+
+   if( (wr >= size) || (rd >= size) )
+   {
+      return 0;
+   }
+   avail = (wr >= rd) ? wr - rd : size - rd + wr;
+   req_cnt = min(req_cnt, avail);
+   first = min(req_cnt, size - rd);
+   memcpy(buff, &cs->buff[rd], first);
+   memcpy((uint8_t*)buff + first, cs->buff, req_cnt - first);
+   rd += req_cnt;
+   rd -= (rd >= size) ? size : 0;
+   __atomic_store_n(&hdr->rd, rd, __ATOMIC_RELEASE);
+
+   return req_cnt;
+}
@@ -0,0 +1,115 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CIRCFIFO_SHM_H_
+#define __CIRCFIFO_SHM_H_ 1
+
+#include "arch.h"
+#include "gmacros.h"
+
+/*
+ * Byte fifo placed in POSIX shared memory, for streaming between processes
+ * without system calls on the data path.
+ *
+ * Shared memory object starts with the header, the data area is found by
+ * offset stored in the header, so processes can map it at any address.
+ * Process which attaches validates magic, version and sizes against the size
+ * of the object. Single producer and single consumer, indexes are published
+ * with release stores and read with acquire loads, each in its own cache line.
+ * The other process is not trusted, the size is taken from the header only
+ * once and indexes out of range stop the transfer instead of letting memcpy
+ * go outside of the mapping.
+ */
+
+#define CIRCFIFO_SHM_MAGIC 0x4D485343u /* "CSHM" */
+#define CIRCFIFO_SHM_VERSION 1
+
+typedef struct circfifo_shm_hdr_tag
+{
+   /** written last by creator, with release */
+   uint32_t magic;
+   uint32_t version;
+   /** size of data area */
+   uint32_t size;
+   /** offset of data area from the begining of header */
+   uint32_t data_off;
+   /** index where to write next, written only by producer */
+   uint32_t wr cacheline_aligned;
+   /** index from where to read next, written only by consumer */
+   uint32_t rd cacheline_aligned;
+} circfifo_shm_hdr_t;
+
+/** process local handle */
+typedef struct circfifo_shm_tag
+{
+   circfifo_shm_hdr_t *hdr;
+   uint8_t *buff;
+   size_t map_size;
+   /** size of data area validated when mapped, hdr->size is not trusted */
+   uint32_t size;
+} circfifo_shm_t;
+
+/**
+ * Function creates new shared memory object with data area of size bytes
+ * \return 0 on success or negative errno (-EEXIST if object exists)
+ */
+int circfifo_shm_create(circfifo_shm_t *cs, const char *name, unsigned size);
+
+/**
+ * Function attaches to existing object
+ * \return 0 on success, -EINVAL if header does not match or negative errno
+ */
+int circfifo_shm_attach(circfifo_shm_t *cs, const char *name);
+
+/**
+ * Function unmaps the object, it still exists until circfifo_shm_unlink()
+ */
+void circfifo_shm_detach(circfifo_shm_t *cs);
+
+/**
+ * Function removes the name of the object
+ * \return 0 on success or negative errno
+ */
+int circfifo_shm_unlink(const char *name);
+
+/**
+ * Function writes bytes into fifo, to be called by producer
+ * \return Number of bytes written, 0 also if an index in header is corrupted
+ */
+unsigned circfifo_shm_in(circfifo_shm_t *cs, const void *buff, unsigned req_cnt);
+
+/**
+ * Function reads bytes from fifo, to be called by consumer
+ * \return Number of bytes read, 0 also if an index in header is corrupted
+ */
+unsigned circfifo_shm_out(circfifo_shm_t *cs, void *buff, unsigned req_cnt);
+
+#endif /* __CIRCFIFO_SHM_H_ */
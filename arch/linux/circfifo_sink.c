@@ -0,0 +1,547 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE /* for O_DIRECT */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "gmacros.h"
+#include "circfifo_sink.h"
+
+/* liburing is not a dependency, ring is driven by the syscalls directly */
+static int io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+   return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                          unsigned flags)
+{
+   return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                       NULL, 0);
+}
+
+static int io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+   return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* kernels 5.1 - 5.5 have io_uring without IORING_OP_WRITE, every write would
+ * fail with -EINVAL. The probe came in 5.6 together with IORING_OP_WRITE, so
+ * failed probe means the same as missing io_uring. */
+static bool circfifo_sink_uring_probe(int fd)
+{
+   struct {
+      struct io_uring_probe hdr;
+      struct io_uring_probe_op ops[IORING_OP_WRITE + 1];
+   } probe;
+
+   memset(&probe, 0, sizeof(probe));
+   if( io_uring_register(fd, IORING_REGISTER_PROBE, &probe, IORING_OP_WRITE + 1) < 0 )
+   {
+      return false;
+   }
+   return (probe.hdr.ops_len > IORING_OP_WRITE) &&
+          (probe.ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+}
+
+/* writes whole slot synchronously, continues after short write of res bytes */
+static int circfifo_sink_pwrite(int fd, const uint8_t *ptr, unsigned len,
+                                off_t offset, unsigned done)
+{
+   while( done < len )
+   {
+      ssize_t ret = pwrite(fd, ptr + done, len - done, offset + done);
+
+      if( ret < 0 )
+      {
+         if( EINTR == errno )
+         {
+            continue;
+         }
+         return -errno;
+      }
+      if( 0 == ret )
+      {
+         return -EIO;
+      }
+      done += ret;
+   }
+   return len;
+}
+
+static void* circfifo_sink_worker(void *arg)
+{
+   circfifo_sink_t *sink = arg;
+   circfifo_sink_slot_t *slot;
+   int res;
+
+   pthread_mutex_lock(&sink->lock);
+   for( ;; )
+   {
+      if( sink->job_seq == sink->submit_seq )
+      {
+         if( sink->stop )
+         {
+            break;
+         }
+         pthread_cond_wait(&sink->cond, &sink->lock);
+         continue;
+      }
+      slot = &sink->slots[sink->job_seq % sink->depth];
+      sink->job_seq++;
+      pthread_mutex_unlock(&sink->lock);
+
+      res = circfifo_sink_pwrite(sink->fd, slot->ptr, slot->len, slot->offset, 0);
+
+      pthread_mutex_lock(&sink->lock);
+      slot->res = res;
+      slot->done = true;
+      pthread_cond_broadcast(&sink->cond);
+   }
+   pthread_mutex_unlock(&sink->lock);
+
+   return NULL;
+}
+
+static int circfifo_sink_uring_init(circfifo_sink_t *sink)
+{
+   struct io_uring_params p;
+   uint8_t *sq;
+   uint8_t *cq;
+   int fd;
+
+   memset(&p, 0, sizeof(p));
+   fd = io_uring_setup(sink->depth, &p);
+   if( fd < 0 )
+   {
+      return -errno;
+   }
+   if( !circfifo_sink_uring_probe(fd) )
+   {
+      close(fd);
+      return -EOPNOTSUPP;
+   }
+
+   sink->sq_map_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+   sink->cq_map_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+   if( p.features & IORING_FEAT_SINGLE_MMAP )
+   {
+      sink->sq_map_size = max(sink->sq_map_size, sink->cq_map_size);
+      sink->cq_map_size = 0;
+   }
+   sq = mmap(NULL, sink->sq_map_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+   if( MAP_FAILED == sq )
+   {
+      goto err_close;
+   }
+   cq = sq;
+   if( 0 != sink->cq_map_size )
+   {
+      cq = mmap(NULL, sink->cq_map_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if( MAP_FAILED == cq )
+      {
+         goto err_sq;
+      }
+   }
+   sink->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+                     PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                     IORING_OFF_SQES);
+   if( MAP_FAILED == sink->sqes )
+   {
+      goto err_cq;
+   }
+
+   sink->sq_map = sq;
+   sink->cq_map = cq;
+   sink->sq_head = (unsigned*)(sq + p.sq_off.head);
+   sink->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+   sink->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+   sink->sq_array = (unsigned*)(sq + p.sq_off.array);
+   sink->cq_head = (unsigned*)(cq + p.cq_off.head);
+   sink->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+   sink->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+   sink->cqes = cq + p.cq_off.cqes;
+   sink->ring_fd = fd;
+   return 0;
+
+err_cq:
+   if( 0 != sink->cq_map_size )
+   {
+      munmap(cq, sink->cq_map_size);
+   }
+err_sq:
+   munmap(sq, sink->sq_map_size);
+err_close:
+   close(fd);
+   return -ENOMEM;
+}
+
+static int circfifo_sink_threads_init(circfifo_sink_t *sink)
+{
+   unsigned i;
+
+   pthread_mutex_init(&sink->lock, NULL);
+   pthread_cond_init(&sink->cond, NULL);
+   for( i = 0; i < CIRCFIFO_SINK_THREADS_NUM; i++ )
+   {
+      if( 0 != pthread_create(&sink->threads[i], NULL, circfifo_sink_worker, sink) )
+      {
+         break;
+      }
+   }
+   sink->threads_cnt = i;
+   return (0 == i) ? -EAGAIN : 0;
+}
+
+int circfifo_sink_init(circfifo_sink_t *sink, circfifo_t *fifo, int fd,
+                       unsigned depth, unsigned chunk, unsigned flags)
+{
+   /* slots are indexed by 32 bit sequence numbers modulo depth, what stays
+    * continuous over the wrap of sequence only for power of two */
+   assert((depth > 0) && (depth <= CIRCFIFO_SINK_DEPTH_MAX) && (0 == (depth & (depth - 1))));
+   assert(chunk > 0);
+
+   memset(sink, 0, sizeof(*sink));
+   sink->fifo = fifo;
+   sink->fd = fd;
+   sink->depth = depth;
+   sink->chunk = chunk;
+   sink->flags = flags;
+   sink->ring_fd = -1;
+
+   sink->offset = lseek(fd, 0, SEEK_CUR);
+   if( sink->offset < 0 )
+   {
+      return -errno;
+   }
+   if( (flags & CIRCFIFO_SINK_DIRECT) &&
+       ((0 != (uintptr_t)fifo->buff % CIRCFIFO_SINK_ALIGN) ||
+        (0 != chunk % CIRCFIFO_SINK_ALIGN) || (0 != fifo->size % chunk) ||
+        (0 != fifo->rd % chunk) ||
+        (0 != sink->offset % CIRCFIFO_SINK_ALIGN)) )
+   {
+      return -EINVAL;
+   }
+
+   if( (0 == (flags & CIRCFIFO_SINK_THREADS)) && (0 == circfifo_sink_uring_init(sink)) )
+   {
+      return 0;
+   }
+   return circfifo_sink_threads_init(sink);
+}
+
+/* queues one write, slot is already filled */
+static void circfifo_sink_uring_queue(circfifo_sink_t *sink, unsigned seq)
+{
+   circfifo_sink_slot_t *slot = &sink->slots[seq % sink->depth];
+   unsigned tail = *sink->sq_tail;
+   unsigned idx = tail & *sink->sq_mask;
+   struct io_uring_sqe *sqe = &((struct io_uring_sqe*)sink->sqes)[idx];
+
+   memset(sqe, 0, sizeof(*sqe));
+   sqe->opcode = IORING_OP_WRITE;
+   sqe->fd = sink->fd;
+   sqe->off = slot->offset;
+   sqe->addr = (uintptr_t)slot->ptr;
+   sqe->len = slot->len;
+   sqe->user_data = seq;
+   sink->sq_array[idx] = idx;
+   /* kernel reads the entry after it sees the tail */
+   __atomic_store_n(sink->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static void circfifo_sink_uring_reap(circfifo_sink_t *sink)
+{
+   unsigned head = *sink->cq_head;
+   unsigned tail = __atomic_load_n(sink->cq_tail, __ATOMIC_ACQUIRE);
+
+   for( ; head != tail; head++ )
+   {
+      struct io_uring_cqe *cqe =
+         &((struct io_uring_cqe*)sink->cqes)[head & *sink->cq_mask];
+      circfifo_sink_slot_t *slot = &sink->slots[cqe->user_data % sink->depth];
+
+      slot->res = cqe->res;
+      slot->done = true;
+      sink->reaped++;
+   }
+   __atomic_store_n(sink->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* creates writes for new data in fifo, returns number of queued writes */
+static unsigned circfifo_sink_fill(circfifo_sink_t *sink)
+{
+   circfifo_t *fifo = sink->fifo;
+   int wr = __atomic_load_n(&fifo->wr, __ATOMIC_ACQUIRE);
+   int pos = fifo->rd + sink->inflight;
+   unsigned queued = 0;
+   unsigned avail;
+   unsigned len;
+
+   pos -= (pos >= fifo->size) ? fifo->size : 0;
+   avail = ((wr >= pos) ? wr : wr + fifo->size) - pos;
+   while( (0 != avail) && (sink->submit_seq - sink->retire_seq < sink->depth) )
+   {
+      circfifo_sink_slot_t *slot = &sink->slots[sink->submit_seq % sink->depth];
+
+      len = min(min(avail, sink->chunk), (unsigned)(fifo->size - pos));
+      if( (sink->flags & CIRCFIFO_SINK_DIRECT) && (len != sink->chunk) )
+      {
+         /* partial chunk waits for more data or for the flush */
+         break;
+      }
+      slot->offset = sink->offset;
+      slot->ptr = &fifo->buff[pos];
+      slot->len = len;
+      slot->res = 0;
+      slot->done = false;
+
+      if( circfifo_sink_uring(sink) )
+      {
+         circfifo_sink_uring_queue(sink, sink->submit_seq);
+         sink->submit_seq++;
+      }
+      else
+      {
+         pthread_mutex_lock(&sink->lock);
+         sink->submit_seq++;
+         pthread_cond_broadcast(&sink->cond);
+         pthread_mutex_unlock(&sink->lock);
+      }
+      sink->offset += len;
+      sink->inflight += len;
+      avail -= len;
+      pos += len;
+      pos -= (pos == fifo->size) ? fifo->size : 0;
+      queued++;
+   }
+
+   return queued;
+}
+
+/* moves fifo read index over completed writes, in order */
+static int circfifo_sink_retire(circfifo_sink_t *sink)
+{
+   circfifo_t *fifo = sink->fifo;
+   int retired = 0;
+
+   if( circfifo_sink_uring(sink) )
+   {
+      circfifo_sink_uring_reap(sink);
+   }
+   else
+   {
+      pthread_mutex_lock(&sink->lock);
+   }
+   while( sink->retire_seq != sink->submit_seq )
+   {
+      circfifo_sink_slot_t *slot = &sink->slots[sink->retire_seq % sink->depth];
+      int rd;
+
+      if( !slot->done )
+      {
+         break;
+      }
+      if( (slot->res >= 0) && ((unsigned)slot->res < slot->len) )
+      {
+         /* short write, rest is written synchronously */
+         slot->res = circfifo_sink_pwrite(sink->fd, slot->ptr, slot->len,
+                                          slot->offset, slot->res);
+      }
+      if( slot->res < 0 )
+      {
+         sink->error = slot->res;
+         break;
+      }
+      rd = fifo->rd + slot->len;
+      rd -= (rd >= fifo->size) ? fifo->size : 0;
+      /* producer may reuse the space after it sees the new index */
+      __atomic_store_n(&fifo->rd, rd, __ATOMIC_RELEASE);
+      sink->inflight -= slot->len;
+      retired += slot->len;
+      sink->retire_seq++;
+   }
+   if( !circfifo_sink_uring(sink) )
+   {
+      pthread_mutex_unlock(&sink->lock);
+   }
+
+   return retired;
+}
+
+int circfifo_sink_poll(circfifo_sink_t *sink)
+{
+   unsigned queued;
+   int retired;
+
+   if( 0 != sink->error )
+   {
+      return sink->error;
+   }
+   queued = circfifo_sink_fill(sink);
+   if( circfifo_sink_uring(sink) && (0 != queued) &&
+       (io_uring_enter(sink->ring_fd, queued, 0, 0) < 0) )
+   {
+      /* entries stay in the ring, they are submitted by the next enter */
+      if( (EAGAIN != errno) && (EBUSY != errno) && (EINTR != errno) )
+      {
+         sink->error = -errno;
+      }
+   }
+   retired = circfifo_sink_retire(sink);
+
+   return (0 != sink->error) ? sink->error : retired;
+}
+
+/* blocks until the oldest write in flight completes or the sink fails */
+static void circfifo_sink_wait(circfifo_sink_t *sink)
+{
+   circfifo_sink_slot_t *slot = &sink->slots[sink->retire_seq % sink->depth];
+
+   if( circfifo_sink_uring(sink) )
+   {
+      circfifo_sink_uring_reap(sink);
+      while( !slot->done && (0 == sink->error) )
+      {
+         /* submits also entries left in the ring by failed enter */
+         unsigned pending = *sink->sq_tail - __atomic_load_n(sink->sq_head, __ATOMIC_ACQUIRE);
+
+         if( (io_uring_enter(sink->ring_fd, pending, 1, IORING_ENTER_GETEVENTS) < 0) &&
+             (EINTR != errno) && (EAGAIN != errno) && (EBUSY != errno) )
+         {
+            sink->error = -errno;
+         }
+         circfifo_sink_uring_reap(sink);
+      }
+      return;
+   }
+   pthread_mutex_lock(&sink->lock);
+   while( !slot->done )
+   {
+      pthread_cond_wait(&sink->cond, &sink->lock);
+   }
+   pthread_mutex_unlock(&sink->lock);
+}
+
+int circfifo_sink_flush(circfifo_sink_t *sink)
+{
+   int ret;
+
+   for( ;; )
+   {
+      ret = circfifo_sink_poll(sink);
+      if( ret < 0 )
+      {
+         return ret;
+      }
+      if( sink->retire_seq != sink->submit_seq )
+      {
+         if( 0 == ret )
+         {
+            circfifo_sink_wait(sink);
+         }
+         continue;
+      }
+      if( 0 == circfifo_count(sink->fifo) )
+      {
+         return 0;
+      }
+      if( 0 == (sink->flags & CIRCFIFO_SINK_DIRECT) )
+      {
+         /* producer added data after the last poll */
+         continue;
+      }
+      /* only unaligned tail is left, which O_DIRECT cannot write, the stream
+         is not aligned anymore so the sink continues without O_DIRECT */
+      ret = fcntl(sink->fd, F_GETFL);
+      if( (ret < 0) || (fcntl(sink->fd, F_SETFL, ret & ~O_DIRECT) < 0) )
+      {
+         sink->error = -errno;
+         return sink->error;
+      }
+      sink->flags &= ~CIRCFIFO_SINK_DIRECT;
+   }
+}
+
+void circfifo_sink_destroy(circfifo_sink_t *sink)
+{
+   unsigned i;
+
+   /* data of writes which were not retired stays in the fifo */
+   while( (sink->retire_seq != sink->submit_seq) && (0 == sink->error) )
+   {
+      circfifo_sink_wait(sink);
+      sink->retire_seq++;
+   }
+
+   if( circfifo_sink_uring(sink) )
+   {
+      /* after an error the writes which kernel already took from the ring may
+       * still read the fifo buffer, each of them posts one completion */
+      circfifo_sink_uring_reap(sink);
+      while( sink->reaped != __atomic_load_n(sink->sq_head, __ATOMIC_ACQUIRE) )
+      {
+         if( (io_uring_enter(sink->ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0) &&
+             (EINTR != errno) && (EAGAIN != errno) && (EBUSY != errno) )
+         {
+            break;
+         }
+         circfifo_sink_uring_reap(sink);
+      }
+      munmap(sink->sqes, (*sink->sq_mask + 1) * sizeof(struct io_uring_sqe));
+      if( 0 != sink->cq_map_size )
+      {
+         munmap(sink->cq_map, sink->cq_map_size);
+      }
+      munmap(sink->sq_map, sink->sq_map_size);
+      close(sink->ring_fd);
+      sink->ring_fd = -1;
+      return;
+   }
+
+   pthread_mutex_lock(&sink->lock);
+   sink->stop = true;
+   pthread_cond_broadcast(&sink->cond);
+   pthread_mutex_unlock(&sink->lock);
+   for( i = 0; i < sink->threads_cnt; i++ )
+   {
+      pthread_join(sink->threads[i], NULL);
+   }
+   pthread_mutex_destroy(&sink->lock);
+   pthread_cond_destroy(&sink->cond);
+}
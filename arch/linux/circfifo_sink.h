@@ -0,0 +1,163 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CIRCFIFO_SINK_H_
+#define __CIRCFIFO_SINK_H_ 1
+
+#include <pthread.h>
+#include <sys/types.h>
+#include "arch.h"
+#include "circfifo.h"
+
+/*
+ * Asynchronous sink which drains circfifo_t into file.
+ *
+ * circfifo_sink_poll() submits the readable regions of the fifo as writes at
+ * consecutive file offsets, keeps up to depth of them in flight and moves the
+ * read index of the fifo only when the writes complete (in order), so data
+ * stays in the fifo buffer until it is in the file and the consumer never
+ * waits for the storage. Writes are submitted with io_uring, or executed by
+ * pool of threads if io_uring is not available, lacks IORING_OP_WRITE (kernels
+ * before 5.6) or CIRCFIFO_SINK_THREADS is given.
+ *
+ * With CIRCFIFO_SINK_DIRECT the file has to be opened with O_DIRECT, fifo
+ * buffer and file offset have to be aligned to CIRCFIFO_SINK_ALIGN, fifo size
+ * and read index have to be multiples of chunk. Only whole chunks are
+ * submitted. Shorter tail is written by circfifo_sink_flush() after it clears
+ * O_DIRECT of the file, the stream is not aligned after that so the sink
+ * continues without O_DIRECT.
+ *
+ * The sink is the consumer of the fifo, producer uses circfifo_in() as usual,
+ * also from other thread. All sink functions have to be called by the same
+ * (consumer) thread.
+ */
+
+/** file is opened with O_DIRECT */
+#define CIRCFIFO_SINK_DIRECT 1
+/** do not use io_uring */
+#define CIRCFIFO_SINK_THREADS 2
+
+/** alignment of buffers, offsets and lengths for O_DIRECT */
+#define CIRCFIFO_SINK_ALIGN 4096
+/** maximal writes in flight */
+#define CIRCFIFO_SINK_DEPTH_MAX 64
+/** number of writer threads of fallback */
+#define CIRCFIFO_SINK_THREADS_NUM 4
+
+typedef struct circfifo_sink_slot_tag
+{
+   off_t offset;
+   const uint8_t *ptr;
+   unsigned len;
+   int res;
+   bool done;
+} circfifo_sink_slot_t;
+
+typedef struct circfifo_sink_tag
+{
+   circfifo_t *fifo;
+   int fd;
+   unsigned flags;
+   unsigned depth;
+   unsigned chunk;
+   /** file offset of next submitted write */
+   off_t offset;
+   /** bytes after fifo read index which are submitted */
+   unsigned inflight;
+   /** sequence numbers of oldest not retired and next submitted write */
+   unsigned retire_seq;
+   unsigned submit_seq;
+   circfifo_sink_slot_t slots[CIRCFIFO_SINK_DEPTH_MAX];
+   /** first error, sink stops when it is set */
+   int error;
+
+   /** io_uring, ring_fd < 0 if not used */
+   int ring_fd;
+   void *sq_map;
+   void *cq_map;
+   size_t sq_map_size;
+   size_t cq_map_size;
+   void *sqes;
+   unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+   unsigned *cq_head, *cq_tail, *cq_mask;
+   void *cqes;
+   /** completions taken from the ring */
+   unsigned reaped;
+
+   /** thread pool fallback */
+   pthread_t threads[CIRCFIFO_SINK_THREADS_NUM];
+   unsigned threads_cnt;
+   pthread_mutex_t lock;
+   pthread_cond_t cond;
+   /** next slot to be taken by a thread */
+   unsigned job_seq;
+   bool stop;
+} circfifo_sink_t;
+
+/**
+ * Function initializes the sink which writes the data from fifo into fd,
+ * starting at its current offset
+ * \param depth maximal number of writes in flight, power of two up to
+ *        CIRCFIFO_SINK_DEPTH_MAX
+ * \param chunk maximal length of one write
+ * \param flags CIRCFIFO_SINK_DIRECT, CIRCFIFO_SINK_THREADS
+ * \return 0 on success or negative errno
+ */
+int circfifo_sink_init(circfifo_sink_t *sink, circfifo_t *fifo, int fd,
+                       unsigned depth, unsigned chunk, unsigned flags);
+
+/**
+ * Function submits new data and retires completed writes, it does not block
+ * \return number of bytes removed from fifo or negative errno of failed write
+ */
+int circfifo_sink_poll(circfifo_sink_t *sink);
+
+/**
+ * Function writes all data which is in the fifo and waits for completion
+ * \return 0 on success or negative errno
+ */
+int circfifo_sink_flush(circfifo_sink_t *sink);
+
+/**
+ * Function waits for writes in flight, also after the sink failed, and
+ * releases resources, it does not close fd
+ */
+void circfifo_sink_destroy(circfifo_sink_t *sink);
+
+/**
+ * \return true if io_uring is used
+ */
+static inline bool circfifo_sink_uring(const circfifo_sink_t *sink)
+{
+   return sink->ring_fd >= 0;
+}
+
+#endif /* __CIRCFIFO_SINK_H_ */
@@ -0,0 +1,103 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "arch.h"
+#include "circfifo.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+/*
+ * Byte search for circfifo_find(), vector is compared with the broadcast byte
+ * and the first set bit of movemask gives the position of the match. Loads are
+ * unaligned and never cross the end of the segment, remainder is scanned with
+ * narrower vectors and then byte by byte.
+ */
+
+__attribute__((target("sse2")))
+const uint8_t* circfifo_scan_sse2(const uint8_t *buff, unsigned size, uint8_t byte)
+{
+   const __m128i pattern = _mm_set1_epi8((char)byte);
+   unsigned mask;
+
+   while( size >= 16 )
+   {
+      mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)buff), pattern));
+      if( 0 != mask )
+      {
+         return buff + __builtin_ctz(mask);
+      }
+      buff += 16;
+      size -= 16;
+   }
+
+   return circfifo_scan_scalar(buff, size, byte);
+}
+
+__attribute__((target("avx2")))
+const uint8_t* circfifo_scan_avx2(const uint8_t *buff, unsigned size, uint8_t byte)
+{
+   const __m256i pattern = _mm256_set1_epi8((char)byte);
+   unsigned mask;
+
+   while( size >= 64 )
+   {
+      __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)buff), pattern);
+      __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(buff + 32)), pattern);
+
+      if( !_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b)) )
+      {
+         mask = _mm256_movemask_epi8(a);
+         if( 0 != mask )
+         {
+            return buff + __builtin_ctz(mask);
+         }
+         return buff + 32 + __builtin_ctz((unsigned)_mm256_movemask_epi8(b));
+      }
+      buff += 64;
+      size -= 64;
+   }
+   if( size >= 32 )
+   {
+      mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)buff), pattern));
+      if( 0 != mask )
+      {
+         return buff + __builtin_ctz(mask);
+      }
+      buff += 32;
+      size -= 32;
+   }
+
+   return circfifo_scan_sse2(buff, size, byte);
+}
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "arch.h"
+#include "crc.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+/*
+ * CRC16 folding with carry-less multiplication, based on Intel's "Fast CRC
+ * Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+ *
+ * 16 byte block T loaded from memory is, in bit reflected order, the
+ * polynomial T_lo(x) * x^64 + T_hi(x) where T_lo is the lower qword. Moving it
+ * forward by D bits modulo P(x) is
+ *    T_lo(x) * (x^(D+64) mod P) + T_hi(x) * (x^D mod P)
+ * what fits in 80 bits. Product of two reflected 64 bit values is shifted by
+ * one bit, so constants are x^(D+63) mod P and x^(D-1) mod P. After folding,
+ * the remaining 16 bytes have the same CRC as the whole folded part of the
+ * message and are finished with table driven code.
+ * Constants below are generated by reducing x^n modulo P(x) = 0x18005 and
+ * reflecting the 16 bit result into the top bits of 64 bit value.
+ */
+
+/* {x^(D+63) mod P, x^(D-1) mod P} for D = 128 and D = 512 */
+#define CRC16_FOLD128 _mm_set_epi64x((long long)0xC100000000000000ull, (long long)0xCCD0000000000000ull)
+#define CRC16_FOLD512 _mm_set_epi64x((long long)0x8101000000000000ull, (long long)0xC450000000000000ull)
+
+__attribute__((target("sse2,pclmul")))
+static inline __m128i crc16_fold(__m128i t, __m128i k)
+{
+   return _mm_xor_si128(_mm_clmulepi64_si128(t, k, 0x00),
+                        _mm_clmulepi64_si128(t, k, 0x11));
+}
+
+__attribute__((target("sse2,pclmul")))
+uint16_t crc16_update_pclmul(uint16_t crc, const void* buff, unsigned size)
+{
+   const uint8_t *p = buff;
+   const __m128i fold128 = CRC16_FOLD128;
+   const __m128i fold512 = CRC16_FOLD512;
+   __m128i a0, a1, a2, a3;
+   uint8_t folded[16];
+
+   if( size < 64 )
+   {
+      return crc16_update_slice8(crc, buff, size);
+   }
+   /* initial crc is equal to xor of first two bytes of message */
+   a0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + 0)), _mm_cvtsi32_si128(crc));
+   a1 = _mm_loadu_si128((const __m128i*)(p + 16));
+   a2 = _mm_loadu_si128((const __m128i*)(p + 32));
+   a3 = _mm_loadu_si128((const __m128i*)(p + 48));
+   p += 64;
+   size -= 64;
+
+   while( size >= 64 )
+   {
+      a0 = _mm_xor_si128(crc16_fold(a0, fold512), _mm_loadu_si128((const __m128i*)(p + 0)));
+      a1 = _mm_xor_si128(crc16_fold(a1, fold512), _mm_loadu_si128((const __m128i*)(p + 16)));
+      a2 = _mm_xor_si128(crc16_fold(a2, fold512), _mm_loadu_si128((const __m128i*)(p + 32)));
+      a3 = _mm_xor_si128(crc16_fold(a3, fold512), _mm_loadu_si128((const __m128i*)(p + 48)));
+      p += 64;
+      size -= 64;
+   }
+
+   a0 = _mm_xor_si128(crc16_fold(a0, fold128), a1);
+   a0 = _mm_xor_si128(crc16_fold(a0, fold128), a2);
+   a0 = _mm_xor_si128(crc16_fold(a0, fold128), a3);
+   while( size >= 16 )
+   {
+      a0 = _mm_xor_si128(crc16_fold(a0, fold128), _mm_loadu_si128((const __m128i*)p));
+      p += 16;
+      size -= 16;
+   }
+
+   _mm_storeu_si128((__m128i*)folded, a0);
+   crc = crc16_update_slice8(0, folded, sizeof(folded));
+   return crc16_update_slice8(crc, p, size);
+}
+
+/*
+ * Multi buffer CRC16, one message per lane.
+ *
+ * Lanes cannot share the table lookups of slicing or the folding, instead the
+ * low and high bytes of CRC of all lanes are kept in two byte vectors and each
+ * lane is advanced by one byte with
+ *    x = lo ^ byte, lo = hi ^ T[x] & 0xFF, hi = T[x] >> 8
+ * where the 256 entry table is split by linearity into two 16 entry tables of
+ * the low and high nibble, T[x] = A[x & 0xF] ^ B[x >> 4], so each lookup is
+ * a byte shuffle. Bytes of messages come from 16 x 16 byte transpositions,
+ * byte i of all lanes is in one vector.
+ */
+#define CRC16_A_LO _mm_setr_epi8(0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, \
+                                 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40)
+#define CRC16_A_HI _mm_setr_epi8(0x00, 0xC0, 0xC1, 0x01, 0xC3, 0x03, 0x02, 0xC2, \
+                                 0xC6, 0x06, 0x07, 0xC7, 0x05, 0xC5, 0xC4, 0x04)
+#define CRC16_B_LO _mm_setr_epi8(0x00, 0x01, 0x01, 0x00, 0x01, 0x00, 0x00, 0x01, \
+                                 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x01, 0x00)
+#define CRC16_B_HI _mm_setr_epi8(0x00, 0xCC, 0xD8, 0x14, 0xF0, 0x3C, 0x28, 0xE4, \
+                                 0xA0, 0x6C, 0x78, 0xB4, 0x50, 0x9C, 0x88, 0x44)
+
+/* perfect shuffle of rows i and i + 8, four rounds transpose 16 x 16 bytes
+   in each 128 bit part of vectors */
+#define CRC16_TRANSPOSE_ROUND(r, t, unpacklo, unpackhi) \
+   do { \
+      unsigned _i; \
+      for( _i = 0; _i < 8; _i++ ) \
+      { \
+         t[2 * _i] = unpacklo(r[_i], r[_i + 8]); \
+         t[2 * _i + 1] = unpackhi(r[_i], r[_i + 8]); \
+      } \
+   } while( 0 )
+
+/* 32 lanes, bytes of lanes 0 - 15 in lower and 16 - 31 in upper half */
+__attribute__((target("avx2")))
+static void crc16_multi_kernel_avx2(const uint8_t *const *ptr, uint8_t *crc_lo,
+                                    uint8_t *crc_hi, unsigned blocks)
+{
+   const __m256i a_lo = _mm256_broadcastsi128_si256(CRC16_A_LO);
+   const __m256i a_hi = _mm256_broadcastsi128_si256(CRC16_A_HI);
+   const __m256i b_lo = _mm256_broadcastsi128_si256(CRC16_B_LO);
+   const __m256i b_hi = _mm256_broadcastsi128_si256(CRC16_B_HI);
+   const __m256i mask = _mm256_set1_epi8(0x0F);
+   __m256i lo = _mm256_loadu_si256((const __m256i*)crc_lo);
+   __m256i hi = _mm256_loadu_si256((const __m256i*)crc_hi);
+   __m256i r[16];
+   __m256i t[16];
+   unsigned b, i;
+
+   for( b = 0; b < blocks; b++ )
+   {
+      for( i = 0; i < 16; i++ )
+      {
+         r[i] = _mm256_loadu2_m128i((const __m128i*)(ptr[i + 16] + b * 16),
+                                    (const __m128i*)(ptr[i] + b * 16));
+      }
+      CRC16_TRANSPOSE_ROUND(r, t, _mm256_unpacklo_epi8, _mm256_unpackhi_epi8);
+      CRC16_TRANSPOSE_ROUND(t, r, _mm256_unpacklo_epi8, _mm256_unpackhi_epi8);
+      CRC16_TRANSPOSE_ROUND(r, t, _mm256_unpacklo_epi8, _mm256_unpackhi_epi8);
+      CRC16_TRANSPOSE_ROUND(t, r, _mm256_unpacklo_epi8, _mm256_unpackhi_epi8);
+      for( i = 0; i < 16; i++ )
+      {
+         __m256i x = _mm256_xor_si256(lo, r[i]);
+         __m256i xl = _mm256_and_si256(x, mask);
+         __m256i xh = _mm256_and_si256(_mm256_srli_epi16(x, 4), mask);
+
+         lo = _mm256_xor_si256(_mm256_xor_si256(hi, _mm256_shuffle_epi8(a_lo, xl)),
+                               _mm256_shuffle_epi8(b_lo, xh));
+         hi = _mm256_xor_si256(_mm256_shuffle_epi8(a_hi, xl), _mm256_shuffle_epi8(b_hi, xh));
+      }
+   }
+   _mm256_storeu_si256((__m256i*)crc_lo, lo);
+   _mm256_storeu_si256((__m256i*)crc_hi, hi);
+}
+
+void crc16_update_multi_avx2(crc16_job_t *jobs, unsigned cnt)
+{
+   crc16_update_multi_lanes(jobs, cnt, 32, crc16_multi_kernel_avx2);
+}
+
+/* 64 lanes, quarter q of vector holds bytes of lanes 16 * q - 16 * q + 15 */
+__attribute__((target("avx512f,avx512bw")))
+static void crc16_multi_kernel_avx512(const uint8_t *const *ptr, uint8_t *crc_lo,
+                                      uint8_t *crc_hi, unsigned blocks)
+{
+   const __m512i a_lo = _mm512_broadcast_i32x4(CRC16_A_LO);
+   const __m512i a_hi = _mm512_broadcast_i32x4(CRC16_A_HI);
+   const __m512i b_lo = _mm512_broadcast_i32x4(CRC16_B_LO);
+   const __m512i b_hi = _mm512_broadcast_i32x4(CRC16_B_HI);
+   const __m512i mask = _mm512_set1_epi8(0x0F);
+   __m512i lo = _mm512_loadu_si512(crc_lo);
+   __m512i hi = _mm512_loadu_si512(crc_hi);
+   __m512i r[16];
+   __m512i t[16];
+   unsigned b, i;
+
+   for( b = 0; b < blocks; b++ )
+   {
+      for( i = 0; i < 16; i++ )
+      {
+         __m512i x = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i*)(ptr[i] + b * 16)));
+
+         x = _mm512_inserti32x4(x, _mm_loadu_si128((const __m128i*)(ptr[i + 16] + b * 16)), 1);
+         x = _mm512_inserti32x4(x, _mm_loadu_si128((const __m128i*)(ptr[i + 32] + b * 16)), 2);
+         r[i] = _mm512_inserti32x4(x, _mm_loadu_si128((const __m128i*)(ptr[i + 48] + b * 16)), 3);
+      }
+      CRC16_TRANSPOSE_ROUND(r, t, _mm512_unpacklo_epi8, _mm512_unpackhi_epi8);
+      CRC16_TRANSPOSE_ROUND(t, r, _mm512_unpacklo_epi8, _mm512_unpackhi_epi8);
+      CRC16_TRANSPOSE_ROUND(r, t, _mm512_unpacklo_epi8, _mm512_unpackhi_epi8);
+      CRC16_TRANSPOSE_ROUND(t, r, _mm512_unpacklo_epi8, _mm512_unpackhi_epi8);
+      for( i = 0; i < 16; i++ )
+      {
+         __m512i x = _mm512_xor_si512(lo, r[i]);
+         __m512i xl = _mm512_and_si512(x, mask);
+         __m512i xh = _mm512_and_si512(_mm512_srli_epi16(x, 4), mask);
+
+         lo = _mm512_xor_si512(_mm512_xor_si512(hi, _mm512_shuffle_epi8(a_lo, xl)),
+                               _mm512_shuffle_epi8(b_lo, xh));
+         hi = _mm512_xor_si512(_mm512_shuffle_epi8(a_hi, xl), _mm512_shuffle_epi8(b_hi, xh));
+      }
+   }
+   _mm512_storeu_si512(crc_lo, lo);
+   _mm512_storeu_si512(crc_hi, hi);
+}
+
+void crc16_update_multi_avx512(crc16_job_t *jobs, unsigned cnt)
+{
+   crc16_update_multi_lanes(jobs, cnt, 64, crc16_multi_kernel_avx512);
+}
+
+#endif
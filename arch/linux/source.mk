@@ -1,2 +1,18 @@
-ARCHSOURCES =
+#modules of this architecture, ebr.c and skiplist.c are in the top directory
+#but need threads and thread local storage
+ARCHSOURCES = \
+	arch.c \
+	crc_x86.c \
+	circfifo_x86.c \
+	circfifo_file.c \
+	circfifo_shm.c \
+	circfifo_sink.c \
+	ebr.c \
+	skiplist.c
 
+#unit tests of modules which exist only on this architecture
+ARCHTESTSOURCES = \
+	test_circfifo_file.c \
+	test_circfifo_shm.c \
+	test_circfifo_sink.c \
+	test_skiplist.c
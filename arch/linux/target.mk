@@ -23,4 +23,6 @@ CFLAGS   = -O0
 endif
 CFLAGS   += -std=gnu99 
 LDFLAGS  =
+#libraries required by unit tests (test_*.c)
+TESTLIBS = -lpthread
 
@@ -0,0 +1,108 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include "branchprof.h"
+
+#ifdef CONFIG_BRANCH_PROFILE
+
+/* section boundaries are provided by the linker, weak because the section does
+ * not exist if there is no single likely()/unlikely() in the program */
+extern branchprof_site_t __start_branchprof[] __attribute__((weak));
+extern branchprof_site_t __stop_branchprof[] __attribute__((weak));
+
+static int branchprof_cmp(const void *a, const void *b)
+{
+   const branchprof_site_t *x = *(const branchprof_site_t* const*)a;
+   const branchprof_site_t *y = *(const branchprof_site_t* const*)b;
+
+   if( x->incorrect != y->incorrect )
+   {
+      return (x->incorrect < y->incorrect) ? 1 : -1;
+   }
+   return (x->correct < y->correct) ? 1 : ((x->correct > y->correct) ? -1 : 0);
+}
+
+unsigned branchprof_dump(FILE *out, bool all)
+{
+   branchprof_site_t *site;
+   branchprof_site_t **sorted;
+   size_t cnt = __stop_branchprof - __start_branchprof;
+   size_t used = 0;
+   size_t i;
+
+   if( 0 == cnt )
+   {
+      return 0;
+   }
+
+   sorted = malloc(cnt * sizeof(*sorted));
+   if( NULL == sorted )
+   {
+      return 0;
+   }
+
+   for( site = __start_branchprof; site < __stop_branchprof; site++ )
+   {
+      if( all ? (site->correct + site->incorrect > 0) :
+                (site->incorrect > site->correct) )
+      {
+         sorted[used++] = site;
+      }
+   }
+   qsort(sorted, used, sizeof(*sorted), branchprof_cmp);
+
+   fprintf(out, " correct  incorrect   %%  location\n");
+   for( i = 0; i < used; i++ )
+   {
+      site = sorted[i];
+      fprintf(out, "%8lu %10lu %3u  %s:%u %s(): %s\n",
+              site->correct, site->incorrect,
+              (unsigned)(site->incorrect * 100 / (site->correct + site->incorrect)),
+              site->file, site->line, site->func, site->expr);
+   }
+
+   free(sorted);
+   return (unsigned)used;
+}
+
+void branchprof_reset(void)
+{
+   branchprof_site_t *site;
+
+   for( site = __start_branchprof; site < __stop_branchprof; site++ )
+   {
+      site->correct = 0;
+      site->incorrect = 0;
+   }
+}
+
+#endif /* CONFIG_BRANCH_PROFILE */
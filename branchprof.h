@@ -0,0 +1,60 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BRANCHPROF_H_
+#define __BRANCHPROF_H_ 1
+
+#include <stdio.h>
+#include "arch.h"
+#include "gmacros.h"
+
+#ifdef CONFIG_BRANCH_PROFILE
+
+/**
+ * Function prints the likely()/unlikely() call sites sorted by number of
+ * mispredictions (the cost of wrong hint). By default only the sites where
+ * hint was more often wrong than right are printed.
+ *
+ * @param out Output stream
+ * @param all true if all sites which were executed at least once should be printed
+ * @return Number of printed sites
+ */
+unsigned branchprof_dump(FILE *out, bool all);
+
+/**
+ * Function zeroes counters of all call sites. Should be called when profiled
+ * code is quiescent, otherwise some of concurrent updates may survive.
+ */
+void branchprof_reset(void);
+
+#endif /* CONFIG_BRANCH_PROFILE */
+
+#endif /* __BRANCHPROF_H_ */
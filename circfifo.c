@@ -29,103 +29,283 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+/* library always provides out-of-line version of the fifo operations */
+#undef CONFIG_CIRCFIFO_INLINE
 #include "circfifo.h"
 
-void circfifo_init(circfifo_t *fifo, void* buff, int size)
+#define CIRCFIFO_API
+#include "circfifo_impl.h"
+
+#ifdef CONFIG_CIRCFIFO_STATS
+void circfifo_stats_get(const circfifo_t *fifo, circfifo_stats_t *stats)
 {
-  assert(size > 0);
+   int i;
 
-  fifo->buff = buff;
-  fifo->size = size;
-  fifo->wr = 0;
-  fifo->rd = 0;
+   memset(stats, 0, sizeof(*stats));
+   stats->in.bytes = circfifo_stat_get(fifo->stats.in.bytes);
+   stats->in.short_cnt = circfifo_stat_get(fifo->stats.in.short_cnt);
+   stats->in.high_water = circfifo_stat_get(fifo->stats.in.high_water);
+   for( i = 0; i < CIRCFIFO_STATS_HIST; i++ )
+   {
+      stats->in.hist[i] = circfifo_stat_get(fifo->stats.in.hist[i]);
+   }
+   stats->out.bytes = circfifo_stat_get(fifo->stats.out.bytes);
+   stats->out.short_cnt = circfifo_stat_get(fifo->stats.out.short_cnt);
 }
+#endif
 
-unsigned circfifo_in(circfifo_t *fifo, const void *buff, int req_cnt)
+const uint8_t* circfifo_scan_scalar(const uint8_t *buff, unsigned size, uint8_t byte)
 {
-   /* wr where to write in next cycle */
-   /* rd from where read in next cycle */
-   /* wr == req_cnt then wr = 0 */
-   /* wr == rd buff empty */
-   /* wr + 1 == rd then buff is full */
-
-   int free_space = 0;
-   int bytes_written = 0;
-   int bytes_to_write = 0;
+   const uint8_t *end = buff + size;
 
-   do
+   for( ; buff < end; buff++ )
    {
-      assert(req_cnt > 0);
-
-      do
+      if( *buff == byte )
       {
-         if( (fifo->wr + 1) > fifo->rd )
-         {
-            /* upside down scenario for write */
-            free_space = fifo->size - fifo->wr - (0 == fifo->rd ? 1 : 0);
-            if( free_space <= 0 )
-            {
-               break;
-            }
-
-            bytes_written = (req_cnt > free_space) ? free_space : req_cnt;
-            memcpy( &(fifo->buff[fifo->wr]), buff, bytes_written );
-            /* move the wr index forward by the amount of written bytes
-               if we had writen all remain space up to the end of buff then move
-               wr to the begining (o offset) */
-            fifo->wr = ((fifo->wr + bytes_written) == fifo->size) ? 0 : fifo->wr + bytes_written;
-         }
-      }while(0);
-
-      free_space = fifo->rd - fifo->wr - 1;
-      if( free_space <= 0 )
+         return buff;
+      }
+   }
+
+   return NULL;
+}
+
+int circfifo_find(const circfifo_t *fifo, uint8_t byte)
+{
+   int wr = __atomic_load_n(&fifo->wr, __ATOMIC_ACQUIRE);
+   int rd = fifo->rd;
+   const uint8_t *found;
+   int first;
+
+   /* upside down scenario, first segment is from rd up to the end of buff */
+   first = (wr < rd) ? (fifo->size - rd) : (wr - rd);
+   found = circfifo_scan(&fifo->buff[rd], first, byte);
+   if( NULL != found )
+   {
+      return found - &fifo->buff[rd];
+   }
+   if( wr < rd )
+   {
+      found = circfifo_scan(fifo->buff, wr, byte);
+      if( NULL != found )
       {
-         break;
+         return first + (found - fifo->buff);
       }
+   }
+
+   return -1;
+}
+
+unsigned circfifo_count(const circfifo_t *fifo)
+{
+   int cnt = __atomic_load_n(&fifo->wr, __ATOMIC_ACQUIRE) - __atomic_load_n(&fifo->rd, __ATOMIC_ACQUIRE);
+
+   return (cnt < 0) ? cnt + fifo->size : cnt;
+}
+
+unsigned circfifo_space(const circfifo_t *fifo)
+{
+   int space = __atomic_load_n(&fifo->rd, __ATOMIC_ACQUIRE) - __atomic_load_n(&fifo->wr, __ATOMIC_ACQUIRE) - 1;
+
+   return (space < 0) ? space + fifo->size : space;
+}
+
+unsigned circfifo_rd_region(const circfifo_t *fifo, uint8_t **ptr)
+{
+   int wr = __atomic_load_n(&fifo->wr, __ATOMIC_ACQUIRE);
+   int rd = fifo->rd;
+
+   *ptr = &fifo->buff[rd];
+   return (wr < rd) ? (fifo->size - rd) : (wr - rd);
+}
+
+void circfifo_rd_commit(circfifo_t *fifo, unsigned cnt)
+{
+   int rd = fifo->rd + cnt;
+
+   assert(cnt <= circfifo_count(fifo));
+   __atomic_store_n(&fifo->rd, (rd >= fifo->size) ? rd - fifo->size : rd, __ATOMIC_RELEASE);
+}
+
+void circfifo_wr_commit(circfifo_t *fifo, unsigned cnt)
+{
+   int wr = fifo->wr + cnt;
+
+   assert(cnt <= circfifo_space(fifo));
+   __atomic_store_n(&fifo->wr, (wr >= fifo->size) ? wr - fifo->size : wr, __ATOMIC_RELEASE);
+}
+
+/* copies n bytes into fifo at index pos, returns index after the data */
+static int circfifo_put_at(circfifo_t *fifo, int pos, const uint8_t *src, int n)
+{
+   int first = min(n, fifo->size - pos);
+
+   memcpy(&fifo->buff[pos], src, first);
+   memcpy(fifo->buff, &src[first], n - first);
+   pos += n;
+   return (pos >= fifo->size) ? pos - fifo->size : pos;
+}
+
+/* copies n bytes from fifo at index pos, returns index after the data */
+static int circfifo_get_at(const circfifo_t *fifo, int pos, uint8_t *dst, int n)
+{
+   int first = min(n, fifo->size - pos);
+
+   memcpy(dst, &fifo->buff[pos], first);
+   memcpy(&dst[first], fifo->buff, n - first);
+   pos += n;
+   return (pos >= fifo->size) ? pos - fifo->size : pos;
+}
 
-      bytes_to_write = ((req_cnt - bytes_written) > free_space) ? free_space : (req_cnt - bytes_written);
-      memcpy( &(fifo->buff[fifo->wr]), &(((uint8_t*)buff)[bytes_written]), bytes_to_write );
-      fifo->wr += bytes_to_write;
-      bytes_written += bytes_to_write;
+/* record header is len + 1 in 7 bit groups, LSB first, bit 7 set when more
+ * bytes follow, header 0 marks padding up to the end of buffer */
+static int circfifo_rec_hdr_enc(uint8_t *hdr, unsigned len)
+{
+   unsigned val = len + 1;
+   int n = 0;
 
-   }while(0);
+   while( val >= 0x80 )
+   {
+      hdr[n++] = (uint8_t)(val | 0x80);
+      val >>= 7;
+   }
+   hdr[n++] = (uint8_t)val;
 
-   return bytes_written;
+   return n;
 }
 
-unsigned circfifo_out(circfifo_t *fifo, void *buff, int req_cnt)
+/* skips padding and decodes the header of the next record, returns index of
+ * the payload or -1 if fifo is empty */
+static int circfifo_rec_hdr_dec(const circfifo_t *fifo, int *rd, unsigned *len)
 {
-   int to_read = 0;
-   int bytes_read = 0;
-   int bytes_to_read = 0;
+   int wr = __atomic_load_n(&fifo->wr, __ATOMIC_ACQUIRE);
+   int pos = *rd;
+   unsigned val = 0;
+   unsigned shift = 0;
+   uint8_t byte;
 
+   if( (pos != wr) && (0 == fifo->buff[pos]) )
+   {
+      /* padding, record starts at the begining of buffer */
+      pos = 0;
+      *rd = 0;
+   }
+   if( pos == wr )
+   {
+      return -1;
+   }
    do
    {
-      assert(req_cnt > 0);
+      byte = fifo->buff[pos];
+      pos = ((pos + 1) == fifo->size) ? 0 : pos + 1;
+      val |= (unsigned)(byte & 0x7F) << shift;
+      shift += 7;
+   }while( byte & 0x80 );
+   *len = val - 1;
 
-      if( (fifo->wr + 1) <= fifo->rd )
-      {
-         /* upside down scenario for read */
-         to_read = fifo->size - fifo->rd;
+   return pos;
+}
 
-         bytes_read = (req_cnt > to_read) ? to_read : req_cnt;
-         memcpy( buff, &(fifo->buff[fifo->rd]), bytes_read );
-         fifo->rd = ((fifo->rd + bytes_read) == fifo->size) ? 0 : fifo->rd + bytes_read;
-      }
+bool circfifo_rec_in(circfifo_t *fifo, const void *buff, unsigned len, unsigned flags)
+{
+   uint8_t hdr[CIRCFIFO_REC_HDR_MAX];
+   int hdr_len = circfifo_rec_hdr_enc(hdr, len);
+   int need = hdr_len + (int)len;
+   int wr = fifo->wr;
+   int pad = 0;
 
-      to_read = fifo->wr - fifo->rd;
-      if( to_read <= 0 )
-      {
-         break;
-      }
+   if( (flags & CIRCFIFO_REC_CONTIG) && (need > fifo->size - wr) )
+   {
+      /* record does not fit before the end of buffer, pad the rest */
+      pad = fifo->size - wr;
+   }
+   if( (pad + need) > (int)circfifo_space(fifo) )
+   {
+      circfifo_stats_in(fifo, need, 0);
+      return false;
+   }
+
+   if( pad > 0 )
+   {
+      fifo->buff[wr] = 0;
+      wr = 0;
+   }
+   wr = circfifo_put_at(fifo, wr, hdr, hdr_len);
+   wr = circfifo_put_at(fifo, wr, buff, len);
+   /* whole record becomes visible at once */
+   __atomic_store_n(&fifo->wr, wr, __ATOMIC_RELEASE);
+   circfifo_stats_in(fifo, need, need);
+
+   return true;
+}
+
+int circfifo_rec_len(const circfifo_t *fifo)
+{
+   int rd = fifo->rd;
+   unsigned len;
+
+   if( circfifo_rec_hdr_dec(fifo, &rd, &len) < 0 )
+   {
+      return -1;
+   }
+   return len;
+}
+
+int circfifo_rec_out(circfifo_t *fifo, void *buff, unsigned size)
+{
+   int rd = fifo->rd;
+   int pos;
+   unsigned len;
+
+   pos = circfifo_rec_hdr_dec(fifo, &rd, &len);
+   if( pos < 0 )
+   {
+      return -1;
+   }
+   if( len <= size )
+   {
+      __atomic_store_n(&fifo->rd, circfifo_get_at(fifo, pos, buff, len), __ATOMIC_RELEASE);
+      circfifo_stats_out(fifo, len, len);
+   }
 
-      bytes_to_read = ((req_cnt - bytes_read) > to_read) ? to_read : (req_cnt - bytes_read);
-      memcpy( &(((uint8_t*)buff)[bytes_read]), &(fifo->buff[fifo->rd]), bytes_to_read );
-      fifo->rd += bytes_to_read;
-      bytes_read += bytes_to_read;
+   return len;
+}
 
-   }while(0);
+void* circfifo_rec_ptr(const circfifo_t *fifo, unsigned *len)
+{
+   int rd = fifo->rd;
+   int pos;
 
-   return bytes_read;
+   pos = circfifo_rec_hdr_dec(fifo, &rd, len);
+   if( (pos < 0) || ((int)*len > fifo->size - pos) )
+   {
+      return NULL;
+   }
+   return &fifo->buff[pos];
 }
 
+void circfifo_rec_drop(circfifo_t *fifo)
+{
+   int rd = fifo->rd;
+   int pos;
+   unsigned len;
+
+   pos = circfifo_rec_hdr_dec(fifo, &rd, &len);
+   if( pos >= 0 )
+   {
+      pos += len;
+      __atomic_store_n(&fifo->rd, (pos >= fifo->size) ? pos - fifo->size : pos, __ATOMIC_RELEASE);
+   }
+}
+
+void circfifo_init(circfifo_t *fifo, void* buff, int size)
+{
+  assert(size > 0);
+
+  fifo->buff = buff;
+  fifo->size = size;
+  fifo->wr = 0;
+  fifo->rd = 0;
+#ifdef CONFIG_CIRCFIFO_STATS
+  memset(&fifo->stats, 0, sizeof(fifo->stats));
+#endif
+}
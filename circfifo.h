@@ -34,25 +34,74 @@
 
 #include "arch.h"
 
+#ifdef CONFIG_CIRCFIFO_STATS
+/** number of buckets in fill level histogram, bucket i counts writes which left
+ *  the fifo filled in range [i * size / N, (i + 1) * size / N) */
+#define CIRCFIFO_STATS_HIST 8
+/** producer and consumer counters are kept in separate cache lines */
+#define CIRCFIFO_STATS_ALIGN CACHELINE_SIZE
+
+/**
+ * Fifo usage statistics, enabled by CONFIG_CIRCFIFO_STATS (make STATS=1)
+ * The define changes the layout of circfifo_t so it has to be the same for the
+ * library and for the code which uses it.
+ * Each side has single writer (circfifo_in() or circfifo_out()) so counters are
+ * updated with relaxed stores, without atomic read-modify-write. Use
+ * circfifo_stats_get() to take consistent snapshot of each counter from any
+ * thread.
+ */
+typedef struct circfifo_stats_tag
+{
+   /** updated only by circfifo_in() */
+   struct {
+      /** bytes written into fifo */
+      unsigned long bytes;
+      /** calls which written less than requested (data was lost) */
+      unsigned long short_cnt;
+      /** maximal observed fill level in bytes */
+      int high_water;
+      /** fill level histogram sampled after each write */
+      unsigned long hist[CIRCFIFO_STATS_HIST];
+   } in __attribute__((aligned(CIRCFIFO_STATS_ALIGN)));
+   /** updated only by circfifo_out() */
+   struct {
+      /** bytes read from fifo */
+      unsigned long bytes;
+      /** calls which read less than requested */
+      unsigned long short_cnt;
+   } out __attribute__((aligned(CIRCFIFO_STATS_ALIGN)));
+} circfifo_stats_t;
+#endif
+
 typedef struct circfifo_tag
 {
    /** pointer to buffer for data storadge */
    uint8_t *buff;
    /** size of the buffer in bytes */
    int size;
-   /** index where to write in next cycle */
+   /** index where to write in next cycle, modified only by the producer */
    int wr;
-   /** index from where read in next cycle */
+   /** index from where read in next cycle, modified only by the consumer */
    int rd;
 
+   /**
+    * Each side publishes its own index with release store after the data was
+    * copied and loads the index of other side with acquire, so one producer
+    * thread and one consumer thread can use the fifo without a lock. */
+
    /**
     * wr == req_cnt then wr = 0
     * wr == rd buff empty
     * wr + 1 == rd then buff is full */
+
+#ifdef CONFIG_CIRCFIFO_STATS
+   circfifo_stats_t stats;
+#endif
 } circfifo_t;
 
 void circfifo_init(circfifo_t *fifo, void* buff, int size);
 
+#ifndef CONFIG_CIRCFIFO_INLINE
 /**
  * Function writes bytes into fifo from passed buff
  * \return Number of bytes written into buff
@@ -64,6 +113,122 @@ unsigned circfifo_in(circfifo_t *fifo, const void *buff, int req_cnt);
  * \return Number of bytes written into buff is returned
  */
 unsigned circfifo_out(circfifo_t *fifo, void *buff, int req_cnt);
+#else
+/*
+ * With CONFIG_CIRCFIFO_INLINE defined before including this header,
+ * circfifo_in() and circfifo_out() are static inline in each translation
+ * unit, so for constant req_cnt the copy is done with plain moves and there is
+ * no call overhead. The library still contains out-of-line versions, so code
+ * built both ways can share the same fifo. Mind the code size on AVR.
+ */
+#define CIRCFIFO_API static inline
+#include "circfifo_impl.h"
+#endif
+
+/**
+ * \return number of bytes available for read
+ */
+unsigned circfifo_count(const circfifo_t *fifo);
+
+/**
+ * \return number of bytes which can be written
+ */
+unsigned circfifo_space(const circfifo_t *fifo);
+
+/**
+ * Function gives access to the data available for read without copying. To be
+ * called by the consumer, which then calls circfifo_rd_commit() with number of
+ * bytes it used. Data which wraps around the end of buffer is in the second
+ * region, returned after the first one is committed.
+ * \return number of bytes in contiguous region starting at *ptr
+ */
+unsigned circfifo_rd_region(const circfifo_t *fifo, uint8_t **ptr);
+
+/**
+ * Function releases cnt bytes obtained by circfifo_rd_region()
+ */
+void circfifo_rd_commit(circfifo_t *fifo, unsigned cnt);
+
+/**
+ * Function makes visible to the consumer cnt bytes which producer already
+ * stored in the free space after the write position (fifo->buff[wr], wrapping
+ * at fifo->size). Used by stages which build the output in place.
+ */
+void circfifo_wr_commit(circfifo_t *fifo, unsigned cnt);
+
+/**
+ * Record mode, each record is stored with length header so it is written and
+ * read as a whole. Record and byte stream functions cannot be mixed on one fifo.
+ * Header takes 1 byte for records shorter than 127 bytes, at most
+ * CIRCFIFO_REC_HDR_MAX bytes.
+ */
+#define CIRCFIFO_REC_HDR_MAX 5
+/** record is stored contiguous, the rest of buffer is padded if needed, so
+ *  circfifo_rec_ptr() can give access to it in place */
+#define CIRCFIFO_REC_CONTIG 1
+
+/**
+ * Function writes whole record into fifo or nothing
+ * \param flags CIRCFIFO_REC_CONTIG or 0
+ * \return true if record was written, false if there is not enough space
+ */
+bool circfifo_rec_in(circfifo_t *fifo, const void *buff, unsigned len, unsigned flags);
+
+/**
+ * \return length of the next record or -1 if fifo is empty
+ */
+int circfifo_rec_len(const circfifo_t *fifo);
+
+/**
+ * Function reads the next record into buff. If record is longer than size it
+ * stays in the fifo, use circfifo_rec_len() or circfifo_rec_drop().
+ * \return length of the record or -1 if fifo is empty
+ */
+int circfifo_rec_out(circfifo_t *fifo, void *buff, unsigned size);
+
+/**
+ * Function gives access to the payload of next record without copying, the
+ * record stays in fifo until circfifo_rec_drop()
+ * \return pointer to the payload or NULL if fifo is empty or record wraps
+ *         around the end of buffer (not written with CIRCFIFO_REC_CONTIG)
+ */
+void* circfifo_rec_ptr(const circfifo_t *fifo, unsigned *len);
+
+/**
+ * Function removes the next record from fifo
+ */
+void circfifo_rec_drop(circfifo_t *fifo);
+
+/**
+ * Function searches the data available for read for the first occurrence of
+ * given byte (e.g. frame delimiter), data stays in the fifo. To be called by
+ * the consumer.
+ * \return offset of the byte from the read position or -1 if not found, so
+ *         circfifo_out() of offset + 1 bytes returns the data up to and
+ *         including the delimiter
+ */
+int circfifo_find(const circfifo_t *fifo, uint8_t byte);
+
+/* search within one contiguous segment, returns pointer to first match or NULL,
+ * circfifo_scan() selects the fastest implementation */
+const uint8_t* circfifo_scan_scalar(const uint8_t *buff, unsigned size, uint8_t byte);
+#ifdef ARCH_DISPATCH
+#define circfifo_scan(_buff, _size, _byte) arch_dispatch.circfifo_scan((_buff), (_size), (_byte))
+#if defined(__x86_64__) || defined(__i386__)
+const uint8_t* circfifo_scan_sse2(const uint8_t *buff, unsigned size, uint8_t byte);
+const uint8_t* circfifo_scan_avx2(const uint8_t *buff, unsigned size, uint8_t byte);
+#endif
+#else
+#define circfifo_scan(_buff, _size, _byte) circfifo_scan_scalar((_buff), (_size), (_byte))
+#endif
+
+#ifdef CONFIG_CIRCFIFO_STATS
+/**
+ * Function takes the snapshot of fifo statistics, it can be called from any
+ * thread. Counters are read one by one so the snapshot is not atomic as a whole
+ */
+void circfifo_stats_get(const circfifo_t *fifo, circfifo_stats_t *stats);
+#endif
 
 #endif /* __CIRCFIFO_H_ */
 
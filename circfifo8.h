@@ -0,0 +1,123 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CIRCFIFO8_H_
+#define __CIRCFIFO8_H_ 1
+
+#include "arch.h"
+
+/**
+ * Byte fifo with 8 bit indexes, for UART and similar drivers on 8 bit cores
+ * where the generic circfifo_t has too much overhead to be used from ISR.
+ *
+ * Size of the buffer has to be power of 2 in range 2 - 256, one byte is always
+ * left free so the capacity is size - 1. Single producer and single consumer
+ * (e.g. ISR and main loop) can use the fifo without disabling interrupts,
+ * because each index has only one writer and single byte stores are atomic.
+ * Buffer content is published with release store of the index and observed
+ * with acquire load of the other one, which on AVR are plain loads and stores
+ * but keep the compiler from reordering buffer accesses around them.
+ */
+typedef struct circfifo8_tag
+{
+   /** pointer to buffer for data storage */
+   uint8_t *buff;
+   /** size of the buffer - 1 */
+   uint8_t mask;
+   /** index where to write next byte, written only by producer */
+   uint8_t wr;
+   /** index from where to read next byte, written only by consumer */
+   uint8_t rd;
+} circfifo8_t;
+
+/**
+ * Function initializes the fifo, size has to be power of 2 in range 2 - 256
+ */
+static inline void circfifo8_init(circfifo8_t *fifo, void *buff, unsigned size)
+{
+   assert((size >= 2) && (size <= 256) && (0 == (size & (size - 1))));
+
+   fifo->buff = buff;
+   fifo->mask = (uint8_t)(size - 1);
+   fifo->wr = 0;
+   fifo->rd = 0;
+}
+
+/**
+ * Function stores one byte in fifo, to be called only by producer
+ * \return true on success, false if fifo is full
+ */
+static inline bool circfifo8_put(circfifo8_t *fifo, uint8_t byte)
+{
+   uint8_t wr = fifo->wr;
+   uint8_t next = (wr + 1) & fifo->mask;
+
+   if( next == __atomic_load_n(&fifo->rd, __ATOMIC_ACQUIRE) )
+   {
+      return false;
+   }
+   fifo->buff[wr] = byte;
+   __atomic_store_n(&fifo->wr, next, __ATOMIC_RELEASE);
+
+   return true;
+}
+
+/**
+ * Function takes one byte from fifo, to be called only by consumer
+ * \return true on success, false if fifo is empty
+ */
+static inline bool circfifo8_get(circfifo8_t *fifo, uint8_t *byte)
+{
+   uint8_t rd = fifo->rd;
+
+   if( rd == __atomic_load_n(&fifo->wr, __ATOMIC_ACQUIRE) )
+   {
+      return false;
+   }
+   *byte = fifo->buff[rd];
+   __atomic_store_n(&fifo->rd, (uint8_t)((rd + 1) & fifo->mask), __ATOMIC_RELEASE);
+
+   return true;
+}
+
+/**
+ * \return number of bytes stored in fifo, exact only when called by producer
+ *         or consumer, otherwise a snapshot
+ */
+static inline uint8_t circfifo8_count(const circfifo8_t *fifo)
+{
+   uint8_t wr = __atomic_load_n(&fifo->wr, __ATOMIC_ACQUIRE);
+   uint8_t rd = __atomic_load_n(&fifo->rd, __ATOMIC_ACQUIRE);
+
+   return (wr - rd) & fifo->mask;
+}
+
+#endif /* __CIRCFIFO8_H_ */
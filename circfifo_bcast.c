@@ -0,0 +1,135 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "circfifo_bcast.h"
+#include "circfifo_ow_impl.h"
+
+/* finds the slowest active consumer, cursor is loaded with acquire so its
+ * reads of the buffer are finished before the producer overwrites the data */
+static unsigned long circfifo_bcast_min_rd(circfifo_bcast_t *fifo, unsigned long head)
+{
+   unsigned long min_rd = head;
+   unsigned long rd;
+   unsigned i;
+
+   for( i = 0; i < fifo->readers_cnt; i++ )
+   {
+      if( __atomic_load_n(&fifo->readers[i].active, __ATOMIC_RELAXED) )
+      {
+         rd = __atomic_load_n(&fifo->readers[i].rd, __ATOMIC_ACQUIRE);
+         if( (long)(rd - min_rd) < 0 )
+         {
+            min_rd = rd;
+         }
+      }
+   }
+
+   return min_rd;
+}
+
+void circfifo_bcast_init(circfifo_bcast_t *fifo, void *buff, unsigned long size,
+                         circfifo_bcast_reader_t *readers, unsigned readers_cnt,
+                         unsigned flags)
+{
+   unsigned i;
+
+   assert((size >= 2) && (0 == (size & (size - 1))));
+
+   memset(fifo, 0, sizeof(*fifo));
+   fifo->buff = buff;
+   fifo->mask = size - 1;
+   fifo->readers = readers;
+   fifo->readers_cnt = readers_cnt;
+   fifo->flags = flags;
+   /* nothing overwritten yet */
+   fifo->in.tail = 0 - size;
+   for( i = 0; i < readers_cnt; i++ )
+   {
+      memset(&readers[i], 0, sizeof(readers[i]));
+      readers[i].active = true;
+   }
+}
+
+unsigned long circfifo_bcast_in(circfifo_bcast_t *fifo, const void *buff, unsigned long req_cnt)
+{
+   unsigned long size = fifo->mask + 1;
+   unsigned long head = fifo->in.head;
+   unsigned long room;
+
+   if( fifo->flags & CIRCFIFO_BCAST_DROP )
+   {
+      unsigned long skip = (req_cnt > size) ? req_cnt - size : 0;
+
+      /* publish what is going to be overwritten before it happens */
+      circfifo_ow_set_tail(&fifo->in.tail, head + req_cnt - size);
+      circfifo_ow_put(fifo->buff, fifo->mask, head + skip, (const uint8_t*)buff + skip, req_cnt - skip);
+      __atomic_store_n(&fifo->in.head, head + req_cnt, __ATOMIC_RELEASE);
+      return req_cnt;
+   }
+
+   room = size - (head - fifo->in.min_rd);
+   if( room < req_cnt )
+   {
+      fifo->in.min_rd = circfifo_bcast_min_rd(fifo, head);
+      room = size - (head - fifo->in.min_rd);
+   }
+   req_cnt = min(req_cnt, room);
+   circfifo_ow_put(fifo->buff, fifo->mask, head, buff, req_cnt);
+   __atomic_store_n(&fifo->in.head, head + req_cnt, __ATOMIC_RELEASE);
+
+   return req_cnt;
+}
+
+unsigned long circfifo_bcast_out(circfifo_bcast_t *fifo, unsigned id, void *buff, unsigned long req_cnt)
+{
+   circfifo_bcast_reader_t *reader = &fifo->readers[id];
+   unsigned long rd = reader->rd;
+   unsigned long head, cnt;
+
+   /* in gated mode tail never moves, so there is no overrun and copy is valid */
+   do
+   {
+      head = __atomic_load_n(&fifo->in.head, __ATOMIC_ACQUIRE);
+      rd = circfifo_ow_catch_up(&fifo->in.tail, &reader->lost, rd);
+      cnt = min(req_cnt, head - rd);
+      circfifo_ow_get(fifo->buff, fifo->mask, rd, buff, cnt);
+   }while( unlikely(!circfifo_ow_valid(&fifo->in.tail, rd)) );
+
+   /* release orders the reads of buffer before producer reuses it */
+   __atomic_store_n(&reader->rd, rd + cnt, __ATOMIC_RELEASE);
+
+   return cnt;
+}
+
+void circfifo_bcast_detach(circfifo_bcast_t *fifo, unsigned id)
+{
+   __atomic_store_n(&fifo->readers[id].active, false, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,126 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CIRCFIFO_BCAST_H_
+#define __CIRCFIFO_BCAST_H_ 1
+
+#include "arch.h"
+#include "gmacros.h"
+
+/*
+ * Broadcast fifo, single producer and several consumers which all receive the
+ * same byte stream from one buffer, each one with its own read cursor.
+ *
+ * Positions are free running, buffer index is position masked with size - 1
+ * so size has to be power of 2. Each cursor is in its own cache line, so
+ * consumers do not disturb each other nor the producer.
+ *
+ * By default the producer waits for the slowest consumer: circfifo_bcast_in()
+ * writes only as much as all active consumers have room for. The producer
+ * keeps the minimum of cursors and reads the cursors again only when this
+ * cached minimum does not leave enough space.
+ * With CIRCFIFO_BCAST_DROP the producer never waits, consumer which falls
+ * behind by more than size is overrun, it detects it in circfifo_bcast_out()
+ * and skips to the oldest data which is still available, counting lost bytes
+ * (the same protocol as circfifo_ow_t).
+ *
+ * Consumers are given at init and all start at position 0. Consumer which
+ * stops reading has to call circfifo_bcast_detach(), otherwise it stalls the
+ * producer.
+ */
+
+/** producer does not wait for consumers, slow ones lose data */
+#define CIRCFIFO_BCAST_DROP 1
+
+typedef struct circfifo_bcast_reader_tag
+{
+   /** position of the next byte to read */
+   unsigned long rd;
+   /** bytes overwritten before this consumer read them */
+   unsigned long lost;
+   /** consumer is taken into account by producer */
+   bool active;
+} cacheline_aligned circfifo_bcast_reader_t;
+
+typedef struct circfifo_bcast_tag
+{
+   /** written only by producer */
+   struct {
+      /** position after the last written byte */
+      unsigned long head;
+      /** position of the oldest byte which was not overwritten */
+      unsigned long tail;
+      /** cached minimum of active consumer cursors */
+      unsigned long min_rd;
+   } cacheline_aligned in;
+   uint8_t *buff;
+   unsigned long mask;
+   circfifo_bcast_reader_t *readers;
+   unsigned readers_cnt;
+   unsigned flags;
+} circfifo_bcast_t;
+
+/**
+ * Function initializes the fifo with readers_cnt active consumers which use
+ * records from readers array, size has to be power of 2
+ * \param flags CIRCFIFO_BCAST_DROP or 0
+ */
+void circfifo_bcast_init(circfifo_bcast_t *fifo, void *buff, unsigned long size,
+                         circfifo_bcast_reader_t *readers, unsigned readers_cnt,
+                         unsigned flags);
+
+/**
+ * Function writes bytes into fifo
+ * \return Number of bytes written, always req_cnt in CIRCFIFO_BCAST_DROP mode
+ *         (only last size bytes are stored if req_cnt is bigger than size)
+ */
+unsigned long circfifo_bcast_in(circfifo_bcast_t *fifo, const void *buff, unsigned long req_cnt);
+
+/**
+ * Function reads bytes for consumer with given id
+ * \return Number of bytes written into buff
+ */
+unsigned long circfifo_bcast_out(circfifo_bcast_t *fifo, unsigned id, void *buff, unsigned long req_cnt);
+
+/**
+ * Function removes the consumer, producer no longer waits for it
+ */
+void circfifo_bcast_detach(circfifo_bcast_t *fifo, unsigned id);
+
+/**
+ * \return number of bytes lost by consumer with given id
+ */
+static inline unsigned long circfifo_bcast_lost(const circfifo_bcast_t *fifo, unsigned id)
+{
+   return __atomic_load_n(&fifo->readers[id].lost, __ATOMIC_RELAXED);
+}
+
+#endif /* __CIRCFIFO_BCAST_H_ */
@@ -0,0 +1,215 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Implementation of circfifo_in() and circfifo_out() shared by the library
+ * (circfifo.c) and by the inline build enabled with CONFIG_CIRCFIFO_INLINE.
+ * Do not include directly, use circfifo.h.
+ */
+
+#ifndef __CIRCFIFO_IMPL_H_
+#define __CIRCFIFO_IMPL_H_ 1
+
+#include "gmacros.h"
+#include "trace.h"
+
+#ifdef CONFIG_CIRCFIFO_STATS
+/* each counter has single writer, relaxed store is enough to prevent torn reads
+ * in circfifo_stats_get() */
+#define circfifo_stat_set(_cnt, _val) __atomic_store_n(&(_cnt), (_val), __ATOMIC_RELAXED)
+#define circfifo_stat_get(_cnt) __atomic_load_n(&(_cnt), __ATOMIC_RELAXED)
+
+static inline void circfifo_stats_in(circfifo_t *fifo, int req_cnt, int written)
+{
+   int fill = circfifo_stat_get(fifo->wr) - circfifo_stat_get(fifo->rd);
+
+   fill += (fill < 0) ? fifo->size : 0;
+   circfifo_stat_set(fifo->stats.in.bytes, fifo->stats.in.bytes + written);
+   if( written < req_cnt )
+   {
+      circfifo_stat_set(fifo->stats.in.short_cnt, fifo->stats.in.short_cnt + 1);
+   }
+   if( fill > fifo->stats.in.high_water )
+   {
+      circfifo_stat_set(fifo->stats.in.high_water, fill);
+   }
+   fill = (int)(((long)fill * CIRCFIFO_STATS_HIST) / fifo->size);
+   circfifo_stat_set(fifo->stats.in.hist[fill], fifo->stats.in.hist[fill] + 1);
+}
+
+static inline void circfifo_stats_out(circfifo_t *fifo, int req_cnt, int read)
+{
+   circfifo_stat_set(fifo->stats.out.bytes, fifo->stats.out.bytes + read);
+   if( read < req_cnt )
+   {
+      circfifo_stat_set(fifo->stats.out.short_cnt, fifo->stats.out.short_cnt + 1);
+   }
+}
+
+#else
+#define circfifo_stats_in(_fifo, _req_cnt, _written) do {} while(0)
+#define circfifo_stats_out(_fifo, _req_cnt, _read) do {} while(0)
+#endif
+
+CIRCFIFO_API unsigned circfifo_in(circfifo_t *fifo, const void *buff, int req_cnt)
+{
+   /* wr where to write in next cycle */
+   /* rd from where read in next cycle */
+   /* wr == req_cnt then wr = 0 */
+   /* wr == rd buff empty */
+   /* wr + 1 == rd then buff is full */
+
+   /* wr is modified only here, rd is loaded once, data written before the
+      release store of wr is visible to consumer which loads wr */
+   int wr = fifo->wr;
+   int rd = __atomic_load_n(&fifo->rd, __ATOMIC_ACQUIRE);
+   int free_space = 0;
+   int bytes_written = 0;
+   int bytes_to_write = 0;
+
+   do
+   {
+      assert(req_cnt > 0);
+
+      /* fast path, whole request fits before the end of buffer, for constant
+         req_cnt memcpy is inlined into plain moves */
+      free_space = (wr >= rd) ?
+                   (fifo->size - wr - (0 == rd ? 1 : 0)) :
+                   (rd - wr - 1);
+      if( likely(req_cnt <= free_space) )
+      {
+         memcpy( &(fifo->buff[wr]), buff, req_cnt );
+         wr = ((wr + req_cnt) == fifo->size) ? 0 : wr + req_cnt;
+         bytes_written = req_cnt;
+         break;
+      }
+
+      do
+      {
+         if( (wr + 1) > rd )
+         {
+            /* upside down scenario for write */
+            free_space = fifo->size - wr - (0 == rd ? 1 : 0);
+            if( free_space <= 0 )
+            {
+               break;
+            }
+
+            bytes_written = (req_cnt > free_space) ? free_space : req_cnt;
+            memcpy( &(fifo->buff[wr]), buff, bytes_written );
+            /* move the wr index forward by the amount of written bytes
+               if we had writen all remain space up to the end of buff then move
+               wr to the begining (o offset) */
+            wr = ((wr + bytes_written) == fifo->size) ? 0 : wr + bytes_written;
+         }
+      }while(0);
+
+      free_space = rd - wr - 1;
+      if( free_space <= 0 )
+      {
+         break;
+      }
+
+      bytes_to_write = ((req_cnt - bytes_written) > free_space) ? free_space : (req_cnt - bytes_written);
+      memcpy( &(fifo->buff[wr]), &(((uint8_t*)buff)[bytes_written]), bytes_to_write );
+      wr += bytes_to_write;
+      bytes_written += bytes_to_write;
+
+   }while(0);
+
+   if( bytes_written > 0 )
+   {
+      __atomic_store_n(&fifo->wr, wr, __ATOMIC_RELEASE);
+   }
+   circfifo_stats_in(fifo, req_cnt, bytes_written);
+   TRACE(TRACE_ID_CIRCFIFO_IN, req_cnt, bytes_written);
+
+   return bytes_written;
+}
+
+CIRCFIFO_API unsigned circfifo_out(circfifo_t *fifo, void *buff, int req_cnt)
+{
+   /* rd is modified only here, the release store of rd hands the space back
+      to producer after the data was copied out */
+   int wr = __atomic_load_n(&fifo->wr, __ATOMIC_ACQUIRE);
+   int rd = fifo->rd;
+   int to_read = 0;
+   int bytes_read = 0;
+   int bytes_to_read = 0;
+
+   do
+   {
+      assert(req_cnt > 0);
+
+      /* fast path, whole request is available before the end of buffer */
+      to_read = (wr >= rd) ? (wr - rd) : (fifo->size - rd);
+      if( likely(req_cnt <= to_read) )
+      {
+         memcpy( buff, &(fifo->buff[rd]), req_cnt );
+         rd = ((rd + req_cnt) == fifo->size) ? 0 : rd + req_cnt;
+         bytes_read = req_cnt;
+         break;
+      }
+
+      if( (wr + 1) <= rd )
+      {
+         /* upside down scenario for read */
+         to_read = fifo->size - rd;
+
+         bytes_read = (req_cnt > to_read) ? to_read : req_cnt;
+         memcpy( buff, &(fifo->buff[rd]), bytes_read );
+         rd = ((rd + bytes_read) == fifo->size) ? 0 : rd + bytes_read;
+      }
+
+      to_read = wr - rd;
+      if( to_read <= 0 )
+      {
+         break;
+      }
+
+      bytes_to_read = ((req_cnt - bytes_read) > to_read) ? to_read : (req_cnt - bytes_read);
+      memcpy( &(((uint8_t*)buff)[bytes_read]), &(fifo->buff[rd]), bytes_to_read );
+      rd += bytes_to_read;
+      bytes_read += bytes_to_read;
+
+   }while(0);
+
+   if( bytes_read > 0 )
+   {
+      __atomic_store_n(&fifo->rd, rd, __ATOMIC_RELEASE);
+   }
+   circfifo_stats_out(fifo, req_cnt, bytes_read);
+   TRACE(TRACE_ID_CIRCFIFO_OUT, req_cnt, bytes_read);
+
+   return bytes_read;
+}
+
+#endif /* __CIRCFIFO_IMPL_H_ */
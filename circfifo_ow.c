@@ -0,0 +1,145 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "circfifo_ow.h"
+#include "circfifo_ow_impl.h"
+
+void circfifo_ow_init(circfifo_ow_t *fifo, void *buff, unsigned long size)
+{
+   assert((size >= 2) && (0 == (size & (size - 1))));
+
+   memset(fifo, 0, sizeof(*fifo));
+   fifo->buff = buff;
+   fifo->mask = size - 1;
+}
+
+void circfifo_ow_in(circfifo_ow_t *fifo, const void *buff, unsigned long req_cnt)
+{
+   unsigned long size = fifo->mask + 1;
+   unsigned long head = fifo->in.head;
+
+   if( unlikely(req_cnt > size) )
+   {
+      buff = (const uint8_t*)buff + (req_cnt - size);
+      head += req_cnt - size;
+      req_cnt = size;
+   }
+   /* everything older than size bytes before new head is lost, head - size
+    * wraps before the first lap what makes it older than any position */
+   circfifo_ow_set_tail(&fifo->in.tail, head + req_cnt - size);
+   circfifo_ow_put(fifo->buff, fifo->mask, head, buff, req_cnt);
+   __atomic_store_n(&fifo->in.head, head + req_cnt, __ATOMIC_RELEASE);
+}
+
+unsigned long circfifo_ow_out(circfifo_ow_t *fifo, void *buff, unsigned long req_cnt)
+{
+   unsigned long rd = fifo->out.rd;
+   unsigned long head;
+   unsigned long cnt;
+
+   do
+   {
+      head = __atomic_load_n(&fifo->in.head, __ATOMIC_ACQUIRE);
+      rd = circfifo_ow_catch_up(&fifo->in.tail, &fifo->out.lost, rd);
+      cnt = min(req_cnt, head - rd);
+      circfifo_ow_get(fifo->buff, fifo->mask, rd, buff, cnt);
+   }while( unlikely(!circfifo_ow_valid(&fifo->in.tail, rd)) );
+
+   __atomic_store_n(&fifo->out.rd, rd + cnt, __ATOMIC_RELAXED);
+
+   return cnt;
+}
+
+void circfifo_ow_rec_in(circfifo_ow_t *fifo, const void *buff, unsigned len)
+{
+   circfifo_ow_hdr_t hdr = len;
+   unsigned long head = fifo->in.head;
+   unsigned long tail = fifo->in.tail;
+   unsigned long need = sizeof(hdr) + len;
+
+   assert((len == hdr) && (need <= fifo->mask + 1));
+
+   /* drop whole oldest records, producer reads only what it has written */
+   if( (head + need - tail) > (fifo->mask + 1) )
+   {
+      do
+      {
+         circfifo_ow_hdr_t old;
+
+         circfifo_ow_get(fifo->buff, fifo->mask, tail, (uint8_t*)&old, sizeof(old));
+         tail += sizeof(old) + old;
+      }while( (head + need - tail) > (fifo->mask + 1) );
+      circfifo_ow_set_tail(&fifo->in.tail, tail);
+   }
+   circfifo_ow_put(fifo->buff, fifo->mask, head, (const uint8_t*)&hdr, sizeof(hdr));
+   circfifo_ow_put(fifo->buff, fifo->mask, head + sizeof(hdr), buff, len);
+   __atomic_store_n(&fifo->in.head, head + need, __ATOMIC_RELEASE);
+}
+
+long circfifo_ow_rec_out(circfifo_ow_t *fifo, void *buff, unsigned size)
+{
+   unsigned long rd = fifo->out.rd;
+   unsigned long head;
+   circfifo_ow_hdr_t hdr;
+
+   do
+   {
+      head = __atomic_load_n(&fifo->in.head, __ATOMIC_ACQUIRE);
+      rd = circfifo_ow_catch_up(&fifo->in.tail, &fifo->out.lost, rd);
+      if( head == rd )
+      {
+         hdr = 0;
+         break;
+      }
+      circfifo_ow_get(fifo->buff, fifo->mask, rd, (uint8_t*)&hdr, sizeof(hdr));
+      /* header can be torn, the length is trusted only after the check */
+      if( (hdr <= size) && (sizeof(hdr) + hdr <= head - rd) )
+      {
+         circfifo_ow_get(fifo->buff, fifo->mask, rd + sizeof(hdr), buff, hdr);
+      }
+   }while( unlikely(!circfifo_ow_valid(&fifo->in.tail, rd)) );
+
+   if( head == rd )
+   {
+      __atomic_store_n(&fifo->out.rd, rd, __ATOMIC_RELAXED);
+      return -1;
+   }
+   if( hdr <= size )
+   {
+      __atomic_store_n(&fifo->out.rd, rd + sizeof(hdr) + hdr, __ATOMIC_RELAXED);
+   }
+   else
+   {
+      __atomic_store_n(&fifo->out.rd, rd, __ATOMIC_RELAXED);
+   }
+
+   return hdr;
+}
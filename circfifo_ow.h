@@ -0,0 +1,121 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CIRCFIFO_OW_H_
+#define __CIRCFIFO_OW_H_ 1
+
+#include "arch.h"
+#include "gmacros.h"
+
+/*
+ * Overwrite fifo, writes always succeed and discard the oldest data when the
+ * buffer is full, for telemetry and logs where the producer must never wait.
+ *
+ * Producer and consumer use free running positions, the buffer index is the
+ * position masked with size - 1, so size has to be power of 2. Besides the
+ * write position (head) the producer publishes the position of the oldest
+ * data which is still intact (tail) and moves it forward before it overwrites
+ * anything. The consumer copies the data and then checks tail again, if tail
+ * passed the position from which it was copying, the copy could be torn, so
+ * it is thrown away and the consumer continues from tail. Bytes which were
+ * lost this way are counted in circfifo_ow_t::lost.
+ *
+ * In byte mode (circfifo_ow_in/out) oldest bytes are discarded, in record mode
+ * (circfifo_ow_rec_in/out) whole oldest records, the modes cannot be mixed on
+ * one fifo. Only one producer and one consumer are allowed. Positions are
+ * unsigned long, so on 8 bit cores where their access is not atomic the
+ * consumer has to block the producer (e.g. disable interrupts) while reading.
+ */
+
+/** record header, length of the payload */
+typedef uint16_t circfifo_ow_hdr_t;
+
+typedef struct circfifo_ow_tag
+{
+   /** written only by producer */
+   struct {
+      /** position after the last written byte */
+      unsigned long head;
+      /** position of the oldest byte (or record) which was not overwritten */
+      unsigned long tail;
+   } cacheline_aligned in;
+   /** written only by consumer */
+   struct {
+      /** position of the next byte to read */
+      unsigned long rd;
+      /** number of bytes overwritten before the consumer read them */
+      unsigned long lost;
+   } cacheline_aligned out;
+   uint8_t *buff;
+   unsigned long mask;
+} circfifo_ow_t;
+
+/**
+ * Function initializes the fifo, size has to be power of 2
+ */
+void circfifo_ow_init(circfifo_ow_t *fifo, void *buff, unsigned long size);
+
+/**
+ * Function writes all bytes into fifo, overwriting the oldest ones if needed.
+ * If req_cnt is bigger than fifo size only the last bytes are stored.
+ */
+void circfifo_ow_in(circfifo_ow_t *fifo, const void *buff, unsigned long req_cnt);
+
+/**
+ * Function reads bytes from fifo, if the consumer was overrun it continues
+ * from the oldest byte which is still available and increases fifo->out.lost
+ * \return Number of bytes written into buff
+ */
+unsigned long circfifo_ow_out(circfifo_ow_t *fifo, void *buff, unsigned long req_cnt);
+
+/**
+ * Function writes the record into fifo, discarding the oldest whole records
+ * if needed. Record with its header has to fit in the fifo.
+ */
+void circfifo_ow_rec_in(circfifo_ow_t *fifo, const void *buff, unsigned len);
+
+/**
+ * Function reads the next record which was not overwritten, bytes of skipped
+ * records (with headers) are counted in fifo->out.lost. If record is longer
+ * than size it stays in the fifo.
+ * \return length of the record or -1 if fifo is empty
+ */
+long circfifo_ow_rec_out(circfifo_ow_t *fifo, void *buff, unsigned size);
+
+/**
+ * \return number of bytes lost by consumer, can be called from any thread
+ */
+static inline unsigned long circfifo_ow_lost(const circfifo_ow_t *fifo)
+{
+   return __atomic_load_n(&fifo->out.lost, __ATOMIC_RELAXED);
+}
+
+#endif /* __CIRCFIFO_OW_H_ */
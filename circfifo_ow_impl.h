@@ -0,0 +1,100 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Buffer copies and overrun protocol shared by the overwrite fifo
+ * (circfifo_ow.c) and by the broadcast fifo in CIRCFIFO_BCAST_DROP mode
+ * (circfifo_bcast.c). Positions are free running, buffer index is position
+ * masked with mask (size - 1). Producer moves tail, the position of the oldest
+ * byte which is not overwritten, before it overwrites anything, consumer
+ * copies the data and then checks that tail did not pass the position it was
+ * copying from. Do not include directly.
+ */
+
+#ifndef __CIRCFIFO_OW_IMPL_H_
+#define __CIRCFIFO_OW_IMPL_H_ 1
+
+#include "gmacros.h"
+
+/* copies n bytes into buffer at position pos */
+static inline void circfifo_ow_put(uint8_t *buff, unsigned long mask, unsigned long pos,
+                                   const uint8_t *src, unsigned long n)
+{
+   unsigned long idx = pos & mask;
+   unsigned long first = min(n, mask + 1 - idx);
+
+   memcpy(&buff[idx], src, first);
+   memcpy(buff, &src[first], n - first);
+}
+
+/* copies n bytes from buffer at position pos, data can be torn if producer
+ * overwrites it meanwhile, what the caller checks afterwards */
+static inline void circfifo_ow_get(const uint8_t *buff, unsigned long mask, unsigned long pos,
+                                   uint8_t *dst, unsigned long n)
+{
+   unsigned long idx = pos & mask;
+   unsigned long first = min(n, mask + 1 - idx);
+
+   memcpy(dst, &buff[idx], first);
+   memcpy(&dst[first], buff, n - first);
+}
+
+/* publishes the new tail before the data behind it is overwritten, pairs with
+ * the acquire fence in circfifo_ow_valid() */
+static inline void circfifo_ow_set_tail(unsigned long *tail_ptr, unsigned long tail)
+{
+   __atomic_store_n(tail_ptr, tail, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/* checks if data copied from position pos were not overwritten meanwhile */
+static inline bool circfifo_ow_valid(const unsigned long *tail_ptr, unsigned long pos)
+{
+   __atomic_thread_fence(__ATOMIC_ACQUIRE);
+   return (long)(pos - __atomic_load_n(tail_ptr, __ATOMIC_RELAXED)) >= 0;
+}
+
+/* moves the consumer position rd to tail if it was overrun, skipped bytes are
+ * added to lost counter of the consumer */
+static inline unsigned long circfifo_ow_catch_up(const unsigned long *tail_ptr,
+                                                 unsigned long *lost, unsigned long rd)
+{
+   unsigned long tail = __atomic_load_n(tail_ptr, __ATOMIC_RELAXED);
+
+   if( unlikely((long)(rd - tail) < 0) )
+   {
+      __atomic_store_n(lost, *lost + (tail - rd), __ATOMIC_RELAXED);
+      rd = tail;
+   }
+   return rd;
+}
+
+#endif /* __CIRCFIFO_OW_IMPL_H_ */
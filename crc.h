@@ -34,7 +34,63 @@
 
 #include "arch.h"
 
+/**
+ * Function updates CRC16 (polynomial 0x8005 in reflected form 0xA001, as used
+ * by MODBUS and USB) with content of given buffer. On architectures with
+ * runtime dispatch (ARCH_DISPATCH) the fastest variant supported by the CPU is
+ * used, all variants give bit exact results.
+ */
 uint16_t crc16_update(uint16_t crc, const void* buff, unsigned size);
 
+/** one message of crc16_update_multi() */
+typedef struct crc16_job_tag
+{
+   const void *buff;
+   unsigned size;
+   /** initial value, replaced by the result */
+   uint16_t crc;
+} crc16_job_t;
+
+/**
+ * Function computes CRC16 of many independent messages, each result is the
+ * same as of crc16_update() for the message. With ARCH_DISPATCH the messages
+ * of 16 - 127 bytes are processed in parallel SIMD lanes, one message per
+ * lane, what is faster than separate calls. Other messages are passed to
+ * crc16_update().
+ */
+void crc16_update_multi(crc16_job_t *jobs, unsigned cnt);
+
+/* implementation variants, to be used directly only for tests and benchmarks */
+uint16_t crc16_update_bitwise(uint16_t crc, const void* buff, unsigned size);
+#ifdef ARCH_DISPATCH
+uint16_t crc16_update_slice8(uint16_t crc, const void* buff, unsigned size);
+void crc16_update_multi_scalar(crc16_job_t *jobs, unsigned cnt);
+
+/** maximal number of lanes of crc16_update_multi_lanes() */
+#define CRC16_MULTI_LANES_MAX 64
+
+/**
+ * Lane kernel, updates CRC of each lane i with blocks * 16 bytes at ptr[i],
+ * CRC of lane i is crc_lo[i] | (crc_hi[i] << 8).
+ */
+typedef void (*crc16_multi_kernel_t)(const uint8_t *const *ptr, uint8_t *crc_lo,
+                                     uint8_t *crc_hi, unsigned blocks);
+
+/**
+ * Function schedules messages into lanes of kernel, messages with the same
+ * number of blocks wait until all lanes can be filled. Lanes start with zero
+ * bytes instead of the incomplete block, so there is no scalar tail. Messages
+ * shorter than one block or long enough for folding go directly to
+ * crc16_update().
+ */
+void crc16_update_multi_lanes(crc16_job_t *jobs, unsigned cnt, unsigned lanes,
+                              crc16_multi_kernel_t kernel);
+#if defined(__x86_64__) || defined(__i386__)
+uint16_t crc16_update_pclmul(uint16_t crc, const void* buff, unsigned size);
+void crc16_update_multi_avx2(crc16_job_t *jobs, unsigned cnt);
+void crc16_update_multi_avx512(crc16_job_t *jobs, unsigned cnt);
+#endif
+#endif
+
 #endif /* __CRC_H_ */
 
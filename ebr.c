@@ -0,0 +1,167 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sched.h>
+#include "ebr.h"
+
+/* epoch is kept in state word shifted by one, so only 31 bits are compared */
+#define EBR_EPOCH_MASK (~0u >> 1)
+
+void ebr_init(ebr_t *ebr)
+{
+   ebr->epoch = 0;
+   ebr->threads = NULL;
+}
+
+void ebr_register(ebr_t *ebr, ebr_thread_t *thr)
+{
+   if( thr->ebr == ebr )
+   {
+      /* record is already on the list, reuse it */
+      assert(!thr->online);
+      thr->online = true;
+      return;
+   }
+
+   memset(thr, 0, sizeof(*thr));
+   thr->ebr = ebr;
+   thr->online = true;
+   thr->next = __atomic_load_n(&ebr->threads, __ATOMIC_RELAXED);
+   while( !__atomic_compare_exchange_n(&ebr->threads, &thr->next, thr, true,
+                                       __ATOMIC_RELEASE, __ATOMIC_RELAXED) );
+}
+
+void ebr_unregister(ebr_thread_t *thr)
+{
+   ebr_synchronize(thr);
+   thr->online = false;
+}
+
+/* reclaims the lists of objects retired at least two epochs before */
+static unsigned ebr_collect(ebr_thread_t *thr, unsigned epoch)
+{
+   unsigned i;
+   unsigned pending = 0;
+
+   for( i = 0; i < 3; i++ )
+   {
+      ebr_node_t *node = thr->limbo[i];
+
+      if( NULL == node )
+      {
+         continue;
+      }
+      if( ((epoch - thr->limbo_epoch[i]) & EBR_EPOCH_MASK) < 2 )
+      {
+         pending++;
+         continue;
+      }
+      thr->limbo[i] = NULL;
+      while( NULL != node )
+      {
+         ebr_node_t *next = node->next;
+         node->reclaim(node);
+         node = next;
+      }
+   }
+
+   return pending;
+}
+
+bool ebr_advance(ebr_t *ebr)
+{
+   ebr_thread_t *thr;
+   unsigned epoch;
+
+   /* full barrier, pairs with the exchange in ebr_enter(), either we see the
+    * announcement or the reader sees the object already unlinked. It is
+    * a read-modify-write instead of a fence which ThreadSanitizer does not
+    * support. */
+   epoch = __atomic_fetch_add(&ebr->epoch, 0, __ATOMIC_SEQ_CST);
+
+   for( thr = __atomic_load_n(&ebr->threads, __ATOMIC_ACQUIRE);
+        NULL != thr;
+        thr = thr->next )
+   {
+      unsigned state = __atomic_load_n(&thr->state, __ATOMIC_ACQUIRE);
+
+      if( (state & 1) && (((state >> 1) ^ epoch) & EBR_EPOCH_MASK) )
+      {
+         return false;
+      }
+   }
+
+   return __atomic_compare_exchange_n(&ebr->epoch, &epoch, (epoch + 1) & EBR_EPOCH_MASK,
+                                      false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+void ebr_retire(ebr_thread_t *thr, ebr_node_t *node, void (*reclaim)(ebr_node_t *node))
+{
+   unsigned epoch = __atomic_load_n(&thr->ebr->epoch, __ATOMIC_ACQUIRE);
+   unsigned idx;
+
+   /* after collect only lists of current and previous epoch remain, so there
+    * is either the list of current epoch or at least one empty list */
+   ebr_collect(thr, epoch);
+   for( idx = 0; idx < 3; idx++ )
+   {
+      if( (NULL != thr->limbo[idx]) && (thr->limbo_epoch[idx] == epoch) )
+      {
+         break;
+      }
+   }
+   if( 3 == idx )
+   {
+      for( idx = 0; NULL != thr->limbo[idx]; idx++ );
+   }
+
+   node->reclaim = reclaim;
+   node->next = thr->limbo[idx];
+   thr->limbo[idx] = node;
+   thr->limbo_epoch[idx] = epoch;
+
+   if( ++thr->retired >= EBR_BATCH )
+   {
+      thr->retired = 0;
+      ebr_advance(thr->ebr);
+   }
+}
+
+void ebr_synchronize(ebr_thread_t *thr)
+{
+   while( ebr_collect(thr, __atomic_load_n(&thr->ebr->epoch, __ATOMIC_ACQUIRE)) )
+   {
+      if( !ebr_advance(thr->ebr) )
+      {
+         sched_yield();
+      }
+   }
+}
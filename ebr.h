@@ -0,0 +1,142 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __EBR_H_
+#define __EBR_H_ 1
+
+#include "arch.h"
+#include "gmacros.h"
+
+/*
+ * Epoch based reclamation of memory shared by lock-free data structures.
+ *
+ * Readers wrap each access to the shared structure with ebr_enter() and
+ * ebr_exit(), what costs one exchange of the thread's own state word (the
+ * same full barrier as a fence, without contention). Writer which unlinked
+ * the object passes it to ebr_retire(), the object is reclaimed when the global epoch advanced twice,
+ * what guarantees that no reader still holds the reference to it.
+ *
+ * Each thread which accesses the structure uses its own ebr_thread_t
+ * registered in ebr_t. Registration record is caller provided and once
+ * registered it stays on the list of records until the ebr_t is no longer
+ * used, it can be registered again after ebr_unregister() (for instance by
+ * next worker thread which reuses the slot). Record has to be zero initialized
+ * before first registration.
+ */
+
+/** retired objects per thread after which the thread tries to advance epoch */
+#define EBR_BATCH 64
+
+typedef struct ebr_node_tag {
+   struct ebr_node_tag *next;
+   /** called when object is no longer referenced by any reader */
+   void (*reclaim)(struct ebr_node_tag *node);
+} ebr_node_t;
+
+struct ebr_tag;
+
+typedef struct ebr_thread_tag {
+   /** (epoch << 1) | 1 when in critical section, 0 otherwise */
+   unsigned state;
+   /** objects retired by this thread, one list for each of last 3 epochs */
+   ebr_node_t *limbo[3];
+   unsigned limbo_epoch[3];
+   unsigned retired;
+   bool online;
+   struct ebr_tag *ebr;
+   struct ebr_thread_tag *next;
+} cacheline_aligned ebr_thread_t;
+
+typedef struct ebr_tag {
+   unsigned epoch;
+   ebr_thread_t *threads;
+} ebr_t;
+
+void ebr_init(ebr_t *ebr);
+
+/**
+ * Function registers the thread record, has to be called by each thread
+ * before first ebr_enter()
+ */
+void ebr_register(ebr_t *ebr, ebr_thread_t *thr);
+
+/**
+ * Function waits until all objects retired by the thread are reclaimed and
+ * marks the record as unused. Must not be called from critical section.
+ */
+void ebr_unregister(ebr_thread_t *thr);
+
+/**
+ * Start of critical section, references to shared objects obtained inside the
+ * critical section are valid until ebr_exit(). Critical sections do not nest.
+ */
+static inline void ebr_enter(ebr_thread_t *thr)
+{
+   unsigned epoch = __atomic_load_n(&thr->ebr->epoch, __ATOMIC_RELAXED);
+
+   /* announcement has to be visible before any load from shared structure,
+    * exchange is a full barrier (also understood by ThreadSanitizer unlike
+    * the fence) */
+   (void)__atomic_exchange_n(&thr->state, (epoch << 1) | 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * End of critical section
+ */
+static inline void ebr_exit(ebr_thread_t *thr)
+{
+   __atomic_store_n(&thr->state, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Function defers the reclamation of object which was already unlinked from
+ * shared structure, can be called inside and outside of critical section
+ *
+ * @param thr Record of calling thread
+ * @param node Node embedded in retired object
+ * @param reclaim Function which frees the object
+ */
+void ebr_retire(ebr_thread_t *thr, ebr_node_t *node, void (*reclaim)(ebr_node_t *node));
+
+/**
+ * Function tries to advance the global epoch, it succeeds only if all threads
+ * which are in critical section observed the current epoch.
+ * \return true if epoch was advanced
+ */
+bool ebr_advance(ebr_t *ebr);
+
+/**
+ * Function waits until all objects retired by calling thread are reclaimed.
+ * Must not be called from critical section.
+ */
+void ebr_synchronize(ebr_thread_t *thr);
+
+#endif /* __EBR_H_ */
@@ -0,0 +1,202 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __FASTDIV_H_
+#define __FASTDIV_H_ 1
+
+#include "arch.h"
+
+/*
+ * Division by runtime invariant divisor with multiplication and shift, the
+ * method of libdivide (round up magic number with optional add step).
+ *
+ * fastdiv_uN_init() computes the magic number once (it uses the slow
+ * division), then fastdiv_uN_div(), _mod(), _ceil_div() and _divisible() take
+ * one high half multiplication and few shifts instead of the hardware divide
+ * (20 - 90 cycles for 64 bit on x86) or software routine on AVR. Use them for
+ * block sizes, bucket counts and similar values which are known only at
+ * runtime but are used in hot loops. For divisors which are constant at
+ * compile time keep the plain / and % (or ceil_div() from gmacros.h), the
+ * compiler already emits the same multiplication for them.
+ *
+ * Variants for 8, 16, 32 and 64 bit unsigned operands, the product of high
+ * half multiplication has double width (on 64 bit targets unsigned __int128,
+ * otherwise composed from 32 bit products).
+ */
+
+/** more field: shift in low bits, flag of the add step */
+#define FASTDIV_SHIFT_MASK 0x3F
+#define FASTDIV_ADD 0x40
+
+/* floor(2^p / d) for quotients which fit in 64 bits, p < 128 */
+static inline uint64_t __fastdiv_pow2_div(unsigned p, uint64_t d, uint64_t *rem)
+{
+   uint64_t q = 0;
+   uint64_t r = 0;
+   int i;
+
+   if( p < 64 )
+   {
+      *rem = ((uint64_t)1 << p) % d;
+      return ((uint64_t)1 << p) / d;
+   }
+   /* long division bit by bit, r may need 65 bits before subtraction */
+   for( i = p; i >= 0; i-- )
+   {
+      uint64_t carry = r >> 63;
+
+      r = (r << 1) | (i == (int)p);
+      q <<= 1;
+      if( carry || (r >= d) )
+      {
+         r -= d;
+         q |= 1;
+      }
+   }
+   *rem = r;
+   return q;
+}
+
+static inline uint8_t __fastdiv_mulhi_u8(uint8_t a, uint8_t b)
+{
+   return ((uint16_t)a * b) >> 8;
+}
+
+static inline uint16_t __fastdiv_mulhi_u16(uint16_t a, uint16_t b)
+{
+   return ((uint32_t)a * b) >> 16;
+}
+
+static inline uint32_t __fastdiv_mulhi_u32(uint32_t a, uint32_t b)
+{
+   return ((uint64_t)a * b) >> 32;
+}
+
+static inline uint64_t __fastdiv_mulhi_u64(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+   return ((unsigned __int128)a * b) >> 64;
+#else
+   uint64_t lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+   uint64_t mid1 = (a >> 32) * (b & 0xFFFFFFFF);
+   uint64_t mid2 = (a & 0xFFFFFFFF) * (b >> 32);
+   uint64_t mid = (lo >> 32) + (mid1 & 0xFFFFFFFF) + (mid2 & 0xFFFFFFFF);
+
+   return (a >> 32) * (b >> 32) + (mid1 >> 32) + (mid2 >> 32) + (mid >> 32);
+#endif
+}
+
+#define FASTDIV_DEFINE(_bits) \
+\
+typedef struct fastdiv_u##_bits##_tag \
+{ \
+   uint##_bits##_t magic; \
+   uint##_bits##_t d; \
+   uint8_t more; \
+} fastdiv_u##_bits##_t; \
+\
+static inline void fastdiv_u##_bits##_init(fastdiv_u##_bits##_t *fd, uint##_bits##_t d) \
+{ \
+   unsigned l = 0; \
+   uint64_t rem; \
+   uint##_bits##_t m; \
+\
+   assert(0 != d); \
+   while( (d >> l) > 1 ) \
+   { \
+      l++; \
+   } \
+   fd->d = d; \
+   if( 0 == (d & (d - 1)) ) \
+   { \
+      /* power of 2, only shift */ \
+      fd->magic = 0; \
+      fd->more = l; \
+      return; \
+   } \
+   m = __fastdiv_pow2_div(_bits + l, d, &rem); \
+   if( d - rem < ((uint64_t)1 << l) ) \
+   { \
+      fd->more = l; \
+   } \
+   else \
+   { \
+      /* magic needs one more bit, it is added by the add step */ \
+      m += m; \
+      if( (2 * rem >= d) || (2 * rem < rem) ) \
+      { \
+         m++; \
+      } \
+      fd->more = l | FASTDIV_ADD; \
+   } \
+   fd->magic = m + 1; \
+} \
+\
+static inline uint##_bits##_t fastdiv_u##_bits##_div(const fastdiv_u##_bits##_t *fd, uint##_bits##_t n) \
+{ \
+   uint##_bits##_t q; \
+\
+   if( 0 == fd->magic ) \
+   { \
+      return n >> fd->more; \
+   } \
+   q = __fastdiv_mulhi_u##_bits(fd->magic, n); \
+   if( fd->more & FASTDIV_ADD ) \
+   { \
+      uint##_bits##_t t = ((uint##_bits##_t)(n - q) >> 1) + q; \
+      return t >> (fd->more & FASTDIV_SHIFT_MASK); \
+   } \
+   return q >> fd->more; \
+} \
+\
+static inline uint##_bits##_t fastdiv_u##_bits##_mod(const fastdiv_u##_bits##_t *fd, uint##_bits##_t n) \
+{ \
+   return n - fastdiv_u##_bits##_div(fd, n) * fd->d; \
+} \
+\
+static inline uint##_bits##_t fastdiv_u##_bits##_ceil_div(const fastdiv_u##_bits##_t *fd, uint##_bits##_t n) \
+{ \
+   uint##_bits##_t q = fastdiv_u##_bits##_div(fd, n); \
+\
+   return q + (n != (uint##_bits##_t)(q * fd->d)); \
+} \
+\
+static inline bool fastdiv_u##_bits##_divisible(const fastdiv_u##_bits##_t *fd, uint##_bits##_t n) \
+{ \
+   return n == (uint##_bits##_t)(fastdiv_u##_bits##_div(fd, n) * fd->d); \
+}
+
+FASTDIV_DEFINE(8)
+FASTDIV_DEFINE(16)
+FASTDIV_DEFINE(32)
+FASTDIV_DEFINE(64)
+
+#endif /* __FASTDIV_H_ */
@@ -0,0 +1,489 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "framing.h"
+#include "crc.h"
+#include "gmacros.h"
+
+/* stores n bytes in out at offset ofs after the write index, the data is not
+ * visible to the consumer until circfifo_wr_commit() */
+static void framing_put(circfifo_t *out, unsigned ofs, const uint8_t *src, unsigned n)
+{
+   unsigned pos = out->wr + ofs;
+   unsigned first;
+
+   pos -= (pos >= (unsigned)out->size) ? out->size : 0;
+   first = min(n, out->size - pos);
+   memcpy(&out->buff[pos], src, first);
+   memcpy(out->buff, &src[first], n - first);
+}
+
+static void framing_put_byte(circfifo_t *out, unsigned ofs, uint8_t byte)
+{
+   unsigned pos = out->wr + ofs;
+
+   pos -= (pos >= (unsigned)out->size) ? out->size : 0;
+   out->buff[pos] = byte;
+}
+
+typedef unsigned (*framing_encode_t)(void *enc, circfifo_t *out, const void *buff, unsigned size);
+
+/* feeds encoder with both regions of input fifo */
+static unsigned framing_encode_fifo(framing_encode_t encode, void *enc, circfifo_t *out, circfifo_t *in)
+{
+   unsigned total = 0;
+   unsigned avail, used;
+   uint8_t *ptr;
+
+   while( 0 != (avail = circfifo_rd_region(in, &ptr)) )
+   {
+      used = encode(enc, out, ptr, avail);
+      circfifo_rd_commit(in, used);
+      total += used;
+      if( used < avail )
+      {
+         break;
+      }
+   }
+
+   return total;
+}
+
+static void framing_dec_init(framing_dec_t *dec, bool use_crc)
+{
+   dec->len = 0;
+   dec->crc = FRAMING_CRC_INIT;
+   dec->use_crc = use_crc;
+   dec->started = false;
+   dec->discard = false;
+}
+
+/* returns number of payload bytes which can be stored now, drops the frame if
+ * it will not fit in the output fifo at all */
+static unsigned framing_dec_room(framing_dec_t *dec, const circfifo_t *out)
+{
+   unsigned space;
+
+   if( !dec->discard && (dec->len >= (unsigned)out->size - 1) )
+   {
+      dec->discard = true;
+   }
+   if( dec->discard )
+   {
+      return ~0u;
+   }
+   space = circfifo_space(out);
+   return (space > dec->len) ? space - dec->len : 0;
+}
+
+static void framing_dec_put(framing_dec_t *dec, circfifo_t *out, const uint8_t *src, unsigned n)
+{
+   if( dec->discard )
+   {
+      return;
+   }
+   framing_put(out, dec->len, src, n);
+   if( dec->use_crc )
+   {
+      dec->crc = crc16_update(dec->crc, src, n);
+   }
+   dec->len += n;
+}
+
+/* end of frame, commits the payload if frame is valid */
+static int framing_dec_end(framing_dec_t *dec, circfifo_t *out, bool valid)
+{
+   int ret = FRAMING_ERROR;
+
+   if( !dec->started )
+   {
+      /* consecutive delimiters, no frame */
+      return FRAMING_MORE;
+   }
+   if( valid && !dec->discard )
+   {
+      if( !dec->use_crc )
+      {
+         circfifo_wr_commit(out, dec->len);
+         ret = FRAMING_FRAME;
+      }
+      else if( (dec->len >= 2) && (0 == dec->crc) )
+      {
+         /* CRC over payload followed by its CRC is 0, CRC is not committed */
+         circfifo_wr_commit(out, dec->len - 2);
+         ret = FRAMING_FRAME;
+      }
+   }
+   framing_dec_init(dec, dec->use_crc);
+
+   return ret;
+}
+
+void cobs_enc_init(cobs_enc_t *enc, bool use_crc)
+{
+   enc->crc = FRAMING_CRC_INIT;
+   enc->use_crc = use_crc;
+   /* empty frame is encoded as one empty block */
+   enc->code = 1;
+}
+
+/* stores the code byte and makes the block visible to the consumer */
+static void cobs_close(cobs_enc_t *enc, circfifo_t *out)
+{
+   framing_put_byte(out, 0, enc->code);
+   circfifo_wr_commit(out, enc->code);
+   enc->code = 0;
+}
+
+unsigned cobs_encode(cobs_enc_t *enc, circfifo_t *out, const void *buff, unsigned size)
+{
+   const uint8_t *p = buff;
+   const uint8_t *end = p + size;
+   const uint8_t *zero;
+   unsigned space = circfifo_space(out);
+   unsigned run;
+
+   assert(out->size >= COBS_FIFO_MIN);
+
+   while( p < end )
+   {
+      if( 0 == enc->code )
+      {
+         /* previous block was full, open the next one */
+         if( space < 1 )
+         {
+            break;
+         }
+         enc->code = 1;
+      }
+
+      /* copy the run of non zero bytes up to the end of block */
+      run = min(min((unsigned)(end - p), COBS_BLOCK_MAX + 1u - enc->code), space - enc->code);
+      if( 0 == run )
+      {
+         break;
+      }
+      zero = circfifo_scan(p, run, 0);
+      if( NULL != zero )
+      {
+         run = zero - p;
+      }
+      if( run > 0 )
+      {
+         framing_put(out, enc->code, p, run);
+         if( enc->use_crc )
+         {
+            enc->crc = crc16_update(enc->crc, p, run);
+         }
+         enc->code += run;
+         p += run;
+      }
+
+      if( NULL != zero )
+      {
+         /* zero byte closes the block, code byte of the next one is needed */
+         space -= enc->code;
+         cobs_close(enc, out);
+         enc->code = 1;
+         if( enc->use_crc )
+         {
+            enc->crc = crc16_update(enc->crc, p, 1);
+         }
+         p++;
+      }
+      else if( (COBS_BLOCK_MAX + 1) == enc->code )
+      {
+         space -= enc->code;
+         cobs_close(enc, out);
+      }
+   }
+
+   return p - (const uint8_t*)buff;
+}
+
+static unsigned cobs_encode_any(void *enc, circfifo_t *out, const void *buff, unsigned size)
+{
+   return cobs_encode(enc, out, buff, size);
+}
+
+unsigned cobs_encode_fifo(cobs_enc_t *enc, circfifo_t *out, circfifo_t *in)
+{
+   return framing_encode_fifo(cobs_encode_any, enc, out, in);
+}
+
+bool cobs_encode_end(cobs_enc_t *enc, circfifo_t *out)
+{
+   uint8_t crc[2];
+
+   /* worst case: open block, 2 CRC bytes, code byte of the next block and
+    * the delimiter */
+   if( circfifo_space(out) < (unsigned)enc->code + 5 )
+   {
+      return false;
+   }
+   if( enc->use_crc )
+   {
+      crc[0] = (uint8_t)enc->crc;
+      crc[1] = (uint8_t)(enc->crc >> 8);
+      (void)cobs_encode(enc, out, crc, sizeof(crc));
+   }
+   if( 0 != enc->code )
+   {
+      cobs_close(enc, out);
+   }
+   framing_put_byte(out, 0, 0);
+   circfifo_wr_commit(out, 1);
+   cobs_enc_init(enc, enc->use_crc);
+
+   return true;
+}
+
+void cobs_dec_init(cobs_dec_t *dec, bool use_crc)
+{
+   framing_dec_init(&dec->frame, use_crc);
+   dec->left = 0;
+   dec->zero = false;
+}
+
+int cobs_decode(cobs_dec_t *dec, circfifo_t *out, circfifo_t *in)
+{
+   static const uint8_t zero_byte = 0;
+   int ret = FRAMING_MORE;
+   const uint8_t *zero;
+   unsigned avail, i, run, room;
+   uint8_t *p;
+
+   while( (FRAMING_MORE == ret) && (0 != (avail = circfifo_rd_region(in, &p))) )
+   {
+      for( i = 0; i < avail; )
+      {
+         if( 0 == p[i] )
+         {
+            /* delimiter, frame is valid only if the last block is complete */
+            i++;
+            ret = framing_dec_end(&dec->frame, out, 0 == dec->left);
+            dec->left = 0;
+            dec->zero = false;
+            if( FRAMING_MORE != ret )
+            {
+               break;
+            }
+            continue;
+         }
+
+         room = framing_dec_room(&dec->frame, out);
+         if( 0 == dec->left )
+         {
+            /* code byte, zero implied by previous block goes first */
+            if( dec->zero )
+            {
+               if( 0 == room )
+               {
+                  break;
+               }
+               framing_dec_put(&dec->frame, out, &zero_byte, 1);
+            }
+            dec->left = p[i] - 1;
+            dec->zero = (COBS_BLOCK_MAX + 1) != p[i];
+            dec->frame.started = true;
+            i++;
+            continue;
+         }
+
+         /* data of the block, unexpected zero terminates the frame */
+         run = min(min((unsigned)dec->left, avail - i), room);
+         if( 0 == run )
+         {
+            break;
+         }
+         zero = circfifo_scan(&p[i], run, 0);
+         if( NULL != zero )
+         {
+            run = zero - &p[i];
+         }
+         framing_dec_put(&dec->frame, out, &p[i], run);
+         dec->left -= run;
+         i += run;
+      }
+      circfifo_rd_commit(in, i);
+      if( i < avail )
+      {
+         break;
+      }
+   }
+
+   return ret;
+}
+
+void slip_enc_init(slip_enc_t *enc, bool use_crc)
+{
+   enc->crc = FRAMING_CRC_INIT;
+   enc->use_crc = use_crc;
+}
+
+unsigned slip_encode(slip_enc_t *enc, circfifo_t *out, const void *buff, unsigned size)
+{
+   const uint8_t *p = buff;
+   unsigned space = circfifo_space(out);
+   unsigned ofs = 0;
+   unsigned i;
+
+   for( i = 0; i < size; i++ )
+   {
+      if( (SLIP_END == p[i]) || (SLIP_ESC == p[i]) )
+      {
+         if( space - ofs < 2 )
+         {
+            break;
+         }
+         framing_put_byte(out, ofs++, SLIP_ESC);
+         framing_put_byte(out, ofs++, (SLIP_END == p[i]) ? SLIP_ESC_END : SLIP_ESC_ESC);
+      }
+      else
+      {
+         if( space - ofs < 1 )
+         {
+            break;
+         }
+         framing_put_byte(out, ofs++, p[i]);
+      }
+   }
+   if( enc->use_crc )
+   {
+      enc->crc = crc16_update(enc->crc, p, i);
+   }
+   circfifo_wr_commit(out, ofs);
+
+   return i;
+}
+
+static unsigned slip_encode_any(void *enc, circfifo_t *out, const void *buff, unsigned size)
+{
+   return slip_encode(enc, out, buff, size);
+}
+
+unsigned slip_encode_fifo(slip_enc_t *enc, circfifo_t *out, circfifo_t *in)
+{
+   return framing_encode_fifo(slip_encode_any, enc, out, in);
+}
+
+bool slip_encode_end(slip_enc_t *enc, circfifo_t *out)
+{
+   uint8_t crc[2];
+
+   /* worst case: 2 escaped CRC bytes and SLIP_END */
+   if( circfifo_space(out) < 5 )
+   {
+      return false;
+   }
+   if( enc->use_crc )
+   {
+      crc[0] = (uint8_t)enc->crc;
+      crc[1] = (uint8_t)(enc->crc >> 8);
+      (void)slip_encode(enc, out, crc, sizeof(crc));
+   }
+   framing_put_byte(out, 0, SLIP_END);
+   circfifo_wr_commit(out, 1);
+   slip_enc_init(enc, enc->use_crc);
+
+   return true;
+}
+
+void slip_dec_init(slip_dec_t *dec, bool use_crc)
+{
+   framing_dec_init(&dec->frame, use_crc);
+   dec->esc = false;
+}
+
+int slip_decode(slip_dec_t *dec, circfifo_t *out, circfifo_t *in)
+{
+   int ret = FRAMING_MORE;
+   unsigned avail, i, run, room;
+   uint8_t *p;
+   uint8_t byte;
+
+   while( (FRAMING_MORE == ret) && (0 != (avail = circfifo_rd_region(in, &p))) )
+   {
+      for( i = 0; i < avail; )
+      {
+         if( SLIP_END == p[i] )
+         {
+            /* frame cannot end in the middle of escape sequence */
+            i++;
+            ret = framing_dec_end(&dec->frame, out, !dec->esc);
+            dec->esc = false;
+            if( FRAMING_MORE != ret )
+            {
+               break;
+            }
+            continue;
+         }
+
+         dec->frame.started = true;
+         room = framing_dec_room(&dec->frame, out);
+         if( 0 == room )
+         {
+            break;
+         }
+         if( dec->esc )
+         {
+            if( (SLIP_ESC_END != p[i]) && (SLIP_ESC_ESC != p[i]) )
+            {
+               dec->frame.discard = true;
+            }
+            byte = (SLIP_ESC_END == p[i]) ? SLIP_END : SLIP_ESC;
+            framing_dec_put(&dec->frame, out, &byte, 1);
+            dec->esc = false;
+            i++;
+            continue;
+         }
+         if( SLIP_ESC == p[i] )
+         {
+            dec->esc = true;
+            i++;
+            continue;
+         }
+
+         /* run of bytes which do not need decoding */
+         for( run = 1; (run < room) && (i + run < avail) &&
+                       (SLIP_END != p[i + run]) && (SLIP_ESC != p[i + run]); run++ );
+         framing_dec_put(&dec->frame, out, &p[i], run);
+         i += run;
+      }
+      circfifo_rd_commit(in, i);
+      if( i < avail )
+      {
+         break;
+      }
+   }
+
+   return ret;
+}
@@ -0,0 +1,186 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __FRAMING_H_
+#define __FRAMING_H_ 1
+
+#include "arch.h"
+#include "circfifo.h"
+
+/**
+ * Streaming COBS and SLIP framing stages working directly on circfifo_t.
+ *
+ * Encoders take the payload from linear buffer or from input fifo and store
+ * encoded data in the output fifo, the frame is finished by *_encode_end().
+ * Decoders take encoded stream from input fifo and store payload of the frame
+ * in the output fifo. All functions process as much as possible and return,
+ * so they can be called again when more data or more space is available.
+ *
+ * With use_crc, encoder appends CRC16 of the payload (crc16_update() with
+ * initial value FRAMING_CRC_INIT, LSB first) before the end of frame and
+ * decoder checks and removes it.
+ *
+ * The stage has to be the only producer of its output fifo, because data is
+ * built in place after the write index and committed when it is complete.
+ * Decoders commit the payload only when the whole frame was received and is
+ * valid, so frame has to fit in the output fifo, longer frames are dropped.
+ * Empty SLIP frames are ignored, so SLIP_END can be sent before a frame to
+ * flush line noise as RFC 1055 suggests.
+ */
+
+/** initial value of frame CRC */
+#define FRAMING_CRC_INIT ((uint16_t)0xFFFF)
+
+/** maximal number of data bytes in one COBS block */
+#define COBS_BLOCK_MAX 254
+
+/** COBS encoder builds the whole block in the output fifo before commit, so
+ *  the fifo has to be at least this size */
+#define COBS_FIFO_MIN (COBS_BLOCK_MAX + 2)
+
+#define SLIP_END ((uint8_t)0xC0)
+#define SLIP_ESC ((uint8_t)0xDB)
+#define SLIP_ESC_END ((uint8_t)0xDC)
+#define SLIP_ESC_ESC ((uint8_t)0xDD)
+
+/** decoder results */
+typedef enum {
+   /** frame was dropped (malformed, wrong CRC or too long) */
+   FRAMING_ERROR = -1,
+   /** input consumed or output fifo full, call again */
+   FRAMING_MORE = 0,
+   /** whole frame payload was committed into the output fifo */
+   FRAMING_FRAME = 1,
+} framing_status_t;
+
+/** decoder state common for COBS and SLIP */
+typedef struct framing_dec_tag
+{
+   /** payload bytes stored but not yet committed in output fifo */
+   unsigned len;
+   uint16_t crc;
+   bool use_crc;
+   /** any byte of the frame was received */
+   bool started;
+   /** frame is dropped, skip input until end of frame */
+   bool discard;
+} framing_dec_t;
+
+typedef struct cobs_enc_tag
+{
+   uint16_t crc;
+   bool use_crc;
+   /** code byte of open block (bytes stored after the write index, including
+    *  the code byte itself) or 0 if there is no open block */
+   uint8_t code;
+} cobs_enc_t;
+
+typedef struct cobs_dec_tag
+{
+   framing_dec_t frame;
+   /** data bytes left in current block, 0 if code byte is expected */
+   uint8_t left;
+   /** current block implies zero byte after its data */
+   bool zero;
+} cobs_dec_t;
+
+typedef struct slip_enc_tag
+{
+   uint16_t crc;
+   bool use_crc;
+} slip_enc_t;
+
+typedef struct slip_dec_tag
+{
+   framing_dec_t frame;
+   /** last byte was SLIP_ESC */
+   bool esc;
+} slip_dec_t;
+
+void cobs_enc_init(cobs_enc_t *enc, bool use_crc);
+
+/**
+ * Function encodes payload data from buff into the output fifo
+ * \return number of bytes consumed from buff
+ */
+unsigned cobs_encode(cobs_enc_t *enc, circfifo_t *out, const void *buff, unsigned size);
+
+/**
+ * Function encodes payload data taken from input fifo into the output fifo
+ * \return number of bytes consumed from input fifo
+ */
+unsigned cobs_encode_fifo(cobs_enc_t *enc, circfifo_t *out, circfifo_t *in);
+
+/**
+ * Function finishes the frame (CRC, last block and zero delimiter)
+ * \return false if there is not enough space in the output fifo, nothing was
+ *         written in that case
+ */
+bool cobs_encode_end(cobs_enc_t *enc, circfifo_t *out);
+
+void cobs_dec_init(cobs_dec_t *dec, bool use_crc);
+
+/**
+ * Function decodes data from input fifo, it returns after each frame
+ * \return one of framing_status_t
+ */
+int cobs_decode(cobs_dec_t *dec, circfifo_t *out, circfifo_t *in);
+
+void slip_enc_init(slip_enc_t *enc, bool use_crc);
+
+/**
+ * Function encodes payload data from buff into the output fifo
+ * \return number of bytes consumed from buff
+ */
+unsigned slip_encode(slip_enc_t *enc, circfifo_t *out, const void *buff, unsigned size);
+
+/**
+ * Function encodes payload data taken from input fifo into the output fifo
+ * \return number of bytes consumed from input fifo
+ */
+unsigned slip_encode_fifo(slip_enc_t *enc, circfifo_t *out, circfifo_t *in);
+
+/**
+ * Function finishes the frame (CRC and SLIP_END)
+ * \return false if there is not enough space in the output fifo, nothing was
+ *         written in that case
+ */
+bool slip_encode_end(slip_enc_t *enc, circfifo_t *out);
+
+void slip_dec_init(slip_dec_t *dec, bool use_crc);
+
+/**
+ * Function decodes data from input fifo, it returns after each frame
+ * \return one of framing_status_t
+ */
+int slip_decode(slip_dec_t *dec, circfifo_t *out, circfifo_t *in);
+
+#endif /* __FRAMING_H_ */
@@ -32,6 +32,9 @@
 #ifndef __LIST_H_
 #define __LIST_H_ 1
 
+#include "gmacros.h"
+#include "trace.h"
+
 /*
  * Extra fast implementation of doubly linked list
  * Some ideas coming from Linux's source code.
@@ -168,6 +171,283 @@ static inline list_t *list_detachfirst (const list_t *l)
    return elem;
 }
 
+/*
+ * Get the pointer to structure which embeds the list element.
+ */
+#define list_entry(_ptr, _type, _member) container_of(_ptr, _type, _member)
+
+/*
+ * Iteration over the list elements, the list must not be modified inside the
+ * loop. While the current element is processed the one after the next is
+ * prefetched, so walking over the long lists does not stall on each element.
+ * The next element was already prefetched in previous step, so reading its
+ * next pointer is cheap.
+ */
+#define list_for_each(_pos, _head) \
+   for( (_pos) = (_head)->next; \
+        prefetch((_pos)->next->next), (_pos) != (_head); \
+        (_pos) = (_pos)->next )
+
+/*
+ * Iteration which allows to unlink (or free) the current element inside the
+ * loop, _n is temporary list_t pointer.
+ */
+#define list_for_each_safe(_pos, _n, _head) \
+   for( (_pos) = (_head)->next, (_n) = (_pos)->next; \
+        prefetch((_n)->next), (_pos) != (_head); \
+        (_pos) = (_n), (_n) = (_pos)->next )
+
+/*
+ * Typed iteration over structures which embed the list element as _member.
+ * Same prefetching as in list_for_each.
+ */
+#define list_for_each_entry(_pos, _head, _member) \
+   for( (_pos) = list_entry((_head)->next, typeof(*(_pos)), _member); \
+        prefetch((_pos)->_member.next->next), &(_pos)->_member != (_head); \
+        (_pos) = list_entry((_pos)->_member.next, typeof(*(_pos)), _member) )
+
+/*
+ * Typed iteration which allows to unlink (or free) the current element inside
+ * the loop, _n is temporary pointer of the same type as _pos.
+ */
+#define list_for_each_entry_safe(_pos, _n, _head, _member) \
+   for( (_pos) = list_entry((_head)->next, typeof(*(_pos)), _member), \
+        (_n) = list_entry((_pos)->_member.next, typeof(*(_pos)), _member); \
+        prefetch((_n)->_member.next), &(_pos)->_member != (_head); \
+        (_pos) = (_n), \
+        (_n) = list_entry((_n)->_member.next, typeof(*(_pos)), _member) )
+
+/*
+ * Read-copy-update variants for lists which are read by many threads and
+ * modified rarely. Readers walk the list inside ebr_enter()/ebr_exit() of the
+ * ebr_t (ebr.h) which guards the list, without any lock or atomic
+ * read-modify-write, only the next pointers are followed. Writers serialize
+ * among themselves (by a lock of the caller) and publish the new element with
+ * a release store after it is fully initialized. The unlinked element keeps
+ * its next pointer, so the reader which stands on it continues the walk, and
+ * it can be freed or linked again only after the grace period, for instance
+ * from the reclaim callback of ebr_retire(). prev pointers are only for
+ * writers.
+ */
+
+/*
+ * Publishes elem between left and right, fields of elem (and the structure
+ * which embeds it) are visible to readers which see elem.
+ * Internal function.
+ */
+static inline void __list_rcu_put_in_between (list_t *elem, list_t *left, list_t *right)
+{
+	elem->next = right;
+	elem->prev = left;
+	__atomic_store_n(&left->next, elem, __ATOMIC_RELEASE);
+	right->prev = elem;
+}
+
+static inline void list_rcu_prepend (list_t *l, list_t *elem)
+{
+	__list_rcu_put_in_between (elem, l, l->next);
+}
+
+static inline void list_rcu_append (list_t *l, list_t *elem)
+{
+	__list_rcu_put_in_between (elem, l->prev, l);
+}
+
+static inline void list_rcu_put_after (list_t *itr, list_t *elem)
+{
+	__list_rcu_put_in_between (elem, itr, itr->next);
+}
+
+static inline void list_rcu_put_before (list_t *itr, list_t *elem)
+{
+	__list_rcu_put_in_between (elem, itr->prev, itr);
+}
+
+/*
+ * Removes the element for new readers, readers which already hold it can
+ * still follow its next pointer. Unlike list_unlink the element is not
+ * reinitialized, it has to be passed to ebr_retire() (or ebr_synchronize()
+ * has to be called) before reuse.
+ */
+static inline void list_rcu_unlink (list_t *elem)
+{
+	/* release also for the unlink, reader gets right from other location
+	 * than where it was published */
+	__atomic_store_n(&elem->prev->next, elem->next, __ATOMIC_RELEASE);
+	elem->next->prev = elem->prev;
+}
+
+/*
+ * Atomically replaces old by the updated copy elem, each reader sees either
+ * the old or the new version. old is retired as after list_rcu_unlink.
+ */
+static inline void list_rcu_replace (list_t *old, list_t *elem)
+{
+	elem->next = old->next;
+	elem->prev = old->prev;
+	__atomic_store_n(&old->prev->next, elem, __ATOMIC_RELEASE);
+	old->next->prev = elem;
+}
+
+/*
+ * Next element for the reader, pairs with the release store of writer so the
+ * content of the returned element is initialized.
+ */
+static inline list_t *list_rcu_next (const list_t *itr)
+{
+	return __atomic_load_n(&itr->next, __ATOMIC_ACQUIRE);
+}
+
+static inline bool list_rcu_is_empty (const list_t *l)
+{
+	return list_rcu_next(l) == l;
+}
+
+/*
+ * Reader side iteration, has to be inside the critical section. The list can
+ * be modified concurrently, the walk sees each element which stays in the
+ * list for the whole walk and may or may not see the concurrently added or
+ * removed ones.
+ */
+#define list_for_each_rcu(_pos, _head) \
+   for( (_pos) = list_rcu_next(_head); \
+        prefetch(__atomic_load_n(&(_pos)->next, __ATOMIC_RELAXED)), (_pos) != (_head); \
+        (_pos) = list_rcu_next(_pos) )
+
+#define list_for_each_entry_rcu(_pos, _head, _member) \
+   for( (_pos) = list_entry(list_rcu_next(_head), typeof(*(_pos)), _member); \
+        prefetch(__atomic_load_n(&(_pos)->_member.next, __ATOMIC_RELAXED)), \
+        &(_pos)->_member != (_head); \
+        (_pos) = list_entry(list_rcu_next(&(_pos)->_member), typeof(*(_pos)), _member) )
+
+/*
+ * Moves all elements of src at the end of list l, src becomes empty.
+ * Takes constant time regardless the number of moved elements.
+ */
+static inline void list_splice_append (list_t *l, list_t *src)
+{
+	if( list_is_empty(src) ) {
+		return;
+	}
+	__list_connect_together (l->prev, src->next);
+	__list_connect_together (src->prev, l);
+	list_init (src);
+}
+
+/*
+ * Moves all elements of src at the begining of list l, src becomes empty.
+ */
+static inline void list_splice_prepend (list_t *l, list_t *src)
+{
+	if( list_is_empty(src) ) {
+		return;
+	}
+	__list_connect_together (src->prev, l->next);
+	__list_connect_together (l, src->next);
+	list_init (src);
+}
+
+/*
+ * Moves elements from the begining of list l up to and including itr into
+ * the list dst, which is initialized by this function. Passing the list
+ * header l as itr leaves l untouched and dst empty.
+ */
+static inline void list_cut (list_t *l, list_t *itr, list_t *dst)
+{
+	list_init (dst);
+	if( itr == l ) {
+		return;
+	}
+	__list_connect_together (dst, l->next);
+	__list_connect_together (l, itr->next);
+	__list_connect_together (itr, dst);
+}
+
+/*
+ * Comparator for list_sort, returns <0, 0 or >0 if a is to be placed
+ * before, at the same position or after b.
+ */
+typedef int (*list_cmp_t)(const list_t *a, const list_t *b);
+
+/*
+ * Merges two NULL terminated chains linked by next pointers. Elements of a
+ * go before equal elements of b so a has to hold the earlier elements.
+ */
+static inline list_t *__list_merge (list_cmp_t cmp, list_t *a, list_t *b)
+{
+	list_t *head = NULL;
+	list_t **tail = &head;
+
+	for( ;; ) {
+		if( cmp(a, b) <= 0 ) {
+			*tail = a;
+			tail = &a->next;
+			a = a->next;
+			if( NULL == a ) {
+				*tail = b;
+				break;
+			}
+		} else {
+			*tail = b;
+			tail = &b->next;
+			b = b->next;
+			if( NULL == b ) {
+				*tail = a;
+				break;
+			}
+		}
+	}
+	return head;
+}
+
+/*
+ * Stable bottom-up merge sort, O(n log n) comparisons and no allocation.
+ * Elements are taken one by one and merged into pending runs of 2^i elements
+ * (like carry in binary counter), prev pointers are ignored while sorting and
+ * restored in the final pass.
+ */
+static inline void list_sort (list_t *l, list_cmp_t cmp)
+{
+	list_t *part[sizeof(unsigned long) * 8];
+	list_t *elem, *next, *merged, *prev;
+	unsigned top = 0;
+	unsigned i;
+
+	if( l->next == l->prev ) {
+		return; /* 0 or 1 element */
+	}
+	l->prev->next = NULL;
+	for( elem = l->next; NULL != elem; elem = next ) {
+		next = elem->next;
+		elem->next = NULL;
+		merged = elem;
+		/* part[i] holds elements taken before merged */
+		for( i = 0; (i < top) && (NULL != part[i]); i++ ) {
+			merged = __list_merge(cmp, part[i], merged);
+			part[i] = NULL;
+		}
+		if( i == top ) {
+			top++;
+		}
+		part[i] = merged;
+	}
+
+	merged = NULL;
+	for( i = 0; i < top; i++ ) {
+		if( NULL != part[i] ) {
+			merged = (NULL == merged) ? part[i] : __list_merge(cmp, part[i], merged);
+		}
+	}
+
+	prev = l;
+	for( elem = merged; NULL != elem; elem = elem->next ) {
+		elem->prev = prev;
+		prev = elem;
+	}
+	l->next = merged;
+	__list_connect_together (prev, l);
+}
+
 /*
  * Adds the element to the prio list i proper place which will sustain the sorting order
  * In case of multiple elements with the same prio, it will be added at the end of
@@ -177,11 +457,14 @@ static inline void listprio_append(listprio_t *h, listprio_t *elem)
 {
     listprio_t *l = h;
     listprio_t *r = (listprio_t*)(l->list.next);
+    TRACE_BEGIN(TRACE_ID_LISTPRIO_APPEND, elem->prio, 0);
     while((r != h) && (elem->prio <= r->prio)) {
+        prefetch(r->list.next->next);
         l = r;
         r = (listprio_t*)(r->list.next);
     }
     __list_put_in_between (&(elem->list), &(l->list), &(r->list));
+    TRACE_END(TRACE_ID_LISTPRIO_APPEND, elem->prio, 0);
 }
 
 /*
@@ -198,5 +481,20 @@ static inline listprio_t *listprio_detachfirst(const listprio_t *l)
    return (listprio_t*)elem; /* list_t list is at begining of listprio_t */
 }
 
+static inline int __listprio_cmp(const list_t *a, const list_t *b)
+{
+	return (int)((const listprio_t*)b)->prio - (int)((const listprio_t*)a)->prio;
+}
+
+/*
+ * Sorts the prio list in the same order as listprio_append would create,
+ * elements with the same prio keep their order. Elements can be added with
+ * list_append and sorted once, O(n log n) instead of O(n^2) of inserts.
+ */
+static inline void listprio_sort(listprio_t *h)
+{
+   list_sort(&h->list, __listprio_cmp);
+}
+
 #endif /* __LIST_H_ */
 
@@ -32,9 +32,46 @@
 #ifndef __GMACROS_H__
 #define __GMACROS_H__ 1
 
+#include <stddef.h> /* for size_t, NULL and offsetof */
+#include <stdlib.h> /* abs() has to be declared before the abs macro below */
+
 /** Branch predition macros */
+#ifndef CONFIG_BRANCH_PROFILE
 #define likely(expr) __builtin_expect(!!(expr), 1)
 #define unlikely(expr) __builtin_expect(!!(expr), 0)
+#else
+/**
+   Branch profiling mode, enabled by CONFIG_BRANCH_PROFILE (make BRANCHPROF=1)
+   Similar to Linux's annotated branch profiler. Each likely()/unlikely() call
+   site gets static record placed in "branchprof" section, which counts how
+   many times the hint was correct. Use branchprof_dump() from branchprof.h to
+   list the wrong hints. Counters are not atomic, in multithreaded programs
+   some of updates may be lost, what is acceptable for statistics.
+ */
+typedef struct branchprof_site_tag {
+   const char *func;
+   const char *file;
+   const char *expr;
+   unsigned line;
+   unsigned long correct;
+   unsigned long incorrect;
+} branchprof_site_t;
+
+#define __branch_check(_expr, _expect) ({ \
+   static branchprof_site_t \
+      __attribute__((section("branchprof"), aligned(sizeof(void*)), used)) \
+      _bp_site = { __func__, __FILE__, #_expr, __LINE__, 0, 0 }; \
+   long _bp_r = !!(_expr); \
+   if( _bp_r == (_expect) ) { \
+      _bp_site.correct++; \
+   } else { \
+      _bp_site.incorrect++; \
+   } \
+   __builtin_expect(_bp_r, (_expect)); })
+
+#define likely(expr) __branch_check(expr, 1)
+#define unlikely(expr) __branch_check(expr, 0)
+#endif
 
 /**
 * Macro returns number of table elements
@@ -66,11 +103,13 @@
 
    @return Offset in bytes (size_t) of member from the beginning of parent.
  */
+#ifndef offsetof
 #ifdef __compiler_offsetof
 #define offsetof(_type,_member) __compiler_offsetof(_type, _member)
 #else
 #define offsetof(_type, _member) ((size_t) &(((_type *)NULL)->_member))
 #endif
+#endif
 
 /** Common macro that allows to get size of member in structure or union */
 #define sizeoffield(_type, _member) (sizeof(((_type *)NULL)->_member))
@@ -152,6 +191,8 @@
    Macro used to calculate the ceiling(x/y), macro is type sensitive.
    Macro cannot be used with floating point types,
    for those please use ceil function from math.h
+   For divisors which are not known at compile time but are reused in hot
+   loops, fastdiv_uN_ceil_div() from fastdiv.h avoids the division
 
    @param _x dividend
    @param _y divisor
@@ -209,5 +250,49 @@
   __val = __val < __min ? __min: __val; \
   __val > __max ? __max: __val; })
 
+/**
+   Size of the data cache line in bytes, normally defined by arch.h
+   On architectures without cache it should be defined as 1 so the alignment
+   and padding macros do not waste the memory
+ */
+#ifndef CACHELINE_SIZE
+#define CACHELINE_SIZE 64
+#endif
+
+/**
+   Attribute which aligns variable, structure or structure member to the cache
+   line boundary. Use it to separate data written by different CPUs, what
+   prevents false sharing. Note that malloc() does not respect this alignment,
+   use aligned_alloc() or posix_memalign() for such objects.
+ */
+#define cacheline_aligned __attribute__((aligned(CACHELINE_SIZE)))
+
+/**
+   Macro rounds up the size to the multiple of cache line size
+
+   @param _size Size in bytes
+   @return Size rounded up to cache line boundary
+ */
+#define cacheline_roundup(_size) \
+  ((((_size) + CACHELINE_SIZE - 1) / CACHELINE_SIZE) * CACHELINE_SIZE)
+
+/**
+   Macro declares padding structure member which extends the preceding members
+   of size _used bytes up to the cache line boundary
+
+   @param _name Name of padding member
+   @param _used Size of members which share the cache line with padding
+ */
+#define cacheline_pad(_name, _used) \
+  uint8_t _name[cacheline_roundup(_used) - (_used)]
+
+/**
+   Software prefetch hints, the address does not have to be valid.
+   prefetch() is for data which will be read, prefetchw() for data which will
+   be written. Both compile to nothing on architectures without prefetch.
+ */
+#define prefetch(_addr) __builtin_prefetch((_addr), 0, 3)
+#define prefetchw(_addr) __builtin_prefetch((_addr), 1, 3)
+
 #endif /* __GMACROS_H__ */
 
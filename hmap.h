@@ -0,0 +1,278 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __HMAP_H_
+#define __HMAP_H_ 1
+
+#include "arch.h"
+#include "gmacros.h"
+
+#if defined(__SSE2__) && !defined(CONFIG_HMAP_SCALAR)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Flat open addressing hash map, with control byte per slot in the style of
+ * Swiss table. Lookup does not chase pointers, it loads 16 control bytes of
+ * consecutive slots at once and compares keys only in slots whose control
+ * byte matches 7 bits of the hash, on x86 it takes one SSE2 compare (SSE2 is
+ * part of x86-64 so it is selected at compile time), other targets and
+ * CONFIG_HMAP_SCALAR use the byte loop.
+ *
+ * Probing is linear over slots, group is loaded at any slot position (control
+ * array holds copy of its first HMAP_GROUP - 1 bytes at the end for loads
+ * which wrap). Because there are no probe sequence jumps, removal moves the
+ * following entries of the cluster back to close the gap, so there are no
+ * tombstones and the lookup of missing key stops at the first free slot also
+ * after many removals. Map is filled at most to 7/8 of capacity.
+ *
+ * HMAP_DEFINE(name, key_t, val_t, hash, eq) generates name_t and functions
+ * name_xxx() for given types. hash(const key_t*) returns uint32_t, eq(const
+ * key_t*, const key_t*) returns true for equal keys. Storage is provided by
+ * the caller, the map never allocates. Map is not thread safe.
+ */
+
+/** number of slots compared at once */
+#define HMAP_GROUP 16
+/** control byte of free slot, used slot holds 7 low bits of the hash */
+#define HMAP_EMPTY 0x80
+/** size of control array for given capacity */
+#define HMAP_CTRL_SIZE(_capacity) ((_capacity) + HMAP_GROUP - 1)
+
+typedef struct hmap_tag
+{
+   /** control bytes, HMAP_CTRL_SIZE(mask + 1) */
+   uint8_t *ctrl;
+   unsigned mask;
+   unsigned count;
+   /** maximal count, 7/8 of capacity */
+   unsigned max;
+} hmap_t;
+
+/* capacity has to be power of 2, at least HMAP_GROUP */
+static inline void hmap_init(hmap_t *h, uint8_t *ctrl, unsigned capacity)
+{
+   assert((capacity >= HMAP_GROUP) && (0 == (capacity & (capacity - 1))));
+
+   h->ctrl = ctrl;
+   h->mask = capacity - 1;
+   h->count = 0;
+   h->max = capacity - capacity / 8;
+   memset(ctrl, HMAP_EMPTY, HMAP_CTRL_SIZE(capacity));
+}
+
+static inline void hmap_ctrl_set(hmap_t *h, unsigned i, uint8_t ctrl)
+{
+   h->ctrl[i] = ctrl;
+   if( i < HMAP_GROUP - 1 )
+   {
+      h->ctrl[h->mask + 1 + i] = ctrl;
+   }
+}
+
+/* bit i of the result is set if slot pos + i holds hash h2 */
+static inline unsigned hmap_group_match(const uint8_t *ctrl, uint8_t h2)
+{
+#if defined(__SSE2__) && !defined(CONFIG_HMAP_SCALAR)
+   __m128i g = _mm_loadu_si128((const __m128i*)ctrl);
+
+   return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(h2)));
+#else
+   unsigned m = 0;
+   unsigned i;
+
+   for( i = 0; i < HMAP_GROUP; i++ )
+   {
+      m |= (unsigned)(ctrl[i] == h2) << i;
+   }
+   return m;
+#endif
+}
+
+/* bit i of the result is set if slot pos + i is free */
+static inline unsigned hmap_group_empty(const uint8_t *ctrl)
+{
+#if defined(__SSE2__) && !defined(CONFIG_HMAP_SCALAR)
+   return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+   unsigned m = 0;
+   unsigned i;
+
+   for( i = 0; i < HMAP_GROUP; i++ )
+   {
+      m |= (unsigned)(ctrl[i] >> 7) << i;
+   }
+   return m;
+#endif
+}
+
+#define hmap_h1(_hash) ((_hash) >> 7)
+#define hmap_h2(_hash) ((uint8_t)((_hash) & 0x7F))
+
+#define HMAP_DEFINE(_name, _key_t, _val_t, _hash, _eq) \
+\
+typedef struct \
+{ \
+   _key_t key; \
+   _val_t val; \
+} _name##_slot_t; \
+\
+typedef struct \
+{ \
+   hmap_t h; \
+   _name##_slot_t *slots; \
+} _name##_t; \
+\
+/* ctrl has HMAP_CTRL_SIZE(capacity) bytes, slots has capacity entries */ \
+static inline void _name##_init(_name##_t *map, uint8_t *ctrl, \
+                                _name##_slot_t *slots, unsigned capacity) \
+{ \
+   hmap_init(&map->h, ctrl, capacity); \
+   map->slots = slots; \
+} \
+\
+static inline unsigned _name##_count(const _name##_t *map) \
+{ \
+   return map->h.count; \
+} \
+\
+/* returns slot index of key or mask + 1 if there is no such key */ \
+static inline unsigned __##_name##_lookup(const _name##_t *map, \
+                                          const _key_t *key, uint32_t hash) \
+{ \
+   unsigned pos = hmap_h1(hash) & map->h.mask; \
+\
+   for( ;; ) \
+   { \
+      const uint8_t *ctrl = &map->h.ctrl[pos]; \
+      unsigned m = hmap_group_match(ctrl, hmap_h2(hash)); \
+\
+      while( 0 != m ) \
+      { \
+         unsigned i = (pos + __builtin_ctz(m)) & map->h.mask; \
+\
+         if( likely(_eq(&map->slots[i].key, key)) ) \
+         { \
+            return i; \
+         } \
+         m &= m - 1; \
+      } \
+      if( likely(0 != hmap_group_empty(ctrl)) ) \
+      { \
+         return map->h.mask + 1; \
+      } \
+      pos = (pos + HMAP_GROUP) & map->h.mask; \
+   } \
+} \
+\
+/* \return pointer to value of key, NULL if there is no such key */ \
+static inline _val_t* _name##_find(const _name##_t *map, const _key_t *key) \
+{ \
+   unsigned i = __##_name##_lookup(map, key, _hash(key)); \
+\
+   return (i <= map->h.mask) ? &map->slots[i].val : NULL; \
+} \
+\
+/* stores value of key, replaces existing one \
+   \return pointer to stored value, NULL if map is full */ \
+static inline _val_t* _name##_insert(_name##_t *map, const _key_t *key, \
+                                     const _val_t *val) \
+{ \
+   uint32_t hash = _hash(key); \
+   unsigned i = __##_name##_lookup(map, key, hash); \
+   unsigned pos; \
+   unsigned m; \
+\
+   if( i > map->h.mask ) \
+   { \
+      if( unlikely(map->h.count >= map->h.max) ) \
+      { \
+         return NULL; \
+      } \
+      pos = hmap_h1(hash) & map->h.mask; \
+      while( 0 == (m = hmap_group_empty(&map->h.ctrl[pos])) ) \
+      { \
+         pos = (pos + HMAP_GROUP) & map->h.mask; \
+      } \
+      i = (pos + __builtin_ctz(m)) & map->h.mask; \
+      hmap_ctrl_set(&map->h, i, hmap_h2(hash)); \
+      map->slots[i].key = *key; \
+      map->h.count++; \
+   } \
+   map->slots[i].val = *val; \
+   return &map->slots[i].val; \
+} \
+\
+/* \return true if key was removed, false if there was no such key */ \
+static inline bool _name##_remove(_name##_t *map, const _key_t *key) \
+{ \
+   unsigned i = __##_name##_lookup(map, key, _hash(key)); \
+   unsigned j; \
+\
+   if( i > map->h.mask ) \
+   { \
+      return false; \
+   } \
+   /* backward shift, entry which can be found from its home slot also in \
+      the gap is moved there, the gap moves to its place */ \
+   for( j = (i + 1) & map->h.mask; \
+        HMAP_EMPTY != map->h.ctrl[j]; \
+        j = (j + 1) & map->h.mask ) \
+   { \
+      unsigned home = hmap_h1(_hash(&map->slots[j].key)) & map->h.mask; \
+\
+      if( ((j - home) & map->h.mask) >= ((j - i) & map->h.mask) ) \
+      { \
+         hmap_ctrl_set(&map->h, i, map->h.ctrl[j]); \
+         map->slots[i] = map->slots[j]; \
+         i = j; \
+      } \
+   } \
+   hmap_ctrl_set(&map->h, i, HMAP_EMPTY); \
+   map->h.count--; \
+   return true; \
+} \
+\
+/* iteration, *pos starts at 0 \
+   \return next used slot, NULL after the last one */ \
+static inline _name##_slot_t* _name##_next(const _name##_t *map, unsigned *pos) \
+{ \
+   for( ; *pos <= map->h.mask; (*pos)++ ) \
+   { \
+      if( HMAP_EMPTY != map->h.ctrl[*pos] ) \
+      { \
+         return &map->slots[(*pos)++]; \
+      } \
+   } \
+   return NULL; \
+}
+
+#endif /* __HMAP_H_ */
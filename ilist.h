@@ -0,0 +1,228 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __ILIST_H_
+#define __ILIST_H_ 1
+
+#include "arch.h"
+#include "gmacros.h"
+
+/*
+ * Doubly linked lists with 8, 16 or 32 bit indexes instead of pointers.
+ *
+ * All nodes of the list live in one array provided by the caller, links hold
+ * the array indexes of neighbours. On 64 bit targets link takes 4 bytes with
+ * 16 bit and 8 bytes with 32 bit indexes instead of 16 bytes of list_t. On AVR
+ * where list_t takes 4 bytes, 8 bit indexes halve it for arrays of up to 255
+ * nodes. List header is also a node of the array, so the caller reserves index
+ * for each list.
+ *
+ * ILIST_DEFINE(name, type, member, idx_t) generates functions name_xxx() for
+ * arrays of any type which embeds the link as member, the same operations as
+ * glist.h provides for list_t. ILIST_DEFINE_PRIO() adds priority insert for
+ * type with prio field. ilist8/ilist16/ilist32 and ilistprio8/ilistprio16/
+ * ilistprio32 are generated for plain nodes.
+ *
+ * Index with all bits set is reserved as ILIST_NIL, it is returned instead of
+ * NULL from functions which return elements.
+ */
+
+#define ILIST_NIL(_idx_t) ((_idx_t)~(_idx_t)0)
+
+typedef struct _ilink8_t {
+	uint8_t next;
+	uint8_t prev;
+} ilink8_t;
+
+typedef struct _ilink16_t {
+	uint16_t next;
+	uint16_t prev;
+} ilink16_t;
+
+typedef struct _ilink32_t {
+	uint32_t next;
+	uint32_t prev;
+} ilink32_t;
+
+#define ILIST_DEFINE(_name, _type, _member, _idx_t) \
+\
+static inline void _name##_init (_type *base, _idx_t l) \
+{ \
+	base[l]._member.next = l; \
+	base[l]._member.prev = l; \
+} \
+\
+static inline void __##_name##_put_in_between (_type *base, _idx_t elem, _idx_t left, _idx_t right) \
+{ \
+	base[right]._member.prev = elem; \
+	base[elem]._member.next = right; \
+	base[elem]._member.prev = left; \
+	base[left]._member.next = elem; \
+} \
+\
+static inline void __##_name##_connect_together (_type *base, _idx_t left, _idx_t right) \
+{ \
+	base[right]._member.prev = left; \
+	base[left]._member.next = right; \
+} \
+\
+static inline void _name##_prepend (_type *base, _idx_t l, _idx_t elem) \
+{ \
+	__##_name##_put_in_between (base, elem, l, base[l]._member.next); \
+} \
+\
+static inline void _name##_append (_type *base, _idx_t l, _idx_t elem) \
+{ \
+	__##_name##_put_in_between (base, elem, base[l]._member.prev, l); \
+} \
+\
+static inline void _name##_put_after (_type *base, _idx_t itr, _idx_t elem) \
+{ \
+	__##_name##_put_in_between (base, elem, itr, base[itr]._member.next); \
+} \
+\
+static inline void _name##_put_before (_type *base, _idx_t itr, _idx_t elem) \
+{ \
+	__##_name##_put_in_between (base, elem, base[itr]._member.prev, itr); \
+} \
+\
+static inline void _name##_unlink (_type *base, _idx_t elem) \
+{ \
+	__##_name##_connect_together (base, base[elem]._member.prev, base[elem]._member.next); \
+	_name##_init (base, elem); \
+} \
+\
+static inline bool _name##_is_empty (const _type *base, _idx_t l) \
+{ \
+	return base[l]._member.next == l; \
+} \
+\
+static inline _idx_t _name##_next (const _type *base, _idx_t itr) \
+{ \
+	return base[itr]._member.next; \
+} \
+\
+static inline _idx_t _name##_prev (const _type *base, _idx_t itr) \
+{ \
+	return base[itr]._member.prev; \
+} \
+\
+static inline _idx_t _name##_peekfirst (const _type *base, _idx_t l) \
+{ \
+	_idx_t elem = base[l]._member.next; \
+	return (elem == l) ? ILIST_NIL(_idx_t) : elem; \
+} \
+\
+static inline _idx_t _name##_detachfirst (_type *base, _idx_t l) \
+{ \
+	_idx_t elem = base[l]._member.next; \
+	if( elem == l ) { \
+		return ILIST_NIL(_idx_t); \
+	} \
+	_name##_unlink (base, elem); \
+	return elem; \
+}
+
+/*
+ * Adds priority insert to functions generated by ILIST_DEFINE, the order is
+ * the same as of listprio_append, descending prio and elements with the same
+ * prio in order of insertion.
+ */
+#define ILIST_DEFINE_PRIO(_name, _type, _member, _idx_t, _prio) \
+\
+static inline void _name##_insert (_type *base, _idx_t h, _idx_t elem) \
+{ \
+	_idx_t l = h; \
+	_idx_t r = base[h]._member.next; \
+	while( (r != h) && (base[elem]._prio <= base[r]._prio) ) { \
+		prefetch(&base[base[r]._member.next]); \
+		l = r; \
+		r = base[r]._member.next; \
+	} \
+	__##_name##_put_in_between (base, elem, l, r); \
+}
+
+/*
+ * Iterates over indexes of list elements, the element at _pos must not be
+ * unlinked in the loop body.
+ */
+#define ilist_for_each(_pos, _base, _head, _member) \
+	for( (_pos) = (_base)[_head]._member.next; \
+	     (_pos) != (_head); \
+	     (_pos) = (_base)[_pos]._member.next )
+
+/*
+ * Iterates over indexes of list elements, safe against unlinking of _pos.
+ */
+#define ilist_for_each_safe(_pos, _n, _base, _head, _member) \
+	for( (_pos) = (_base)[_head]._member.next, (_n) = (_base)[_pos]._member.next; \
+	     (_pos) != (_head); \
+	     (_pos) = (_n), (_n) = (_base)[_pos]._member.next )
+
+/* plain nodes, array of links only */
+typedef struct _ilist8_t {
+	ilink8_t link;
+} ilist8_t;
+
+typedef struct _ilist16_t {
+	ilink16_t link;
+} ilist16_t;
+
+typedef struct _ilist32_t {
+	ilink32_t link;
+} ilist32_t;
+
+typedef struct _ilistprio8_t {
+	ilink8_t link;
+	uint8_t prio;
+} ilistprio8_t;
+
+typedef struct _ilistprio16_t {
+	ilink16_t link;
+	uint16_t prio;
+} ilistprio16_t;
+
+typedef struct _ilistprio32_t {
+	ilink32_t link;
+	uint16_t prio;
+} ilistprio32_t;
+
+ILIST_DEFINE(ilist8, ilist8_t, link, uint8_t)
+ILIST_DEFINE(ilist16, ilist16_t, link, uint16_t)
+ILIST_DEFINE(ilist32, ilist32_t, link, uint32_t)
+ILIST_DEFINE(ilistprio8, ilistprio8_t, link, uint8_t)
+ILIST_DEFINE_PRIO(ilistprio8, ilistprio8_t, link, uint8_t, prio)
+ILIST_DEFINE(ilistprio16, ilistprio16_t, link, uint16_t)
+ILIST_DEFINE_PRIO(ilistprio16, ilistprio16_t, link, uint16_t, prio)
+ILIST_DEFINE(ilistprio32, ilistprio32_t, link, uint32_t)
+ILIST_DEFINE_PRIO(ilistprio32, ilistprio32_t, link, uint32_t, prio)
+
+#endif /* __ILIST_H_ */
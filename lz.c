@@ -0,0 +1,439 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "lz.h"
+#include "gmacros.h"
+
+/* skipped bytes after failed searches, step grows by 1 every 2^N misses */
+#define LZ_SKIP_SHIFT 6
+
+#ifdef CONFIG_LZ_TINY
+/* 16 bit multiply only, 32 bit one is a library call on AVR */
+#define LZ_HASH(_v) ((uint16_t)(((uint16_t)(_v) ^ (uint16_t)((_v) >> 16)) * 0x9E37u) >> (16 - LZ_HASH_BITS))
+#else
+#define LZ_HASH(_v) (((_v) * 2654435761u) >> (32 - LZ_HASH_BITS))
+#endif
+
+enum {
+   LZ_TOKEN,
+   LZ_LIT_EXT,
+   LZ_LIT,
+   LZ_OFF_LO,
+   LZ_OFF_HI,
+   LZ_MATCH_EXT,
+   LZ_MATCH,
+};
+
+/* index of byte ofs bytes after the read index */
+static unsigned lz_idx(const circfifo_t *fifo, unsigned ofs)
+{
+   unsigned pos = fifo->rd + ofs;
+
+   return (pos >= (unsigned)fifo->size) ? pos - fifo->size : pos;
+}
+
+static uint32_t lz_read32(const circfifo_t *fifo, unsigned ofs)
+{
+   unsigned pos = lz_idx(fifo, ofs);
+   uint8_t bytes[4];
+   uint32_t v;
+   unsigned i;
+
+   if( pos + sizeof(v) <= (unsigned)fifo->size )
+   {
+      memcpy(&v, &fifo->buff[pos], sizeof(v));
+      return v;
+   }
+   /* wraps around the end of buffer */
+   for( i = 0; i < sizeof(bytes); i++ )
+   {
+      bytes[i] = fifo->buff[pos];
+      pos = (pos + 1 == (unsigned)fifo->size) ? 0 : pos + 1;
+   }
+   memcpy(&v, bytes, sizeof(v));
+   return v;
+}
+
+/* length of match of bytes at ofs with bytes dist before them, up to max */
+static unsigned lz_match_len(const circfifo_t *fifo, unsigned ofs, unsigned dist, unsigned max)
+{
+   const unsigned size = fifo->size;
+   unsigned a = lz_idx(fifo, ofs);
+   unsigned b = lz_idx(fifo, ofs - dist);
+   unsigned len = 0;
+   unsigned run, i;
+
+   while( len < max )
+   {
+      run = min(max - len, min(size - a, size - b));
+      i = 0;
+#ifndef CONFIG_LZ_TINY
+      for( ; i + sizeof(uint64_t) <= run; i += sizeof(uint64_t) )
+      {
+         uint64_t x, y;
+
+         memcpy(&x, &fifo->buff[a + i], sizeof(x));
+         memcpy(&y, &fifo->buff[b + i], sizeof(y));
+         if( x != y )
+         {
+            break;
+         }
+      }
+#endif
+      for( ; (i < run) && (fifo->buff[a + i] == fifo->buff[b + i]); i++ );
+      len += i;
+      if( i < run )
+      {
+         break;
+      }
+      a = (a + i == size) ? 0 : a + i;
+      b = (b + i == size) ? 0 : b + i;
+   }
+
+   return len;
+}
+
+/* stores byte in out at offset ofs after the write index */
+static void lz_put_byte(circfifo_t *out, unsigned ofs, uint8_t byte)
+{
+   unsigned pos = out->wr + ofs;
+
+   pos -= (pos >= (unsigned)out->size) ? out->size : 0;
+   out->buff[pos] = byte;
+}
+
+/* stores one sequence in out and commits it, literals are taken from in at
+ * offset ofs after the read index, no match if dist is 0
+ * \return number of bytes stored */
+static unsigned lz_put_seq(circfifo_t *out, const circfifo_t *in, unsigned ofs,
+                           unsigned lit, unsigned len, unsigned dist)
+{
+   unsigned ml = (0 != dist) ? len - LZ_MATCH_MIN : 0;
+   unsigned n = 0;
+   unsigned src, dst, run;
+
+   lz_put_byte(out, n++, (min(lit, 15u) << 4) | min(ml, 15u));
+   if( lit >= 15 )
+   {
+      lz_put_byte(out, n++, lit - 15);
+   }
+
+   /* literals, both fifos can wrap */
+   src = lz_idx(in, ofs);
+   dst = out->wr + n;
+   dst -= (dst >= (unsigned)out->size) ? out->size : 0;
+   n += lit;
+   while( lit > 0 )
+   {
+      run = min(lit, min(in->size - src, out->size - dst));
+      memcpy(&out->buff[dst], &in->buff[src], run);
+      src = (src + run == (unsigned)in->size) ? 0 : src + run;
+      dst = (dst + run == (unsigned)out->size) ? 0 : dst + run;
+      lit -= run;
+   }
+
+   lz_put_byte(out, n++, dist);
+   lz_put_byte(out, n++, dist >> 8);
+   if( (0 != dist) && (ml >= 15) )
+   {
+      lz_put_byte(out, n++, ml - 15);
+   }
+   circfifo_wr_commit(out, n);
+
+   return n;
+}
+
+/* releases input which is older than the window */
+static void lz_enc_release(lz_enc_t *enc, circfifo_t *in)
+{
+   unsigned hist = enc->done - enc->lit;
+
+   if( hist > enc->window )
+   {
+      circfifo_rd_commit(in, hist - enc->window);
+      enc->done -= hist - enc->window;
+   }
+}
+
+void lz_enc_init(lz_enc_t *enc, unsigned window)
+{
+   assert(window <= LZ_WINDOW_MAX);
+   enc->window = window;
+   enc->done = 0;
+   enc->lit = 0;
+   enc->pos = 0;
+   enc->miss = 0;
+   enc->rep = 0;
+   memset(enc->table, 0, sizeof(enc->table));
+}
+
+/* match which reaches the end of input is not stored unless flush is set, it
+ * can continue with more data */
+static unsigned lz_encode_run(lz_enc_t *enc, circfifo_t *out, circfifo_t *in, bool flush)
+{
+   unsigned avail = circfifo_count(in);
+   bool more = !flush && (0 != circfifo_space(in));
+   unsigned total = 0;
+   unsigned cur, dist, len, step, h;
+   uint32_t v;
+
+   assert((unsigned)in->size > enc->window + LZ_LIT_MAX + LZ_MATCH_MIN);
+   assert(out->size > LZ_SEQ_MAX);
+
+   while( circfifo_space(out) >= LZ_SEQ_MAX )
+   {
+      cur = enc->done;
+      /* failed lz_encode_flush() can leave a few more than LZ_LIT_MAX */
+      if( enc->lit >= LZ_LIT_MAX )
+      {
+         total += lz_put_seq(out, in, cur - enc->lit, LZ_LIT_MAX, 0, 0);
+         enc->lit -= LZ_LIT_MAX;
+         continue;
+      }
+      if( avail - cur < LZ_MATCH_MIN )
+      {
+         break;
+      }
+
+      /* the table gives the last position with the same hash, distance is
+       * modulo 2^16 so the bytes are always compared, right after a match
+       * the next one is tried at the same distance (repeated records) */
+      v = lz_read32(in, cur);
+      h = LZ_HASH(v);
+      dist = (uint16_t)(enc->pos - enc->table[h]);
+      if( (0 == enc->lit) && (0 != enc->rep) && (enc->rep <= cur) && (lz_read32(in, cur - enc->rep) == v) )
+      {
+         dist = enc->rep;
+      }
+      if( (0 != dist) && (dist <= min(enc->window, cur)) && (lz_read32(in, cur - dist) == v) )
+      {
+         len = LZ_MATCH_MIN + lz_match_len(in, cur + LZ_MATCH_MIN, dist,
+                                           min(avail - cur, (unsigned)LZ_MATCH_MAX) - LZ_MATCH_MIN);
+         if( more && (cur + len == avail) && (len < LZ_MATCH_MAX) )
+         {
+            break;
+         }
+         enc->table[h] = enc->pos;
+         total += lz_put_seq(out, in, cur - enc->lit, enc->lit, len, dist);
+         enc->lit = 0;
+         enc->done += len;
+         enc->pos += len;
+         enc->miss = 0;
+         enc->rep = dist;
+         /* position inside the match helps to find the next one */
+         if( avail - enc->done >= 2 )
+         {
+            enc->table[LZ_HASH(lz_read32(in, enc->done - 2))] = enc->pos - 2;
+         }
+         continue;
+      }
+
+      /* literal, skip faster over data which does not compress */
+      enc->table[h] = enc->pos;
+      step = 1 + (enc->miss >> LZ_SKIP_SHIFT);
+      step = min(step, min(avail - cur, LZ_LIT_MAX - enc->lit));
+      enc->miss += (enc->miss < 0xFFFF);
+      enc->lit += step;
+      enc->done += step;
+      enc->pos += step;
+   }
+   lz_enc_release(enc, in);
+
+   return total;
+}
+
+unsigned lz_encode(lz_enc_t *enc, circfifo_t *out, circfifo_t *in)
+{
+   return lz_encode_run(enc, out, in, false);
+}
+
+bool lz_encode_flush(lz_enc_t *enc, circfifo_t *out, circfifo_t *in)
+{
+   unsigned avail;
+   unsigned lit;
+
+   (void)lz_encode_run(enc, out, in, true);
+   avail = circfifo_count(in);
+   if( avail - enc->done >= LZ_MATCH_MIN )
+   {
+      /* output fifo is full */
+      return false;
+   }
+
+   /* the last bytes are too short for match */
+   enc->lit += avail - enc->done;
+   enc->pos += avail - enc->done;
+   enc->done = avail;
+   while( 0 != enc->lit )
+   {
+      if( circfifo_space(out) < LZ_SEQ_MAX )
+      {
+         return false;
+      }
+      lit = min(enc->lit, (unsigned)LZ_LIT_MAX);
+      (void)lz_put_seq(out, in, enc->done - enc->lit, lit, 0, 0);
+      enc->lit -= lit;
+   }
+   lz_enc_release(enc, in);
+
+   return true;
+}
+
+void lz_dec_init(lz_dec_t *dec)
+{
+   dec->state = LZ_TOKEN;
+   dec->token = 0;
+   dec->offset = 0;
+   dec->left = 0;
+   dec->hist = 0;
+}
+
+static void lz_dec_produced(lz_dec_t *dec, circfifo_t *out, unsigned n)
+{
+   circfifo_wr_commit(out, n);
+   dec->hist = min(dec->hist + n, (unsigned)out->size - 1);
+}
+
+/* copies match from history of output fifo */
+static unsigned lz_dec_match(lz_dec_t *dec, circfifo_t *out)
+{
+   const unsigned size = out->size;
+   unsigned space = circfifo_space(out);
+   unsigned total = 0;
+   unsigned dst, src, run;
+
+   while( (0 != dec->left) && (0 != space) )
+   {
+      dst = out->wr;
+      src = (dst >= dec->offset) ? dst - dec->offset : dst + size - dec->offset;
+      /* source and destination must not overlap within one copy */
+      run = min(min(dec->left, space), min(size - dst, size - src));
+      run = min(run, min((unsigned)dec->offset, size - dec->offset));
+      memcpy(&out->buff[dst], &out->buff[src], run);
+      lz_dec_produced(dec, out, run);
+      dec->left -= run;
+      space -= run;
+      total += run;
+   }
+
+   return total;
+}
+
+int lz_decode(lz_dec_t *dec, circfifo_t *out, circfifo_t *in)
+{
+   unsigned total = 0;
+   unsigned avail, run;
+   uint8_t *p;
+   uint8_t byte;
+
+   for( ;; )
+   {
+      if( LZ_MATCH == dec->state )
+      {
+         total += lz_dec_match(dec, out);
+         if( 0 != dec->left )
+         {
+            break;
+         }
+         dec->state = LZ_TOKEN;
+      }
+      if( 0 == (avail = circfifo_rd_region(in, &p)) )
+      {
+         break;
+      }
+
+      if( LZ_LIT == dec->state )
+      {
+         run = min(min(dec->left, avail), min(circfifo_space(out), out->size - (unsigned)out->wr));
+         if( 0 == run )
+         {
+            break;
+         }
+         memcpy(&out->buff[out->wr], p, run);
+         lz_dec_produced(dec, out, run);
+         circfifo_rd_commit(in, run);
+         dec->left -= run;
+         total += run;
+         if( 0 == dec->left )
+         {
+            dec->state = LZ_OFF_LO;
+         }
+         continue;
+      }
+
+      /* sequence header, byte by byte */
+      byte = *p;
+      circfifo_rd_commit(in, 1);
+      switch( dec->state )
+      {
+      case LZ_TOKEN:
+         dec->token = byte;
+         dec->left = byte >> 4;
+         dec->state = (15 == dec->left) ? LZ_LIT_EXT : ((0 != dec->left) ? LZ_LIT : LZ_OFF_LO);
+         break;
+      case LZ_LIT_EXT:
+         dec->left += byte;
+         dec->state = LZ_LIT;
+         break;
+      case LZ_OFF_LO:
+         dec->offset = byte;
+         dec->state = LZ_OFF_HI;
+         break;
+      case LZ_OFF_HI:
+         dec->offset |= (uint16_t)byte << 8;
+         dec->left = LZ_MATCH_MIN + (dec->token & 0x0F);
+         if( 0 == dec->offset )
+         {
+            /* literals only, match length has to be 0 */
+            if( 0 != (dec->token & 0x0F) )
+            {
+               return LZ_ERROR;
+            }
+            dec->state = LZ_TOKEN;
+         }
+         else if( dec->offset > dec->hist )
+         {
+            return LZ_ERROR;
+         }
+         else
+         {
+            dec->state = (0x0F == (dec->token & 0x0F)) ? LZ_MATCH_EXT : LZ_MATCH;
+         }
+         break;
+      case LZ_MATCH_EXT:
+         dec->left += byte;
+         dec->state = LZ_MATCH;
+         break;
+      }
+   }
+
+   return total;
+}
@@ -0,0 +1,163 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __LZ_H_
+#define __LZ_H_ 1
+
+#include "arch.h"
+#include "circfifo.h"
+
+/**
+ * Streaming LZ77 compression stage between two circfifo_t, LZ4 like format
+ * with hash table match finder and no entropy coding.
+ *
+ * Encoder takes data from the input fifo and stores the compressed stream in
+ * the output fifo, decoder does the opposite. Both process as much as possible
+ * and return, so they can be called again when more data or more space is
+ * available. Data which wraps around the end of fifo buffer is processed in
+ * place, there is no other buffer than the hash table.
+ *
+ * History is kept across calls in the fifos themselves. Encoder holds back
+ * the read index of input fifo, up to window bytes which were already
+ * compressed stay there, so the producer of input fifo has that much less
+ * space. Decoder reads the history from its output fifo behind the write
+ * index, the bytes stay in the buffer after the consumer reads them because
+ * decoder is the only producer of the fifo. Output fifo of decoder has to be
+ * bigger than the window of encoder.
+ *
+ * Stream is a sequence of:
+ *    token         literal count in upper and match length - LZ_MATCH_MIN
+ *                  in lower 4 bits, 15 means an extra byte follows
+ *    [count]       literal count - 15
+ *    literals
+ *    offset        match distance, 2 bytes LSB first, 0 for no match
+ *    [length]      match length - LZ_MATCH_MIN - 15 (only with match)
+ *
+ * Encoder delays literals until the next match, lz_encode_flush() emits them
+ * so decoder can restore everything what was passed to the encoder.
+ *
+ * CONFIG_LZ_TINY (default on AVR) selects small hash table and byte loops
+ * for small RAM and flash footprint, at the cost of compression ratio and
+ * speed.
+ */
+
+#if defined(__AVR__) && !defined(CONFIG_LZ_TINY)
+#define CONFIG_LZ_TINY
+#endif
+
+/** log2 of number of hash table entries (2 bytes each) */
+#ifndef LZ_HASH_BITS
+#ifdef CONFIG_LZ_TINY
+#define LZ_HASH_BITS 8
+#else
+#define LZ_HASH_BITS 12
+#endif
+#endif
+
+#define LZ_MATCH_MIN 4
+/** limits given by the token and one extra byte */
+#define LZ_LIT_MAX (15 + 255)
+#define LZ_MATCH_MAX (LZ_MATCH_MIN + 15 + 255)
+/** maximal distance of match */
+#define LZ_WINDOW_MAX 0xFFFF
+/** longest sequence, encoder needs this much space in the output fifo */
+#define LZ_SEQ_MAX (1 + 1 + LZ_LIT_MAX + 2 + 1)
+
+/** decoder error result, stream is corrupted */
+#define LZ_ERROR (-1)
+
+typedef struct lz_enc_tag
+{
+   /** maximal match distance */
+   unsigned window;
+   /** bytes after the read index of input fifo which were processed, the last
+    *  lit of them are literals not yet stored in the output fifo */
+   unsigned done;
+   unsigned lit;
+   /** stream position of the first unprocessed byte, modulo 2^16 */
+   uint16_t pos;
+   /** failed match searches, they make the search step longer */
+   uint16_t miss;
+   /** distance of the last match */
+   uint16_t rep;
+   /** stream positions by hash of the next 4 bytes */
+   uint16_t table[1 << LZ_HASH_BITS];
+} lz_enc_t;
+
+typedef struct lz_dec_tag
+{
+   /** part of sequence which is expected next */
+   uint8_t state;
+   uint8_t token;
+   uint16_t offset;
+   /** literal or match bytes left to copy */
+   unsigned left;
+   /** bytes of output which can be referenced, at most output fifo size - 1 */
+   unsigned hist;
+} lz_dec_t;
+
+/**
+ * Function initializes encoder, the stream starts without history
+ * \param window maximal match distance up to LZ_WINDOW_MAX, has to be smaller
+ *        than the output fifo of decoder and leave enough space in the input
+ *        fifo for the producer
+ */
+void lz_enc_init(lz_enc_t *enc, unsigned window);
+
+/**
+ * Function compresses data from the input fifo into the output fifo, input
+ * fifo has to be bigger than window + LZ_LIT_MAX + LZ_MATCH_MIN and the
+ * output fifo bigger than LZ_SEQ_MAX. Match which reaches the end of data is
+ * kept for the next call while the input fifo is not full.
+ * \return number of bytes stored in the output fifo
+ */
+unsigned lz_encode(lz_enc_t *enc, circfifo_t *out, circfifo_t *in);
+
+/**
+ * Function stores delayed literals, so all data passed to the encoder can be
+ * decoded, the history is kept. Call lz_encode() first, it processes all input
+ * when it has space in the output fifo.
+ * \return false if there is not enough space in the output fifo, part of the
+ *         data may have been flushed already, the call has to be repeated
+ *         when the output fifo has space
+ */
+bool lz_encode_flush(lz_enc_t *enc, circfifo_t *out, circfifo_t *in);
+
+void lz_dec_init(lz_dec_t *dec);
+
+/**
+ * Function decompresses data from the input fifo into the output fifo
+ * \return number of bytes stored in the output fifo or LZ_ERROR if the match
+ *         refers beyond the history, decoder has to be initialized again
+ */
+int lz_decode(lz_dec_t *dec, circfifo_t *out, circfifo_t *in);
+
+#endif /* __LZ_H_ */
@@ -0,0 +1,434 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "rbtree.h"
+
+#define RB_RED 0
+#define RB_BLACK 1
+
+static inline rbnode_t* rb_parent(const rbnode_t *n)
+{
+   return (rbnode_t*)(n->parent_color & ~(uintptr_t)1);
+}
+
+static inline bool rb_is_red(const rbnode_t *n)
+{
+   return (NULL != n) && (RB_RED == (n->parent_color & 1));
+}
+
+static inline bool rb_is_black(const rbnode_t *n)
+{
+   return !rb_is_red(n);
+}
+
+static inline void rb_set_parent(rbnode_t *n, rbnode_t *p)
+{
+   n->parent_color = (uintptr_t)p | (n->parent_color & 1);
+}
+
+static inline void rb_set_color(rbnode_t *n, unsigned color)
+{
+   n->parent_color = (n->parent_color & ~(uintptr_t)1) | color;
+}
+
+/* replaces the link from parent of 'old' (or root) with 'new' */
+static inline void rb_change_child(rbtree_t *t, rbnode_t *old, rbnode_t *new, rbnode_t *parent)
+{
+   if( NULL == parent )
+   {
+      t->root = new;
+   }
+   else if( parent->left == old )
+   {
+      parent->left = new;
+   }
+   else
+   {
+      parent->right = new;
+   }
+}
+
+static void rb_rotate_left(rbtree_t *t, rbnode_t *x)
+{
+   rbnode_t *y = x->right;
+   rbnode_t *p = rb_parent(x);
+
+   x->right = y->left;
+   if( NULL != y->left )
+   {
+      rb_set_parent(y->left, x);
+   }
+   rb_set_parent(y, p);
+   rb_change_child(t, x, y, p);
+   y->left = x;
+   rb_set_parent(x, y);
+}
+
+static void rb_rotate_right(rbtree_t *t, rbnode_t *x)
+{
+   rbnode_t *y = x->left;
+   rbnode_t *p = rb_parent(x);
+
+   x->left = y->right;
+   if( NULL != y->right )
+   {
+      rb_set_parent(y->right, x);
+   }
+   rb_set_parent(y, p);
+   rb_change_child(t, x, y, p);
+   y->right = x;
+   rb_set_parent(x, y);
+}
+
+void rbtree_init(rbtree_t *t, rbtree_cmp_t cmp)
+{
+   t->root = NULL;
+   t->leftmost = NULL;
+   t->cmp = cmp;
+}
+
+void rbtree_insert(rbtree_t *t, rbnode_t *node, const void *key)
+{
+   rbnode_t **link = &t->root;
+   rbnode_t *parent = NULL;
+   rbnode_t *p, *g, *u;
+   bool leftmost = true;
+
+   while( NULL != *link )
+   {
+      parent = *link;
+      if( t->cmp(parent, key) > 0 )
+      {
+         link = &parent->left;
+      }
+      else
+      {
+         /* equal keys go right, after existing ones */
+         link = &parent->right;
+         leftmost = false;
+      }
+   }
+
+   node->parent_color = (uintptr_t)parent | RB_RED;
+   node->left = NULL;
+   node->right = NULL;
+   *link = node;
+   if( leftmost )
+   {
+      t->leftmost = node;
+   }
+
+   /* rebalance, red node must not have red parent */
+   while( rb_is_red(p = rb_parent(node)) )
+   {
+      g = rb_parent(p);
+      if( p == g->left )
+      {
+         u = g->right;
+         if( rb_is_red(u) )
+         {
+            rb_set_color(p, RB_BLACK);
+            rb_set_color(u, RB_BLACK);
+            rb_set_color(g, RB_RED);
+            node = g;
+            continue;
+         }
+         if( node == p->right )
+         {
+            rb_rotate_left(t, p);
+            node = p;
+            p = rb_parent(node);
+         }
+         rb_set_color(p, RB_BLACK);
+         rb_set_color(g, RB_RED);
+         rb_rotate_right(t, g);
+      }
+      else
+      {
+         u = g->left;
+         if( rb_is_red(u) )
+         {
+            rb_set_color(p, RB_BLACK);
+            rb_set_color(u, RB_BLACK);
+            rb_set_color(g, RB_RED);
+            node = g;
+            continue;
+         }
+         if( node == p->left )
+         {
+            rb_rotate_right(t, p);
+            node = p;
+            p = rb_parent(node);
+         }
+         rb_set_color(p, RB_BLACK);
+         rb_set_color(g, RB_RED);
+         rb_rotate_left(t, g);
+      }
+   }
+   rb_set_color(t->root, RB_BLACK);
+}
+
+static void rb_erase_fixup(rbtree_t *t, rbnode_t *x, rbnode_t *parent)
+{
+   rbnode_t *w;
+
+   while( (x != t->root) && rb_is_black(x) )
+   {
+      if( x == parent->left )
+      {
+         w = parent->right;
+         if( rb_is_red(w) )
+         {
+            rb_set_color(w, RB_BLACK);
+            rb_set_color(parent, RB_RED);
+            rb_rotate_left(t, parent);
+            w = parent->right;
+         }
+         if( rb_is_black(w->left) && rb_is_black(w->right) )
+         {
+            rb_set_color(w, RB_RED);
+            x = parent;
+            parent = rb_parent(x);
+            continue;
+         }
+         if( rb_is_black(w->right) )
+         {
+            rb_set_color(w->left, RB_BLACK);
+            rb_set_color(w, RB_RED);
+            rb_rotate_right(t, w);
+            w = parent->right;
+         }
+         rb_set_color(w, parent->parent_color & 1);
+         rb_set_color(parent, RB_BLACK);
+         rb_set_color(w->right, RB_BLACK);
+         rb_rotate_left(t, parent);
+      }
+      else
+      {
+         w = parent->left;
+         if( rb_is_red(w) )
+         {
+            rb_set_color(w, RB_BLACK);
+            rb_set_color(parent, RB_RED);
+            rb_rotate_right(t, parent);
+            w = parent->left;
+         }
+         if( rb_is_black(w->left) && rb_is_black(w->right) )
+         {
+            rb_set_color(w, RB_RED);
+            x = parent;
+            parent = rb_parent(x);
+            continue;
+         }
+         if( rb_is_black(w->left) )
+         {
+            rb_set_color(w->right, RB_BLACK);
+            rb_set_color(w, RB_RED);
+            rb_rotate_left(t, w);
+            w = parent->left;
+         }
+         rb_set_color(w, parent->parent_color & 1);
+         rb_set_color(parent, RB_BLACK);
+         rb_set_color(w->left, RB_BLACK);
+         rb_rotate_right(t, parent);
+      }
+      x = t->root;
+      break;
+   }
+   if( NULL != x )
+   {
+      rb_set_color(x, RB_BLACK);
+   }
+}
+
+void rbtree_erase(rbtree_t *t, rbnode_t *node)
+{
+   rbnode_t *child;
+   rbnode_t *parent;
+   unsigned color;
+
+   if( t->leftmost == node )
+   {
+      t->leftmost = rbtree_next(node);
+   }
+
+   if( (NULL == node->left) || (NULL == node->right) )
+   {
+      child = (NULL != node->left) ? node->left : node->right;
+      parent = rb_parent(node);
+      color = node->parent_color & 1;
+      rb_change_child(t, node, child, parent);
+      if( NULL != child )
+      {
+         rb_set_parent(child, parent);
+      }
+   }
+   else
+   {
+      /* successor takes place of the node, it has no left child */
+      rbnode_t *succ = node->right;
+
+      while( NULL != succ->left )
+      {
+         succ = succ->left;
+      }
+      child = succ->right;
+      color = succ->parent_color & 1;
+      if( rb_parent(succ) == node )
+      {
+         parent = succ;
+      }
+      else
+      {
+         parent = rb_parent(succ);
+         parent->left = child;
+         if( NULL != child )
+         {
+            rb_set_parent(child, parent);
+         }
+         succ->right = node->right;
+         rb_set_parent(succ->right, succ);
+      }
+      rb_change_child(t, node, succ, rb_parent(node));
+      succ->parent_color = node->parent_color;
+      succ->left = node->left;
+      rb_set_parent(succ->left, succ);
+   }
+
+   if( RB_BLACK == color )
+   {
+      rb_erase_fixup(t, child, parent);
+   }
+}
+
+rbnode_t* rbtree_lower_bound(const rbtree_t *t, const void *key)
+{
+   rbnode_t *n = t->root;
+   rbnode_t *ret = NULL;
+
+   while( NULL != n )
+   {
+      if( t->cmp(n, key) >= 0 )
+      {
+         ret = n;
+         n = n->left;
+      }
+      else
+      {
+         n = n->right;
+      }
+   }
+
+   return ret;
+}
+
+rbnode_t* rbtree_upper_bound(const rbtree_t *t, const void *key)
+{
+   rbnode_t *n = t->root;
+   rbnode_t *ret = NULL;
+
+   while( NULL != n )
+   {
+      if( t->cmp(n, key) > 0 )
+      {
+         ret = n;
+         n = n->left;
+      }
+      else
+      {
+         n = n->right;
+      }
+   }
+
+   return ret;
+}
+
+rbnode_t* rbtree_find(const rbtree_t *t, const void *key)
+{
+   rbnode_t *n = rbtree_lower_bound(t, key);
+
+   return ((NULL != n) && (0 == t->cmp(n, key))) ? n : NULL;
+}
+
+rbnode_t* rbtree_next(const rbnode_t *node)
+{
+   rbnode_t *p;
+
+   if( NULL != node->right )
+   {
+      node = node->right;
+      while( NULL != node->left )
+      {
+         node = node->left;
+      }
+      return (rbnode_t*)node;
+   }
+   while( (NULL != (p = rb_parent(node))) && (node == p->right) )
+   {
+      node = p;
+   }
+   return p;
+}
+
+rbnode_t* rbtree_prev(const rbnode_t *node)
+{
+   rbnode_t *p;
+
+   if( NULL != node->left )
+   {
+      node = node->left;
+      while( NULL != node->right )
+      {
+         node = node->right;
+      }
+      return (rbnode_t*)node;
+   }
+   while( (NULL != (p = rb_parent(node))) && (node == p->left) )
+   {
+      node = p;
+   }
+   return p;
+}
+
+rbnode_t* rbtree_last(const rbtree_t *t)
+{
+   rbnode_t *n = t->root;
+
+   if( NULL == n )
+   {
+      return NULL;
+   }
+   while( NULL != n->right )
+   {
+      n = n->right;
+   }
+   return n;
+}
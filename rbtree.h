@@ -0,0 +1,125 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __RBTREE_H_
+#define __RBTREE_H_ 1
+
+#include "arch.h"
+
+/*
+ * Intrusive red-black tree, ordered map with O(log n) insert, erase and
+ * lookup. Some ideas coming from Linux's source code.
+ *
+ * Like list_t, rbnode_t is embedded in user structure and the container is
+ * obtained by container_of(), tree does not allocate. Color is kept in the
+ * lowest bit of parent pointer so the node costs three pointers.
+ * Leftmost node is cached, so rbtree_first() is O(1), what makes the tree a
+ * good replacement for listprio_t used as priority queue or index.
+ * Duplicated keys are allowed, new node is placed after existing equal ones.
+ * Tree is not thread safe.
+ */
+
+typedef struct rbnode_tag {
+   uintptr_t parent_color;
+   struct rbnode_tag *left;
+   struct rbnode_tag *right;
+} rbnode_t;
+
+/**
+ * Comparator
+ * \return <0 if node is before key, 0 if equal, >0 if after
+ */
+typedef int (*rbtree_cmp_t)(const rbnode_t *node, const void *key);
+
+typedef struct rbtree_tag {
+   rbnode_t *root;
+   /** cached first node */
+   rbnode_t *leftmost;
+   rbtree_cmp_t cmp;
+} rbtree_t;
+
+void rbtree_init(rbtree_t *t, rbtree_cmp_t cmp);
+
+/**
+ * Function inserts the node with given key, key is usually the member of the
+ * same container as node
+ */
+void rbtree_insert(rbtree_t *t, rbnode_t *node, const void *key);
+
+/**
+ * Function removes the node from tree
+ */
+void rbtree_erase(rbtree_t *t, rbnode_t *node);
+
+/**
+ * \return First node with given key, NULL if there is no such node
+ */
+rbnode_t* rbtree_find(const rbtree_t *t, const void *key);
+
+/**
+ * \return First node with key greater or equal to given one, NULL if none
+ */
+rbnode_t* rbtree_lower_bound(const rbtree_t *t, const void *key);
+
+/**
+ * \return First node with key greater than given one, NULL if none
+ */
+rbnode_t* rbtree_upper_bound(const rbtree_t *t, const void *key);
+
+/**
+ * \return In-order successor, NULL if node is the last one
+ */
+rbnode_t* rbtree_next(const rbnode_t *node);
+
+/**
+ * \return In-order predecessor, NULL if node is the first one
+ */
+rbnode_t* rbtree_prev(const rbnode_t *node);
+
+/**
+ * \return Node with biggest key, NULL if tree is empty
+ */
+rbnode_t* rbtree_last(const rbtree_t *t);
+
+/**
+ * \return Node with smallest key, NULL if tree is empty
+ */
+static inline rbnode_t* rbtree_first(const rbtree_t *t)
+{
+   return t->leftmost;
+}
+
+static inline bool rbtree_is_empty(const rbtree_t *t)
+{
+   return NULL == t->root;
+}
+
+#endif /* __RBTREE_H_ */
@@ -0,0 +1,296 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sched.h>
+#include "skiplist.h"
+
+#define SKIPLIST_MARK ((uintptr_t)1)
+
+#define skiplist_ptr(_tagged) ((skiplist_node_t*)((_tagged) & ~SKIPLIST_MARK))
+#define skiplist_marked(_tagged) ((_tagged) & SKIPLIST_MARK)
+
+static inline uintptr_t skiplist_load(skiplist_node_t *node, unsigned level)
+{
+   return __atomic_load_n(&node->next[level], __ATOMIC_ACQUIRE);
+}
+
+static inline bool skiplist_cas(skiplist_node_t *node, unsigned level,
+                                uintptr_t expected, uintptr_t desired)
+{
+   return __atomic_compare_exchange_n(&node->next[level], &expected, desired,
+                                      false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/* geometric distribution with p = 1/2 */
+static unsigned skiplist_random_level(void)
+{
+   static __thread uint32_t seed = 0;
+   uint32_t x = seed;
+
+   if( 0 == x )
+   {
+      x = (uint32_t)(uintptr_t)&seed | 1;
+   }
+   /* xorshift32 */
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   seed = x;
+
+   return 1 + __builtin_ctz(x | (1u << (SKIPLIST_MAX_LEVEL - 1)));
+}
+
+/*
+ * Finds the predecessors and successors of key on all levels and unlinks the
+ * marked nodes on the way.
+ * \return true if succs[0] has the key
+ */
+static bool skiplist_search(skiplist_t *sl, const void *key,
+                            skiplist_node_t **preds, skiplist_node_t **succs)
+{
+   skiplist_node_t *pred;
+   skiplist_node_t *curr;
+   uintptr_t succ;
+   int level;
+
+retry:
+   pred = &sl->head;
+   for( level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level-- )
+   {
+      curr = skiplist_ptr(skiplist_load(pred, level));
+      while( NULL != curr )
+      {
+         succ = skiplist_load(curr, level);
+         while( skiplist_marked(succ) )
+         {
+            /* curr is deleted, unlink it on this level */
+            if( !skiplist_cas(pred, level, (uintptr_t)curr, succ & ~SKIPLIST_MARK) )
+            {
+               goto retry;
+            }
+            curr = skiplist_ptr(succ);
+            if( NULL == curr )
+            {
+               break;
+            }
+            succ = skiplist_load(curr, level);
+         }
+         if( (NULL == curr) || (sl->cmp(curr, key) >= 0) )
+         {
+            break;
+         }
+         pred = curr;
+         curr = skiplist_ptr(succ);
+      }
+      preds[level] = pred;
+      succs[level] = curr;
+   }
+
+   return (NULL != succs[0]) && (0 == sl->cmp(succs[0], key));
+}
+
+void skiplist_init(skiplist_t *sl, skiplist_cmp_t cmp)
+{
+   memset(&sl->head, 0, sizeof(sl->head));
+   sl->head.level = SKIPLIST_MAX_LEVEL;
+   sl->cmp = cmp;
+}
+
+bool skiplist_insert(skiplist_t *sl, skiplist_node_t *node, const void *key)
+{
+   skiplist_node_t *preds[SKIPLIST_MAX_LEVEL];
+   skiplist_node_t *succs[SKIPLIST_MAX_LEVEL];
+   unsigned level;
+   unsigned top = skiplist_random_level();
+
+   do
+   {
+      if( skiplist_search(sl, key, preds, succs) )
+      {
+         return false;
+      }
+      node->level = top;
+      node->linking = 1;
+      for( level = 0; level < top; level++ )
+      {
+         __atomic_store_n(&node->next[level], (uintptr_t)succs[level], __ATOMIC_RELAXED);
+      }
+      /* linking on level 0 makes the node part of the set */
+   } while( !skiplist_cas(preds[0], 0, (uintptr_t)succs[0], (uintptr_t)node) );
+
+   for( level = 1; level < top; level++ )
+   {
+      while( 1 )
+      {
+         uintptr_t next = skiplist_load(node, level);
+
+         if( skiplist_marked(next) )
+         {
+            /* node was already deleted, no point to link it higher */
+            goto done;
+         }
+         if( (next != (uintptr_t)succs[level]) &&
+             !skiplist_cas(node, level, next, (uintptr_t)succs[level]) )
+         {
+            goto done;
+         }
+         if( skiplist_cas(preds[level], level, (uintptr_t)succs[level], (uintptr_t)node) )
+         {
+            break;
+         }
+         skiplist_search(sl, key, preds, succs);
+         if( succs[0] != node )
+         {
+            goto done;
+         }
+      }
+   }
+
+done:
+   /* if concurrent delete marked the node while it was linked on upper levels,
+    * deleter could already unlink it, make sure that no link to it is left */
+   if( skiplist_marked(skiplist_load(node, 0)) )
+   {
+      skiplist_search(sl, key, preds, succs);
+   }
+   /* from now on deleter may retire the node */
+   __atomic_store_n(&node->linking, 0, __ATOMIC_RELEASE);
+
+   return true;
+}
+
+skiplist_node_t* skiplist_delete(skiplist_t *sl, const void *key)
+{
+   skiplist_node_t *preds[SKIPLIST_MAX_LEVEL];
+   skiplist_node_t *succs[SKIPLIST_MAX_LEVEL];
+   skiplist_node_t *node;
+   uintptr_t next;
+   int level;
+
+   if( !skiplist_search(sl, key, preds, succs) )
+   {
+      return NULL;
+   }
+   node = succs[0];
+
+   for( level = (int)node->level - 1; level > 0; level-- )
+   {
+      next = skiplist_load(node, level);
+      while( !skiplist_marked(next) )
+      {
+         skiplist_cas(node, level, next, next | SKIPLIST_MARK);
+         next = skiplist_load(node, level);
+      }
+   }
+
+   next = skiplist_load(node, 0);
+   while( !skiplist_marked(next) )
+   {
+      if( skiplist_cas(node, 0, next, next | SKIPLIST_MARK) )
+      {
+         /* unlink from all levels */
+         skiplist_search(sl, key, preds, succs);
+         /* inserter which has not finished yet can link the node again on
+          * upper level after the search, the node can be retired only when
+          * the inserter removed such links */
+         while( __atomic_load_n(&node->linking, __ATOMIC_ACQUIRE) )
+         {
+            sched_yield();
+         }
+         return node;
+      }
+      next = skiplist_load(node, 0);
+   }
+
+   /* other thread won */
+   return NULL;
+}
+
+skiplist_node_t* skiplist_lower_bound(skiplist_t *sl, const void *key)
+{
+   skiplist_node_t *pred = &sl->head;
+   skiplist_node_t *curr = NULL;
+   uintptr_t succ;
+   int level;
+
+   /* read only variant of skiplist_search, deleted nodes are skipped not unlinked */
+   for( level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level-- )
+   {
+      curr = skiplist_ptr(skiplist_load(pred, level));
+      while( NULL != curr )
+      {
+         succ = skiplist_load(curr, level);
+         if( skiplist_marked(succ) )
+         {
+            curr = skiplist_ptr(succ);
+            continue;
+         }
+         if( sl->cmp(curr, key) >= 0 )
+         {
+            break;
+         }
+         pred = curr;
+         curr = skiplist_ptr(succ);
+      }
+   }
+
+   return curr;
+}
+
+skiplist_node_t* skiplist_find(skiplist_t *sl, const void *key)
+{
+   skiplist_node_t *node = skiplist_lower_bound(sl, key);
+
+   return ((NULL != node) && (0 == sl->cmp(node, key))) ? node : NULL;
+}
+
+skiplist_node_t* skiplist_next(skiplist_node_t *node)
+{
+   uintptr_t next = skiplist_load(node, 0);
+
+   node = skiplist_ptr(next);
+   while( NULL != node )
+   {
+      next = skiplist_load(node, 0);
+      if( !skiplist_marked(next) )
+      {
+         break;
+      }
+      node = skiplist_ptr(next);
+   }
+
+   return node;
+}
+
+skiplist_node_t* skiplist_first(skiplist_t *sl)
+{
+   return skiplist_next(&sl->head);
+}
@@ -0,0 +1,125 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SKIPLIST_H_
+#define __SKIPLIST_H_ 1
+
+#include "arch.h"
+#include "ebr.h"
+
+/*
+ * Lock-free concurrent skiplist, sorted set with O(log n) insert, delete and
+ * search, safe for any number of concurrent readers and writers.
+ *
+ * Like list_t, skiplist_node_t is embedded in user structure and the
+ * container is obtained by container_of(), skiplist does not allocate.
+ * Keys are unique, comparator compares the node with the key (usually the key
+ * is member of the same container).
+ *
+ * Based on Fraser's and Herlihy-Shavit algorithm, the node is logically
+ * deleted by marking the lowest bit of its next pointers (top level first,
+ * level 0 decides which thread deleted it) and unlinked by the searches
+ * passing by. All operations have to be called within ebr_enter()/ebr_exit()
+ * critical section of the ebr_t which guards the skiplist, and the node
+ * returned by skiplist_delete() has to be passed to ebr_retire() before it can
+ * be reused or freed. Pointers returned by find/first/next stay valid until
+ * the ebr_exit().
+ */
+
+#ifndef SKIPLIST_MAX_LEVEL
+/** maximal height of the node, optimal for up to 2^16 elements, each level
+ * costs one pointer in skiplist_node_t */
+#define SKIPLIST_MAX_LEVEL 16
+#endif
+
+typedef struct skiplist_node_tag {
+   /** tagged pointers, bit 0 set means that node is deleted */
+   uintptr_t next[SKIPLIST_MAX_LEVEL];
+   /** number of levels on which node is linked */
+   unsigned level;
+   /** nonzero while skiplist_insert() links the node on upper levels */
+   unsigned linking;
+   /** used for deferred reclamation after delete */
+   ebr_node_t ebr;
+} skiplist_node_t;
+
+/**
+ * Comparator
+ * \return <0 if node is before key, 0 if equal, >0 if after
+ */
+typedef int (*skiplist_cmp_t)(const skiplist_node_t *node, const void *key);
+
+typedef struct skiplist_tag {
+   skiplist_node_t head;
+   skiplist_cmp_t cmp;
+} skiplist_t;
+
+void skiplist_init(skiplist_t *sl, skiplist_cmp_t cmp);
+
+/**
+ * Function inserts the node, node must not be linked in any skiplist
+ * \return true on success, false if node with the same key already exists
+ */
+bool skiplist_insert(skiplist_t *sl, skiplist_node_t *node, const void *key);
+
+/**
+ * Function deletes the node with given key. Only one of concurrent deleters
+ * of the same node gets it. If the node is still being linked by concurrent
+ * skiplist_insert(), function waits until the inserter finishes, so the
+ * returned node is not reachable any more and can be retired.
+ * \return Deleted node, NULL if there is no such key
+ */
+skiplist_node_t* skiplist_delete(skiplist_t *sl, const void *key);
+
+/**
+ * \return Node with given key, NULL if there is no such key
+ */
+skiplist_node_t* skiplist_find(skiplist_t *sl, const void *key);
+
+/**
+ * \return First node with key greater or equal to given one, NULL if there is
+ * no such node. Use with skiplist_next() for range scans.
+ */
+skiplist_node_t* skiplist_lower_bound(skiplist_t *sl, const void *key);
+
+/**
+ * \return Node with smallest key, NULL if skiplist is empty
+ */
+skiplist_node_t* skiplist_first(skiplist_t *sl);
+
+/**
+ * Function returns the node which follows the given one, skipping deleted
+ * nodes. The given node may already be deleted by other thread.
+ * \return Next node, NULL at the end
+ */
+skiplist_node_t* skiplist_next(skiplist_node_t *node);
+
+#endif /* __SKIPLIST_H_ */
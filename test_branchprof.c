@@ -0,0 +1,137 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "branchprof.h"
+#include "test_common.h"
+#include "test_branchprof.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define UT_DUMP_MAX 4096
+
+static char ut_dump[UT_DUMP_MAX];
+
+/* two sites with known hints, 1/4 of conditions is true */
+static void ut_bp_sites(unsigned n)
+{
+   volatile unsigned hits = 0;
+   unsigned i;
+
+   for( i = 0; i < n; i++ )
+   {
+      if( unlikely(0 == (i % 4)) )
+      {
+         hits++;
+      }
+      if( likely(0 == (i & 3)) )
+      {
+         hits++;
+      }
+   }
+}
+
+/* dumps the profile into ut_dump, returns number of printed sites */
+static unsigned ut_bp_dump(bool all)
+{
+   FILE *f = tmpfile();
+   unsigned cnt;
+   size_t len;
+
+   UT_ASSERT( NULL != f );
+   if( NULL == f )
+   {
+      ut_dump[0] = '\0';
+      return 0;
+   }
+   cnt = branchprof_dump(f, all);
+   rewind(f);
+   len = fread(ut_dump, 1, sizeof(ut_dump) - 1, f);
+   ut_dump[len] = '\0';
+   fclose(f);
+
+   return cnt;
+}
+
+/* finds counters of the site with given expression in the dump, returns line
+ * of the site in the dump (0 is the header) or -1 */
+static int ut_bp_find(const char *expr, unsigned long *correct, unsigned long *incorrect)
+{
+   const char *line = ut_dump;
+   const char *end;
+   int num = 0;
+
+   while( '\0' != *line )
+   {
+      end = strchr(line, '\n');
+      if( NULL == end )
+      {
+         end = line + strlen(line);
+      }
+      if( ((size_t)(end - line) > strlen(expr)) &&
+          (0 == strncmp(end - strlen(expr), expr, strlen(expr))) )
+      {
+         UT_ASSERT_EQUAL( sscanf(line, "%lu %lu", correct, incorrect), 2 );
+         return num;
+      }
+      line = ('\0' != *end) ? end + 1 : end;
+      num++;
+   }
+   return -1;
+}
+
+extern void ut_branchprof_dump_test(void)
+{
+   unsigned long correct = 0;
+   unsigned long incorrect = 0;
+
+   branchprof_reset();
+   ut_bp_sites(100);
+
+   /* both sites, sorted by mispredictions */
+   UT_ASSERT_EQUAL( ut_bp_dump(true), 2 );
+   UT_ASSERT_EQUAL( ut_bp_find("ut_bp_sites(): 0 == (i & 3)", &correct, &incorrect), 1 );
+   UT_ASSERT_EQUAL( correct, 25 );
+   UT_ASSERT_EQUAL( incorrect, 75 );
+   UT_ASSERT_EQUAL( ut_bp_find("ut_bp_sites(): 0 == (i % 4)", &correct, &incorrect), 2 );
+   UT_ASSERT_EQUAL( correct, 75 );
+   UT_ASSERT_EQUAL( incorrect, 25 );
+   UT_ASSERT( NULL != strstr(ut_dump, "      25         75  75  test_branchprof.c:") );
+
+   /* by default only the wrong hint */
+   UT_ASSERT_EQUAL( ut_bp_dump(false), 1 );
+   UT_ASSERT_EQUAL( ut_bp_find("ut_bp_sites(): 0 == (i & 3)", &correct, &incorrect), 1 );
+   UT_ASSERT_EQUAL( ut_bp_find("ut_bp_sites(): 0 == (i % 4)", &correct, &incorrect), -1 );
+}
+
+extern void ut_branchprof_reset_test(void)
+{
+   unsigned long correct = 0;
+   unsigned long incorrect = 0;
+
+   ut_bp_sites(40);
+   branchprof_reset();
+   UT_ASSERT_EQUAL( ut_bp_dump(true), 0 );
+   UT_ASSERT_EQUAL( ut_bp_dump(false), 0 );
+
+   /* counting starts from zero again */
+   ut_bp_sites(8);
+   UT_ASSERT_EQUAL( ut_bp_dump(true), 2 );
+   UT_ASSERT_EQUAL( ut_bp_find("ut_bp_sites(): 0 == (i & 3)", &correct, &incorrect), 1 );
+   UT_ASSERT_EQUAL( correct, 2 );
+   UT_ASSERT_EQUAL( incorrect, 6 );
+   UT_ASSERT_EQUAL( ut_bp_find("ut_bp_sites(): 0 == (i % 4)", &correct, &incorrect), 2 );
+   UT_ASSERT_EQUAL( correct, 6 );
+   UT_ASSERT_EQUAL( incorrect, 2 );
+}
+
+static const ut_test_info_t ut_branchprof_suite[] = {
+   { "Dump", ut_branchprof_dump_test },
+   { "Reset", ut_branchprof_reset_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_branchprof_suite, sizeof(ut_branchprof_suite) / sizeof(ut_branchprof_suite[0]));
+}
@@ -0,0 +1,36 @@
+#ifndef __BRANCHPROF_TEST_H__
+#define __BRANCHPROF_TEST_H__
+
+/**
+  * \brief Dump of likely()/unlikely() sites (only with CONFIG_BRANCH_PROFILE)
+  * \pre Counters zeroed, one likely() and one unlikely() site, each condition
+  *      true in 1/4 of calls
+  * \post None
+  *
+  * \test
+  *   \li Both sites are printed with all, with exact correct and incorrect
+  *       counts and percentage
+  *   \li Site with more mispredictions is printed first
+  *   \li Without all only the site with wrong hint is printed
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref branchprof_dump
+  */
+extern void ut_branchprof_dump_test(void);
+
+/**
+  * \brief Reset of counters
+  * \pre Sites with nonzero counters
+  * \post None
+  *
+  * \test
+  *   \li Nothing is printed after reset
+  *   \li Counters start from zero again
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref branchprof_reset
+  *   \li \ref branchprof_dump
+  */
+extern void ut_branchprof_reset_test(void);
+
+#endif /*__BRANCHPROF_TEST_H__*/
@@ -1,332 +1,155 @@
-#include "arch.h"
+#define _GNU_SOURCE /* for pthread_setaffinity_np */
 
-#include <cunit/CUnit.h> /*Required by CUnit functions*/
-#include <cunit/Basic.h> /*The results of the Unit Tests are printed to the standard output*/
-#include <cunit/TestDB.h> /*This library supports the structure of tests and suites in CUnit*/
+#include "arch.h"
+#include "circfifo.h"
+#include "test_common.h"
+#include "test_circfifo.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 
 #define UT_TEST_CONTINIUES_LOOP_COUNT ((uint32_t)2000000)
 
+/** size of the fifo used by stress test */
+#define UT_STRESS_FIFO_SIZE ((int)4096)
+/** max size of single chunk passed to circfifo_in and circfifo_out */
+#define UT_STRESS_CHUNK_MAX ((int)512)
+/** bytes streamed through fifo for each core pair, can be changed by argv[1] (in MB) */
+#define UT_STRESS_BYTES_DEFAULT ((uint64_t)64 << 20)
+/** every N'th byte of stream is timestamped for latency measurement */
+#define UT_STRESS_LAT_STRIDE ((uint64_t)4096)
+/** maximal number of core pairs tested */
+#define UT_STRESS_PAIRS_MAX 4
+
 /**
   * Table of test inside suite
   */
-CU_TestInfo UT_Fifo_Static_Suite[] = {
-   { "Invalid parameters", ut_fifo_invalid_param },
+static const ut_test_info_t ut_fifo_suite[] = {
    { "Loop test", ut_fifo_loop_test },
    { "Loop test2", ut_fifo_loop_test2 },
    { "Loop test3", ut_fifo_loop_test3 },
    { "Loop test4", ut_fifo_loop_test4 },
-
-   CU_TEST_INFO_NULL,
+   { "Stress test", ut_fifo_stress_test },
+   { "Find test", ut_fifo_find_test },
+   { "Record test", ut_fifo_record_test },
+#ifdef CONFIG_CIRCFIFO_STATS
+   { "Statistics", ut_fifo_stats_test },
+#endif
 };
 
-extern void ut_fifo_invalid_param(void)
-{
-   uint8_t buffer[100];
-   uint8_t fifo_data_buffer[100];
-   Fifo_Buffer_T fifo_buffer =
-   {
-      .buffer = fifo_data_buffer,
-      .buffer_size = sizeof(fifo_data_buffer),
-      .index_write = 0,
-      .index_read = 0,
-   };
-
-   /* invalid pointer */
-   CU_ASSERT_EQUAL( FifoBufferPut(
-                       NULL, /* Fifo_Buffer_T *fifo, */
-                       buffer, /* void *buffer, */
-                       sizeof(buffer) /* int32_t buffer_bytes_count */ ), -1 );
-
-   /* invalid pointer */
-   CU_ASSERT_EQUAL( FifoBufferPut(
-                       &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                       NULL, /* void *buffer, */
-                       sizeof(buffer) /* int32_t buffer_bytes_count */ ), -1 );
-
-   /* invalid buffer size */
-   CU_ASSERT_EQUAL( FifoBufferPut(
-                       &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                       buffer, /* void *buffer, */
-                       0 /* int32_t buffer_bytes_count */ ), -1 );
-
-   /* invalid buffer size */
-   CU_ASSERT_EQUAL( FifoBufferPut(
-                       &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                       buffer, /* void *buffer, */
-                       -1 /* int32_t buffer_bytes_count */ ), -1 );
-
-   /* invalid pointer */
-   CU_ASSERT_EQUAL( FifoBufferGet(
-                       NULL, /* Fifo_Buffer_T *fifo, */
-                       buffer, /* void *buffer, */
-                       sizeof(buffer) /* int32_t buffer_bytes_request */ ), -1 );
-
-   /* invalid pointer */
-   CU_ASSERT_EQUAL( FifoBufferGet(
-                       &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                       NULL, /* void *buffer, */
-                       sizeof(buffer) /* int32_t buffer_bytes_request */ ), -1 );
-
-   /* invalid pointer */
-   CU_ASSERT_EQUAL( FifoBufferGet(
-                       &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                       buffer, /* void *buffer, */
-                       0 /* int32_t buffer_bytes_request */ ), -1 );
-
-   /* invalid pointer */
-   CU_ASSERT_EQUAL( FifoBufferGet(
-                       &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                       buffer, /* void *buffer, */
-                       -1 /* int32_t buffer_bytes_request */ ), -1 );
-}
+static uint64_t ut_stress_bytes = UT_STRESS_BYTES_DEFAULT;
 
 extern void ut_fifo_loop_test(void)
 {
-   uint8_t buffer_upper_check = 0xF0;
    uint8_t buffer[100];
-   uint8_t buffer_lower_check = 0xF0;
-   uint8_t test_buffer_upper_check = 0xF0;
    uint8_t test_buffer[99];
-   uint8_t test_buffer_lower_check = 0xF0;
    uint8_t fifo_data_buffer[100];
-   Fifo_Buffer_T fifo_buffer =
-   {
-      .buffer = fifo_data_buffer,
-      .buffer_size = sizeof(fifo_data_buffer),
-      .index_write = 0,
-      .index_read = 0,
-   };
+   circfifo_t fifo;
 
    uint32_t test_loop = 0;
    uint32_t index = 0;
-   uint32_t current_complete_index = 0;
-   uint32_t complete_index = 0;
+
+   circfifo_init(&fifo, fifo_data_buffer, sizeof(fifo_data_buffer));
 
    for( index = 0; index < sizeof(buffer); index++ )
    {
       buffer[index] = index;
    }
 
-   printf("000");
    while( test_loop < UT_TEST_CONTINIUES_LOOP_COUNT )
    {
-      current_complete_index = (uint32_t)(((float)test_loop / UT_TEST_CONTINIUES_LOOP_COUNT) * 100);
-      if( complete_index != current_complete_index )
-      {
-         printf("\b\b\b%03u", current_complete_index );
-         complete_index = current_complete_index;
-      }
-
-      CU_ASSERT_EQUAL( FifoBufferPut(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          buffer, /* void *buffer, */
-                          sizeof(buffer) /* int32_t buffer_bytes_count */ ), sizeof(fifo_data_buffer) - 1 );
-
-      CU_ASSERT_EQUAL( buffer_upper_check, 0xF0 );
-      CU_ASSERT_EQUAL( buffer_lower_check, 0xF0 );
-
-      CU_ASSERT_EQUAL( FifoBufferPut(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          buffer, /* void *buffer, */
-                          sizeof(buffer) /* int32_t buffer_bytes_count */ ), 0 );
-
-      CU_ASSERT_EQUAL( buffer_upper_check, 0xF0 );
-      CU_ASSERT_EQUAL( buffer_lower_check, 0xF0 );
+      UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, sizeof(buffer)), sizeof(fifo_data_buffer) - 1 );
+      UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, sizeof(buffer)), 0 );
 
       memset( test_buffer, 0, sizeof(test_buffer) );
-      CU_ASSERT_EQUAL( FifoBufferGet(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          test_buffer, /* void *buffer, */
-                          sizeof(test_buffer) /* int32_t buffer_bytes_request */ ), sizeof(test_buffer) );
-
-      CU_ASSERT_EQUAL( test_buffer_upper_check, 0xF0 );
-      CU_ASSERT_EQUAL( test_buffer_lower_check, 0xF0 );
-
-      CU_ASSERT_EQUAL( memcmp(buffer, test_buffer, sizeof(test_buffer)), 0 );
+      UT_ASSERT_EQUAL( circfifo_out(&fifo, test_buffer, sizeof(test_buffer)), sizeof(test_buffer) );
+      UT_ASSERT_EQUAL( memcmp(buffer, test_buffer, sizeof(test_buffer)), 0 );
 
-      CU_ASSERT_EQUAL( FifoBufferGet(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          test_buffer, /* void *buffer, */
-                          sizeof(test_buffer) /* int32_t buffer_bytes_request */ ), 0 );
+      UT_ASSERT_EQUAL( circfifo_out(&fifo, test_buffer, sizeof(test_buffer)), 0 );
 
       test_loop++;
    }
-
 }
 
 extern void ut_fifo_loop_test2(void)
 {
-   uint8_t buffer_upper_check = 0xF0;
    uint8_t buffer[100];
-   uint8_t buffer_lower_check = 0xF0;
-   uint8_t test_buffer_upper_check = 0xF0;
    uint8_t test_buffer[49];
-   uint8_t test_buffer_lower_check = 0xF0;
    uint8_t fifo_data_buffer[100];
-   Fifo_Buffer_T fifo_buffer =
-   {
-      .buffer = fifo_data_buffer,
-      .buffer_size = sizeof(fifo_data_buffer),
-      .index_write = 0,
-      .index_read = 0,
-   };
+   circfifo_t fifo;
 
    uint32_t test_loop = 0;
    uint32_t index = 0;
-   uint32_t current_complete_index = 0;
-   uint32_t complete_index = 0;
+
+   circfifo_init(&fifo, fifo_data_buffer, sizeof(fifo_data_buffer));
 
    for( index = 0; index < sizeof(buffer); index++ )
    {
       buffer[index] = index;
    }
 
-   printf("000");
    while( test_loop < UT_TEST_CONTINIUES_LOOP_COUNT )
    {
-      current_complete_index = (uint32_t)(((float)test_loop / UT_TEST_CONTINIUES_LOOP_COUNT) * 100);
-      if( complete_index != current_complete_index )
-      {
-         printf("\b\b\b%03u", current_complete_index );
-         complete_index = current_complete_index;
-      }
-
-      CU_ASSERT_EQUAL( FifoBufferPut(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          buffer, /* void *buffer, */
-                          sizeof(test_buffer) /* int32_t buffer_bytes_count */ ), sizeof(test_buffer) );
-
-      CU_ASSERT_EQUAL( buffer_upper_check, 0xF0 );
-      CU_ASSERT_EQUAL( buffer_lower_check, 0xF0 );
-
-      CU_ASSERT_EQUAL( FifoBufferPut(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          buffer, /* void *buffer, */
-                          sizeof(test_buffer) /* int32_t buffer_bytes_count */ ), sizeof(test_buffer) );
-
-      CU_ASSERT_EQUAL( buffer_upper_check, 0xF0 );
-      CU_ASSERT_EQUAL( buffer_lower_check, 0xF0 );
+      UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, sizeof(test_buffer)), sizeof(test_buffer) );
+      UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, sizeof(test_buffer)), sizeof(test_buffer) );
 
       memset( test_buffer, 0, sizeof(test_buffer) );
-      CU_ASSERT_EQUAL( FifoBufferGet(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          test_buffer, /* void *buffer, */
-                          sizeof(test_buffer) /* int32_t buffer_bytes_request */ ), sizeof(test_buffer) );
-
-      CU_ASSERT_EQUAL( test_buffer_upper_check, 0xF0 );
-      CU_ASSERT_EQUAL( test_buffer_lower_check, 0xF0 );
-
-      CU_ASSERT_EQUAL( memcmp(buffer, test_buffer, sizeof(test_buffer)), 0 );
+      UT_ASSERT_EQUAL( circfifo_out(&fifo, test_buffer, sizeof(test_buffer)), sizeof(test_buffer) );
+      UT_ASSERT_EQUAL( memcmp(buffer, test_buffer, sizeof(test_buffer)), 0 );
 
       memset( test_buffer, 0, sizeof(test_buffer) );
-      CU_ASSERT_EQUAL( FifoBufferGet(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          test_buffer, /* void *buffer, */
-                          sizeof(test_buffer) /* int32_t buffer_bytes_request */ ), sizeof(test_buffer) );
-
-      CU_ASSERT_EQUAL( test_buffer_upper_check, 0xF0 );
-      CU_ASSERT_EQUAL( test_buffer_lower_check, 0xF0 );
-
-      CU_ASSERT_EQUAL( memcmp(buffer, test_buffer, sizeof(test_buffer)), 0 );
+      UT_ASSERT_EQUAL( circfifo_out(&fifo, test_buffer, sizeof(test_buffer)), sizeof(test_buffer) );
+      UT_ASSERT_EQUAL( memcmp(buffer, test_buffer, sizeof(test_buffer)), 0 );
 
       test_loop++;
    }
-
 }
 
 extern void ut_fifo_loop_test3(void)
 {
-   uint8_t buffer_upper_check = 0xF0;
    uint8_t buffer[2];
-   uint8_t buffer_lower_check = 0xF0;
-   uint8_t test_buffer_upper_check = 0xF0;
    uint8_t test_buffer[2];
-   uint8_t test_buffer_lower_check = 0xF0;
    uint8_t fifo_data_buffer[2];
-   Fifo_Buffer_T fifo_buffer =
-   {
-      .buffer = fifo_data_buffer,
-      .buffer_size = sizeof(fifo_data_buffer),
-      .index_write = 0,
-      .index_read = 0,
-   };
+   circfifo_t fifo;
 
    uint32_t test_loop = 0;
    uint32_t index = 0;
-   uint32_t current_complete_index = 0;
-   uint32_t complete_index = 0;
+
+   circfifo_init(&fifo, fifo_data_buffer, sizeof(fifo_data_buffer));
 
    for( index = 0; index < sizeof(buffer); index++ )
    {
       buffer[index] = index;
    }
 
-   printf("000");
    while( test_loop < UT_TEST_CONTINIUES_LOOP_COUNT )
    {
-      current_complete_index = (uint32_t)(((float)test_loop / UT_TEST_CONTINIUES_LOOP_COUNT) * 100);
-      if( complete_index != current_complete_index )
-      {
-         printf("\b\b\b%03u", current_complete_index );
-         complete_index = current_complete_index;
-      }
-
-      CU_ASSERT_EQUAL( FifoBufferPut(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          buffer, /* void *buffer, */
-                          sizeof(buffer) /* int32_t buffer_bytes_count */ ), 1 );
-
-      CU_ASSERT_EQUAL( buffer_upper_check, 0xF0 );
-      CU_ASSERT_EQUAL( buffer_lower_check, 0xF0 );
-
-      CU_ASSERT_EQUAL( FifoBufferPut(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          buffer, /* void *buffer, */
-                          sizeof(buffer) /* int32_t buffer_bytes_count */ ), 0 );
-
-      CU_ASSERT_EQUAL( buffer_upper_check, 0xF0 );
-      CU_ASSERT_EQUAL( buffer_lower_check, 0xF0 );
+      UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, sizeof(buffer)), 1 );
+      UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, sizeof(buffer)), 0 );
 
       memset( test_buffer, 0, sizeof(test_buffer) );
-      CU_ASSERT_EQUAL( FifoBufferGet(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          test_buffer, /* void *buffer, */
-                          sizeof(test_buffer) /* int32_t buffer_bytes_request */ ), 1 );
+      UT_ASSERT_EQUAL( circfifo_out(&fifo, test_buffer, sizeof(test_buffer)), 1 );
+      UT_ASSERT_EQUAL( buffer[0], test_buffer[0] );
 
-      CU_ASSERT_EQUAL( test_buffer_upper_check, 0xF0 );
-      CU_ASSERT_EQUAL( test_buffer_lower_check, 0xF0 );
-
-      CU_ASSERT_EQUAL( buffer[0], test_buffer[0] );
-
-      memset( test_buffer, 0, sizeof(test_buffer) );
-      CU_ASSERT_EQUAL( FifoBufferGet(
-                          &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                          test_buffer, /* void *buffer, */
-                          sizeof(test_buffer) /* int32_t buffer_bytes_request */ ), 0 );
+      UT_ASSERT_EQUAL( circfifo_out(&fifo, test_buffer, sizeof(test_buffer)), 0 );
 
       test_loop++;
    }
-
 }
 
 extern void ut_fifo_loop_test4(void)
 {
-   uint8_t buffer_upper_check = 0xF0;
    uint8_t buffer[100];
-   uint8_t buffer_lower_check = 0xF0;
    uint8_t fifo_data_buffer[100];
-   Fifo_Buffer_T fifo_buffer =
-   {
-      .buffer = fifo_data_buffer,
-      .buffer_size = sizeof(fifo_data_buffer),
-      .index_write = 0,
-      .index_read = 0,
-   };
+   circfifo_t fifo;
 
    uint32_t test_loop = 0;
    uint32_t index = 0;
-   uint32_t current_complete_index = 0;
-   uint32_t complete_index = 0;
 
    uint8_t sender_state = 0;
    uint8_t receiver_state = 0;
@@ -334,16 +157,10 @@ extern void ut_fifo_loop_test4(void)
    uint32_t to_write_bytes = 0;
    uint32_t to_read_bytes = 0;
 
-   printf("000");
+   circfifo_init(&fifo, fifo_data_buffer, sizeof(fifo_data_buffer));
+
    while( test_loop < UT_TEST_CONTINIUES_LOOP_COUNT )
    {
-      current_complete_index = (uint32_t)(((float)test_loop / UT_TEST_CONTINIUES_LOOP_COUNT) * 100);
-      if( complete_index != current_complete_index )
-      {
-         printf("\b\b\b%03u", current_complete_index );
-         complete_index = current_complete_index;
-      }
-
       do
       {
          if( writed_bytes < (sizeof(buffer) - 1) )
@@ -359,15 +176,9 @@ extern void ut_fifo_loop_test4(void)
                buffer[index] = sender_state++;
             }
 
-            CU_ASSERT_EQUAL( FifoBufferPut(
-                                &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                                buffer, /* void *buffer, */
-                                to_write_bytes /* int32_t buffer_bytes_count */ ), to_write_bytes );
+            UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, to_write_bytes), to_write_bytes );
 
             writed_bytes += to_write_bytes;
-
-            CU_ASSERT_EQUAL( buffer_upper_check, 0xF0 );
-            CU_ASSERT_EQUAL( buffer_lower_check, 0xF0 );
          }
       }while(0);
 
@@ -375,7 +186,7 @@ extern void ut_fifo_loop_test4(void)
       {
          if( writed_bytes > 0 )
          {
-            bool_t test = True_v;
+            bool test = true;
 
             to_read_bytes = random() % writed_bytes;
             if( 0 == to_read_bytes )
@@ -384,23 +195,17 @@ extern void ut_fifo_loop_test4(void)
             }
 
             memset( buffer, 0, sizeof(buffer) );
-            CU_ASSERT_EQUAL( FifoBufferGet(
-                                &fifo_buffer, /* Fifo_Buffer_T *fifo, */
-                                buffer, /* void *buffer, */
-                                to_read_bytes /* int32_t buffer_bytes_request */ ), to_read_bytes );
-
-            CU_ASSERT_EQUAL( buffer_upper_check, 0xF0 );
-            CU_ASSERT_EQUAL( buffer_lower_check, 0xF0 );
+            UT_ASSERT_EQUAL( circfifo_out(&fifo, buffer, to_read_bytes), to_read_bytes );
 
             for(index = 0; index < to_read_bytes; index++)
             {
                if( buffer[index] != receiver_state++ )
                {
-                  test = False_v;
+                  test = false;
                }
             }
 
-            CU_ASSERT_EQUAL( True_v, test );
+            UT_ASSERT_EQUAL( test, true );
 
             writed_bytes -= to_read_bytes;
          }
@@ -410,23 +215,463 @@ extern void ut_fifo_loop_test4(void)
    }
 }
 
-int main()
+/**
+  * Shared state of one producer/consumer pair
+  */
+typedef struct {
+   circfifo_t fifo;
+   uint8_t fifo_data[UT_STRESS_FIFO_SIZE];
+   uint64_t total;        /**< bytes to stream */
+   uint64_t *lat_stamp;   /**< producer timestamps for every UT_STRESS_LAT_STRIDE byte */
+   uint64_t *lat;         /**< measured latency for every UT_STRESS_LAT_STRIDE byte */
+   int cpu[2];            /**< producer and consumer CPU, -1 if not pinned */
+   unsigned seed;
+   uint64_t errors;
+} ut_stress_t;
+
+static uint64_t ut_now_ns(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void ut_pin(int cpu)
+{
+   cpu_set_t set;
+
+   if( cpu < 0 )
+   {
+      return;
+   }
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/**
+  * Byte at stream offset 'pos', stream is a sequence of little endian uint32_t
+  * sequence numbers so any lost, duplicated or reordered byte is detected
+  */
+static inline uint8_t ut_stream_byte(uint64_t pos)
+{
+   return (uint8_t)((uint32_t)(pos >> 2) >> ((pos & 3) * 8));
+}
+
+static void* ut_stress_producer(void *arg)
+{
+   ut_stress_t *s = arg;
+   uint8_t chunk[UT_STRESS_CHUNK_MAX];
+   unsigned seed = s->seed;
+   uint64_t pos = 0;
+   uint64_t stamp = 0; /* next latency sample to be stamped */
+
+   ut_pin(s->cpu[0]);
+   while( pos < s->total )
+   {
+      int len = 1 + rand_r(&seed) % UT_STRESS_CHUNK_MAX;
+      int done = 0;
+      int i;
+
+      if( (uint64_t)len > s->total - pos )
+      {
+         len = (int)(s->total - pos);
+      }
+      for( i = 0; i < len; i++ )
+      {
+         chunk[i] = ut_stream_byte(pos + i);
+      }
+      for( ; stamp * UT_STRESS_LAT_STRIDE < pos + len; stamp++ )
+      {
+         __atomic_store_n(&s->lat_stamp[stamp], ut_now_ns(), __ATOMIC_RELEASE);
+      }
+      while( done < len )
+      {
+         unsigned ret = circfifo_in(&s->fifo, &chunk[done], len - done);
+         if( 0 == ret )
+         {
+            sched_yield();
+         }
+         done += ret;
+      }
+      pos += len;
+   }
+
+   return NULL;
+}
+
+static void* ut_stress_consumer(void *arg)
+{
+   ut_stress_t *s = arg;
+   uint8_t chunk[UT_STRESS_CHUNK_MAX];
+   unsigned seed = s->seed ^ 0x5a5a5a5a;
+   uint64_t pos = 0;
+   uint64_t sample = 0; /* next latency sample to be measured */
+
+   ut_pin(s->cpu[1]);
+   while( pos < s->total )
+   {
+      int len = 1 + rand_r(&seed) % UT_STRESS_CHUNK_MAX;
+      unsigned ret = circfifo_out(&s->fifo, chunk, len);
+      unsigned i;
+
+      if( 0 == ret )
+      {
+         sched_yield();
+         continue;
+      }
+      for( i = 0; i < ret; i++ )
+      {
+         if( chunk[i] != ut_stream_byte(pos + i) )
+         {
+            s->errors++;
+         }
+      }
+      pos += ret;
+      if( sample * UT_STRESS_LAT_STRIDE < pos )
+      {
+         uint64_t now = ut_now_ns();
+         for( ; sample * UT_STRESS_LAT_STRIDE < pos; sample++ )
+         {
+            s->lat[sample] = now - __atomic_load_n(&s->lat_stamp[sample], __ATOMIC_ACQUIRE);
+         }
+      }
+   }
+
+   return NULL;
+}
+
+static int ut_u64_cmp(const void *a, const void *b)
 {
-   CU_ErrorCode error;
+   uint64_t x = *(const uint64_t*)a;
+   uint64_t y = *(const uint64_t*)b;
 
-   srandom(time(NULL));
-   printf("First random = %li", random());
+   return (x > y) - (x < y);
+}
 
-   if(CU_initialize_registry())
+static void ut_stress_pair(int cpu_prod, int cpu_cons)
+{
+   ut_stress_t *s;
+   pthread_t prod, cons;
+   uint64_t samples = ut_stress_bytes / UT_STRESS_LAT_STRIDE + 1;
+   uint64_t start, elapsed;
+
+   s = calloc(1, sizeof(*s));
+   UT_ASSERT( NULL != s );
+   if( NULL == s )
    {
-      return -1; // CU_get_error();
+      return;
    }
+   circfifo_init(&s->fifo, s->fifo_data, sizeof(s->fifo_data));
+   s->total = ut_stress_bytes;
+   s->lat_stamp = calloc(samples, sizeof(uint64_t));
+   s->lat = calloc(samples, sizeof(uint64_t));
+   s->cpu[0] = cpu_prod;
+   s->cpu[1] = cpu_cons;
+   s->seed = (unsigned)random();
+   UT_ASSERT( (NULL != s->lat_stamp) && (NULL != s->lat) );
+
+   if( (NULL != s->lat_stamp) && (NULL != s->lat) )
+   {
+      start = ut_now_ns();
+      UT_ASSERT_EQUAL( pthread_create(&cons, NULL, ut_stress_consumer, s), 0 );
+      UT_ASSERT_EQUAL( pthread_create(&prod, NULL, ut_stress_producer, s), 0 );
+      pthread_join(prod, NULL);
+      pthread_join(cons, NULL);
+      elapsed = ut_now_ns() - start;
+
+      UT_ASSERT_EQUAL( s->errors, 0 );
+      UT_ASSERT_EQUAL( circfifo_out(&s->fifo, s->fifo_data, 1), 0 );
+
+      qsort(s->lat, samples, sizeof(uint64_t), ut_u64_cmp);
+      printf("\n   cpu %2d -> %2d: %8.1f MB/s, latency us p50 %.1f p99 %.1f p99.9 %.1f max %.1f",
+             cpu_prod, cpu_cons,
+             (double)s->total / (1 << 20) / ((double)elapsed / 1e9),
+             s->lat[samples / 2] / 1e3,
+             s->lat[samples * 99 / 100] / 1e3,
+             s->lat[samples * 999 / 1000] / 1e3,
+             s->lat[samples - 1] / 1e3);
+   }
+
+   free(s->lat_stamp);
+   free(s->lat);
+   free(s);
+}
 
-   error = CU_register_suites(UT_Fifo_Suites);
+extern void ut_fifo_stress_test(void)
+{
+   int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   int pair;
+   int cons = 0;
+
+   if( cpus < 2 )
+   {
+      /* threads will share the only CPU, still usefull for integrity check */
+      ut_stress_pair(-1, -1);
+      return;
+   }
+
+   /* neighbour cores first (shared cache in most topologies), then far ones */
+   for( pair = 1; (pair < cpus) && (pair <= UT_STRESS_PAIRS_MAX); pair++ )
+   {
+      int cpu = (pair == 1) ? 1 : (cpus - 1) * pair / UT_STRESS_PAIRS_MAX;
+      if( cpu != cons )
+      {
+         cons = cpu;
+         ut_stress_pair(0, cons);
+      }
+   }
+}
+
+/* reference search over the fifo content, returns offset from the read position */
+static int ut_find_ref(const uint8_t *data, int cnt, uint8_t byte)
+{
+   int i;
+
+   for( i = 0; i < cnt; i++ )
+   {
+      if( data[i] == byte )
+      {
+         return i;
+      }
+   }
+   return -1;
+}
 
-   CU_basic_set_mode(CU_BRM_VERBOSE);
-   CU_basic_run_tests();
+static void ut_find_scan_check(const uint8_t* (*scan)(const uint8_t*, unsigned, uint8_t))
+{
+   uint8_t buffer[300];
+   unsigned size, pos;
 
-   return CU_get_number_of_tests_failed();;
+   memset(buffer, 0, sizeof(buffer));
+   for( size = 0; size < 200; size++ )
+   {
+      /* match at each position and no match at all, with random alignment */
+      unsigned offset = random() % 64;
+      UT_ASSERT( NULL == scan(&buffer[offset], size, 0x7E) );
+      for( pos = 0; pos < size; pos++ )
+      {
+         buffer[offset + pos] = 0x7E;
+         buffer[offset + size - 1] = 0x7E;
+         UT_ASSERT( &buffer[offset + pos] == scan(&buffer[offset], size, 0x7E) );
+         buffer[offset + pos] = 0;
+         buffer[offset + size - 1] = 0;
+      }
+      /* byte just past the end is not matched */
+      buffer[offset + size] = 0x7E;
+      UT_ASSERT( NULL == scan(&buffer[offset], size, 0x7E) );
+      buffer[offset + size] = 0;
+   }
 }
 
+extern void ut_fifo_find_test(void)
+{
+   uint8_t buffer[256];
+   uint8_t shadow[256];
+   uint8_t fifo_data_buffer[200];
+   circfifo_t fifo;
+   uint32_t test_loop;
+   int fill = 0;
+   int i, cnt;
+
+   ut_find_scan_check(circfifo_scan_scalar);
+#if defined(ARCH_DISPATCH) && (defined(__x86_64__) || defined(__i386__))
+   if( arch_cpu_has(ARCH_CPU_SSE2) )
+   {
+      ut_find_scan_check(circfifo_scan_sse2);
+   }
+   if( arch_cpu_has(ARCH_CPU_AVX2) )
+   {
+      ut_find_scan_check(circfifo_scan_avx2);
+   }
+#endif
+
+   circfifo_init(&fifo, fifo_data_buffer, sizeof(fifo_data_buffer));
+   UT_ASSERT_EQUAL( circfifo_find(&fifo, 0), -1 );
+
+   /* random content with sparse delimiters, at every wrap position */
+   for( test_loop = 0; test_loop < 100000; test_loop++ )
+   {
+      cnt = random() % (sizeof(fifo_data_buffer) - fill);
+      for( i = 0; i < cnt; i++ )
+      {
+         buffer[i] = (0 == random() % 64) ? '\n' : 'a' + random() % 26;
+      }
+      if( cnt > 0 )
+      {
+         UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, cnt), (unsigned)cnt );
+         memcpy(&shadow[fill], buffer, cnt);
+         fill += cnt;
+      }
+
+      UT_ASSERT_EQUAL( circfifo_find(&fifo, '\n'), ut_find_ref(shadow, fill, '\n') );
+
+      /* consume up to and including the delimiter or random amount */
+      cnt = circfifo_find(&fifo, '\n') + 1;
+      if( 0 == cnt )
+      {
+         cnt = (fill > 0) ? random() % fill : 0;
+      }
+      if( cnt > 0 )
+      {
+         UT_ASSERT_EQUAL( circfifo_out(&fifo, buffer, cnt), (unsigned)cnt );
+         UT_ASSERT( 0 == memcmp(buffer, shadow, cnt) );
+         memmove(shadow, &shadow[cnt], fill - cnt);
+         fill -= cnt;
+      }
+   }
+}
+
+extern void ut_fifo_record_test(void)
+{
+   uint8_t fifo_data_buffer[301];
+   uint8_t buffer[300];
+   /* shadow queue of record lengths and first bytes */
+   unsigned rec_len[300];
+   uint8_t rec_seed[300];
+   unsigned head = 0, tail = 0;
+   circfifo_t fifo;
+   uint32_t test_loop;
+   unsigned len, i;
+   uint8_t seed = 0;
+   void *ptr;
+   int ret;
+
+   circfifo_init(&fifo, fifo_data_buffer, sizeof(fifo_data_buffer));
+   UT_ASSERT_EQUAL( circfifo_rec_len(&fifo), -1 );
+   UT_ASSERT_EQUAL( circfifo_rec_out(&fifo, buffer, sizeof(buffer)), -1 );
+   UT_ASSERT( NULL == circfifo_rec_ptr(&fifo, &len) );
+
+   /* record which does not fit is not written at all */
+   UT_ASSERT( !circfifo_rec_in(&fifo, buffer, 299, 0) );
+   UT_ASSERT( circfifo_rec_in(&fifo, buffer, 298, 0) );
+   UT_ASSERT_EQUAL( circfifo_count(&fifo), 300 );
+   UT_ASSERT( !circfifo_rec_in(&fifo, buffer, 0, 0) );
+   UT_ASSERT_EQUAL( circfifo_rec_len(&fifo), 298 );
+   /* too small buffer leaves the record in fifo */
+   UT_ASSERT_EQUAL( circfifo_rec_out(&fifo, buffer, 100), 298 );
+   UT_ASSERT_EQUAL( circfifo_rec_len(&fifo), 298 );
+   circfifo_rec_drop(&fifo);
+   UT_ASSERT_EQUAL( circfifo_rec_len(&fifo), -1 );
+
+   for( test_loop = 0; test_loop < 200000; test_loop++ )
+   {
+      if( random() % 2 )
+      {
+         unsigned flags = (test_loop & 0x400) ? CIRCFIFO_REC_CONTIG : 0;
+
+         len = (0 == random() % 16) ? random() % 200 : random() % 20;
+         for( i = 0; i < len; i++ )
+         {
+            buffer[i] = seed + i;
+         }
+         if( circfifo_rec_in(&fifo, buffer, len, flags) )
+         {
+            rec_len[head % 300] = len;
+            rec_seed[head % 300] = seed++;
+            head++;
+         }
+         else
+         {
+            /* fails on empty fifo only if padding does not leave space */
+            UT_ASSERT( (head != tail) || (flags & CIRCFIFO_REC_CONTIG) );
+         }
+      }
+      else if( head != tail )
+      {
+         len = rec_len[tail % 300];
+         UT_ASSERT_EQUAL( circfifo_rec_len(&fifo), (int)len );
+         ptr = circfifo_rec_ptr(&fifo, &i);
+         UT_ASSERT_EQUAL( i, len );
+         if( NULL != ptr )
+         {
+            /* in place access */
+            for( i = 0; i < len; i++ )
+            {
+               UT_ASSERT_EQUAL( ((uint8_t*)ptr)[i], (uint8_t)(rec_seed[tail % 300] + i) );
+            }
+            circfifo_rec_drop(&fifo);
+         }
+         else
+         {
+            memset(buffer, 0xAA, sizeof(buffer));
+            ret = circfifo_rec_out(&fifo, buffer, sizeof(buffer));
+            UT_ASSERT_EQUAL( ret, (int)len );
+            for( i = 0; i < len; i++ )
+            {
+               UT_ASSERT_EQUAL( buffer[i], (uint8_t)(rec_seed[tail % 300] + i) );
+            }
+         }
+         tail++;
+      }
+      else
+      {
+         UT_ASSERT_EQUAL( circfifo_rec_len(&fifo), -1 );
+      }
+   }
+
+   /* contiguous records are always accessible in place */
+   circfifo_init(&fifo, fifo_data_buffer, sizeof(fifo_data_buffer));
+   for( test_loop = 0; test_loop < 10000; test_loop++ )
+   {
+      len = random() % 150;
+      if( circfifo_rec_in(&fifo, buffer, len, CIRCFIFO_REC_CONTIG) )
+      {
+         continue;
+      }
+      UT_ASSERT( NULL != circfifo_rec_ptr(&fifo, &len) );
+      circfifo_rec_drop(&fifo);
+   }
+}
+
+#ifdef CONFIG_CIRCFIFO_STATS
+extern void ut_fifo_stats_test(void)
+{
+   uint8_t buffer[120];
+   uint8_t fifo_data_buffer[100];
+   circfifo_t fifo;
+   circfifo_stats_t stats;
+   int i;
+
+   circfifo_init(&fifo, fifo_data_buffer, sizeof(fifo_data_buffer));
+   memset(buffer, 0, sizeof(buffer));
+
+   UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, 50), 50 );
+   UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, 60), 49 );
+   UT_ASSERT_EQUAL( circfifo_out(&fifo, buffer, 10), 10 );
+   UT_ASSERT_EQUAL( circfifo_in(&fifo, buffer, 1), 1 );
+   UT_ASSERT_EQUAL( circfifo_out(&fifo, buffer, sizeof(buffer)), 90 );
+   UT_ASSERT_EQUAL( circfifo_out(&fifo, buffer, 1), 0 );
+
+   circfifo_stats_get(&fifo, &stats);
+   UT_ASSERT_EQUAL( stats.in.bytes, 100 );
+   UT_ASSERT_EQUAL( stats.in.short_cnt, 1 );
+   UT_ASSERT_EQUAL( stats.in.high_water, 99 );
+   UT_ASSERT_EQUAL( stats.out.bytes, 100 );
+   UT_ASSERT_EQUAL( stats.out.short_cnt, 2 );
+   for( i = 0; i < CIRCFIFO_STATS_HIST; i++ )
+   {
+      /* fill levels after writes were 50, 99 and 90 */
+      UT_ASSERT_EQUAL( stats.in.hist[i], (unsigned long)((4 == i) ? 1 : ((7 == i) ? 2 : 0)) );
+   }
+
+   /* producer and consumer counters never share the cache line */
+   UT_ASSERT( (offsetof(circfifo_stats_t, out) - offsetof(circfifo_stats_t, in)) >= CIRCFIFO_STATS_ALIGN );
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+   long seed = time(NULL);
+
+   if( argc > 1 )
+   {
+      ut_stress_bytes = (uint64_t)strtoul(argv[1], NULL, 0) << 20;
+   }
+
+   srandom(seed);
+   printf("Random seed = %li\n", seed);
+
+   return ut_run_suite(ut_fifo_suite, sizeof(ut_fifo_suite) / sizeof(ut_fifo_suite[0]));
+}
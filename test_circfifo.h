@@ -2,69 +2,135 @@
 #define __FIFO_TEST_H__
 
 /**
-  * \brief
-  * \pre
-  * \post
+  * \brief Fill and drain loop with the request bigger than fifo capacity
+  * \pre Empty fifo of 100 bytes
+  * \post Empty fifo
   *
   * \test
-  *   \li
+  *   \li Write of 100 bytes is truncated to fifo capacity (99 bytes)
+  *   \li Write to full fifo returns 0
+  *   \li Read returns the same data which was written
+  *   \li Read from empty fifo returns 0
   *
   * <b>Tested functions:</b><br>
-  *   \li \ref
+  *   \li \ref circfifo_in
+  *   \li \ref circfifo_out
   */
-extern void ut_ufifo_invalid_param(void);
+extern void ut_fifo_loop_test(void);
 
 /**
-  * \brief
-  * \pre
-  * \post
+  * \brief Two writes followed by two reads of half of the fifo capacity
+  * \pre Empty fifo of 100 bytes
+  * \post Empty fifo
   *
   * \test
-  *   \li
+  *   \li Indexes wrap around the end of buffer at every possible offset
+  *   \li Data read is equal to data written
   *
   * <b>Tested functions:</b><br>
-  *   \li \ref
+  *   \li \ref circfifo_in
+  *   \li \ref circfifo_out
   */
-extern void ut_ufifo_loop_test(void);
+extern void ut_fifo_loop_test2(void);
 
 /**
-  * \brief
-  * \pre
-  * \post
+  * \brief Corner case of fifo with only 2 bytes of storage
+  * \pre Empty fifo of 2 bytes
+  * \post Empty fifo
   *
   * \test
-  *   \li
+  *   \li Only one byte can be stored
+  *   \li Data read is equal to data written
   *
   * <b>Tested functions:</b><br>
-  *   \li \ref
+  *   \li \ref circfifo_in
+  *   \li \ref circfifo_out
   */
-extern void ut_ufifo_loop_test2(void);
+extern void ut_fifo_loop_test3(void);
 
 /**
-  * \brief
-  * \pre
-  * \post
+  * \brief Random sized writes and reads within one thread
+  * \pre Empty fifo of 100 bytes
+  * \post Fifo with random fill level
   *
   * \test
-  *   \li
+  *   \li Every write which fits into free space is accepted in whole
+  *   \li Every read up to the fill level is satisfied in whole
+  *   \li Byte sequence is preserved
   *
   * <b>Tested functions:</b><br>
-  *   \li \ref
+  *   \li \ref circfifo_in
+  *   \li \ref circfifo_out
   */
-extern void ut_ufifo_loop_test3(void);
+extern void ut_fifo_loop_test4(void);
 
 /**
-  * \brief
-  * \pre
-  * \post
+  * \brief Producer and consumer threads pinned to pairs of cores
+  * \pre Empty fifo, at least one CPU
+  * \post Empty fifo
   *
   * \test
-  *   \li
+  *   \li Random chunk sizes on both sides
+  *   \li Stream of sequence numbers is received intact and in order
+  *   \li Sustained throughput and end to end latency percentiles are reported
   *
   * <b>Tested functions:</b><br>
-  *   \li \ref
+  *   \li \ref circfifo_in
+  *   \li \ref circfifo_out
   */
-extern void ut_ufifo_loop_test4(void);
+extern void ut_fifo_stress_test(void);
 
-#endif /*__FIFO_TEST_H__*/
+/**
+  * \brief Search for delimiter byte in data available for read
+  * \pre Empty fifo of 200 bytes
+  * \post Fifo with random fill level
+  *
+  * \test
+  *   \li Each scan variant supported by the CPU finds the first match at every
+  *       position and does not read past the end of segment
+  *   \li Offset is the same as found by reference search for random content
+  *       and fill levels, also when data wraps around the end of buffer
+  *   \li Reading offset + 1 bytes returns the data up to the delimiter
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_find
+  */
+extern void ut_fifo_find_test(void);
+
+/**
+  * \brief Record mode
+  * \pre Empty fifo of 301 bytes
+  * \post Fifo with random records
+  *
+  * \test
+  *   \li Record which does not fit is not written at all
+  *   \li Too small read buffer leaves the record in fifo
+  *   \li Random sized records with and without CIRCFIFO_REC_CONTIG are read
+  *       in order, exactly one per call, in place when possible
+  *   \li Records written with CIRCFIFO_REC_CONTIG are always accessible in place
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_rec_in
+  *   \li \ref circfifo_rec_len
+  *   \li \ref circfifo_rec_out
+  *   \li \ref circfifo_rec_ptr
+  *   \li \ref circfifo_rec_drop
+  */
+extern void ut_fifo_record_test(void);
 
+/**
+  * \brief Statistics counters (only with CONFIG_CIRCFIFO_STATS)
+  * \pre Empty fifo of 100 bytes
+  * \post Empty fifo
+  *
+  * \test
+  *   \li Byte counters, short write and short read counters
+  *   \li High water mark and fill level histogram
+  *   \li Producer and consumer counters are placed in separate cache lines
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_stats_get
+  */
+extern void ut_fifo_stats_test(void);
+
+#endif /*__FIFO_TEST_H__*/
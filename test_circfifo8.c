@@ -0,0 +1,103 @@
+#include "arch.h"
+#include "circfifo8.h"
+#include "test_common.h"
+#include "test_circfifo8.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#define UT_SPSC_BYTES 1000000u
+
+static circfifo8_t ut_fifo;
+static uint8_t ut_buff[256];
+
+extern void ut_fifo8_loop_test(void)
+{
+   unsigned size, i, round;
+   uint8_t byte = 0;
+   uint8_t seq_in = 0;
+   uint8_t seq_out = 0;
+
+   for( size = 2; size <= 256; size <<= 1 )
+   {
+      circfifo8_init(&ut_fifo, ut_buff, size);
+      UT_ASSERT( !circfifo8_get(&ut_fifo, &byte) );
+
+      for( round = 0; round < 5; round++ )
+      {
+         for( i = 0; i < size - 1; i++ )
+         {
+            UT_ASSERT( circfifo8_put(&ut_fifo, seq_in++) );
+         }
+         UT_ASSERT_EQUAL( circfifo8_count(&ut_fifo), size - 1 );
+         UT_ASSERT( !circfifo8_put(&ut_fifo, 0xFF) );
+
+         /* each round starts one byte further, so indexes wrap at
+            different positions */
+         while( circfifo8_get(&ut_fifo, &byte) )
+         {
+            UT_ASSERT_EQUAL( byte, seq_out++ );
+         }
+         UT_ASSERT_EQUAL( circfifo8_count(&ut_fifo), 0 );
+      }
+   }
+}
+
+static void* ut_fifo8_producer(void *arg)
+{
+   unsigned i;
+
+   (void)arg;
+   for( i = 0; i < UT_SPSC_BYTES; )
+   {
+      if( circfifo8_put(&ut_fifo, (uint8_t)i) )
+      {
+         i++;
+      }
+      else
+      {
+         /* let the consumer run if both threads share one CPU */
+         sched_yield();
+      }
+   }
+
+   return NULL;
+}
+
+extern void ut_fifo8_spsc_test(void)
+{
+   pthread_t producer;
+   unsigned i;
+   unsigned errors = 0;
+   uint8_t byte = 0;
+
+   circfifo8_init(&ut_fifo, ut_buff, 16);
+   UT_ASSERT( 0 == pthread_create(&producer, NULL, ut_fifo8_producer, NULL) );
+
+   for( i = 0; i < UT_SPSC_BYTES; )
+   {
+      if( circfifo8_get(&ut_fifo, &byte) )
+      {
+         errors += (byte != (uint8_t)i);
+         i++;
+      }
+      else
+      {
+         sched_yield();
+      }
+   }
+   pthread_join(producer, NULL);
+
+   UT_ASSERT_EQUAL( errors, 0 );
+   UT_ASSERT( !circfifo8_get(&ut_fifo, &byte) );
+}
+
+static const ut_test_info_t ut_fifo8_suite[] = {
+   { "Loop test", ut_fifo8_loop_test },
+   { "SPSC test", ut_fifo8_spsc_test },
+};
+
+int main(void)
+{
+   return ut_run_suite(ut_fifo8_suite, sizeof(ut_fifo8_suite) / sizeof(ut_fifo8_suite[0]));
+}
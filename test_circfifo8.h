@@ -0,0 +1,35 @@
+#ifndef __CIRCFIFO8_TEST_H__
+#define __CIRCFIFO8_TEST_H__
+
+/**
+  * \brief Fill and drain of byte fifo for all supported sizes
+  * \pre Empty fifo of each power of 2 size from 2 to 256 bytes
+  * \post Empty fifo
+  *
+  * \test
+  *   \li Capacity is size - 1 and put to full fifo fails
+  *   \li Get from empty fifo fails
+  *   \li Bytes are received in order while indexes wrap several times
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo8_put
+  *   \li \ref circfifo8_get
+  *   \li \ref circfifo8_count
+  */
+extern void ut_fifo8_loop_test(void);
+
+/**
+  * \brief Producer and consumer threads, as ISR and main loop would use it
+  * \pre Empty fifo of 16 bytes
+  * \post Empty fifo
+  *
+  * \test
+  *   \li Byte stream of counter values is received intact and in order
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo8_put
+  *   \li \ref circfifo8_get
+  */
+extern void ut_fifo8_spsc_test(void);
+
+#endif /*__CIRCFIFO8_TEST_H__*/
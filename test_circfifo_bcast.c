@@ -0,0 +1,153 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "circfifo_bcast.h"
+#include "test_common.h"
+#include "test_circfifo_bcast.h"
+
+#include <stdlib.h>
+#include <time.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define UT_BCAST_READERS 3
+#define UT_BCAST_BYTES ((unsigned long)8 << 20)
+
+static circfifo_bcast_t ut_fifo;
+static circfifo_bcast_reader_t ut_readers[UT_BCAST_READERS];
+static uint8_t ut_fifo_data[4096];
+static unsigned long ut_errors[UT_BCAST_READERS];
+static unsigned long ut_read[UT_BCAST_READERS];
+static volatile bool ut_done;
+
+static inline uint8_t ut_stream_byte(unsigned long pos)
+{
+   return (uint8_t)(pos ^ (pos >> 8) ^ (pos >> 16));
+}
+
+extern void ut_fifo_bcast_basic_test(void)
+{
+   uint8_t buff[128];
+   uint8_t check[128];
+   unsigned long i;
+
+   for( i = 0; i < sizeof(buff); i++ )
+   {
+      buff[i] = ut_stream_byte(i);
+   }
+   /* cursors do not share cache line */
+   UT_ASSERT( sizeof(circfifo_bcast_reader_t) >= CACHELINE_SIZE );
+   UT_ASSERT( offsetof(circfifo_bcast_t, buff) - offsetof(circfifo_bcast_t, in) >= CACHELINE_SIZE );
+
+   circfifo_bcast_init(&ut_fifo, ut_fifo_data, 64, ut_readers, 2, 0);
+   UT_ASSERT_EQUAL( circfifo_bcast_in(&ut_fifo, buff, 100), 64 );
+   UT_ASSERT_EQUAL( circfifo_bcast_in(&ut_fifo, buff, 1), 0 );
+   UT_ASSERT_EQUAL( circfifo_bcast_out(&ut_fifo, 0, check, 40), 40 );
+   UT_ASSERT( 0 == memcmp(check, buff, 40) );
+   /* consumer 1 did not read yet */
+   UT_ASSERT_EQUAL( circfifo_bcast_in(&ut_fifo, &buff[64], 10), 0 );
+   UT_ASSERT_EQUAL( circfifo_bcast_out(&ut_fifo, 1, check, 20), 20 );
+   UT_ASSERT( 0 == memcmp(check, buff, 20) );
+   UT_ASSERT_EQUAL( circfifo_bcast_in(&ut_fifo, &buff[64], 30), 20 );
+   UT_ASSERT_EQUAL( circfifo_bcast_out(&ut_fifo, 0, check, sizeof(check)), 44 );
+   UT_ASSERT( 0 == memcmp(check, &buff[40], 44) );
+
+   /* detached consumer does not stall the producer */
+   circfifo_bcast_detach(&ut_fifo, 1);
+   UT_ASSERT_EQUAL( circfifo_bcast_in(&ut_fifo, &buff[84], 40), 40 );
+   UT_ASSERT_EQUAL( circfifo_bcast_out(&ut_fifo, 0, check, sizeof(check)), 40 );
+   UT_ASSERT( 0 == memcmp(check, &buff[84], 40) );
+   UT_ASSERT_EQUAL( circfifo_bcast_lost(&ut_fifo, 0), 0 );
+}
+
+static void* ut_bcast_consumer(void *arg)
+{
+   unsigned id = (uintptr_t)arg;
+   uint8_t buff[700];
+   unsigned long cnt, pos, i;
+   bool done;
+
+   do
+   {
+      done = __atomic_load_n(&ut_done, __ATOMIC_ACQUIRE);
+      cnt = circfifo_bcast_out(&ut_fifo, id, buff, 1 + random() % sizeof(buff));
+      pos = ut_readers[id].rd - cnt;
+      for( i = 0; i < cnt; i++ )
+      {
+         ut_errors[id] += (buff[i] != ut_stream_byte(pos + i));
+      }
+      ut_read[id] += cnt;
+      if( 0 == cnt )
+      {
+         sched_yield();
+      }
+   }while( !done || (0 != cnt) );
+
+   return NULL;
+}
+
+static void ut_bcast_run(unsigned flags)
+{
+   pthread_t consumers[UT_BCAST_READERS];
+   uint8_t buff[512];
+   unsigned long pos = 0;
+   unsigned long i, cnt;
+   unsigned id;
+
+   circfifo_bcast_init(&ut_fifo, ut_fifo_data, sizeof(ut_fifo_data), ut_readers, UT_BCAST_READERS, flags);
+   ut_done = false;
+   for( id = 0; id < UT_BCAST_READERS; id++ )
+   {
+      ut_errors[id] = 0;
+      ut_read[id] = 0;
+      UT_ASSERT( 0 == pthread_create(&consumers[id], NULL, ut_bcast_consumer, (void*)(uintptr_t)id) );
+   }
+
+   while( pos < UT_BCAST_BYTES )
+   {
+      cnt = 1 + random() % sizeof(buff);
+      for( i = 0; i < cnt; i++ )
+      {
+         buff[i] = ut_stream_byte(pos + i);
+      }
+      for( i = 0; i < cnt; )
+      {
+         unsigned long done = circfifo_bcast_in(&ut_fifo, &buff[i], cnt - i);
+         i += done;
+         if( 0 == done )
+         {
+            sched_yield();
+         }
+      }
+      pos += cnt;
+   }
+   __atomic_store_n(&ut_done, true, __ATOMIC_RELEASE);
+
+   for( id = 0; id < UT_BCAST_READERS; id++ )
+   {
+      pthread_join(consumers[id], NULL);
+      UT_ASSERT_EQUAL( ut_errors[id], 0 );
+      UT_ASSERT_EQUAL( ut_read[id] + circfifo_bcast_lost(&ut_fifo, id), pos );
+      if( 0 == (flags & CIRCFIFO_BCAST_DROP) )
+      {
+         UT_ASSERT_EQUAL( circfifo_bcast_lost(&ut_fifo, id), 0 );
+      }
+   }
+}
+
+extern void ut_fifo_bcast_concurrent_test(void)
+{
+   ut_bcast_run(0);
+   ut_bcast_run(CIRCFIFO_BCAST_DROP);
+}
+
+static const ut_test_info_t ut_fifo_bcast_suite[] = {
+   { "Basic", ut_fifo_bcast_basic_test },
+   { "Concurrent", ut_fifo_bcast_concurrent_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_fifo_bcast_suite, sizeof(ut_fifo_bcast_suite) / sizeof(ut_fifo_bcast_suite[0]));
+}
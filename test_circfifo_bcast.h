@@ -0,0 +1,37 @@
+#ifndef __CIRCFIFO_BCAST_TEST_H__
+#define __CIRCFIFO_BCAST_TEST_H__
+
+/**
+  * \brief Producer waits for the slowest consumer
+  * \pre Empty fifo of 64 bytes with 2 consumers
+  * \post Empty fifo
+  *
+  * \test
+  *   \li Write is limited by the slowest consumer
+  *   \li Each consumer receives the same data
+  *   \li Detached consumer no longer limits the producer
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_bcast_in
+  *   \li \ref circfifo_bcast_out
+  *   \li \ref circfifo_bcast_detach
+  */
+extern void ut_fifo_bcast_basic_test(void);
+
+/**
+  * \brief Producer and consumer threads in both modes
+  * \pre Empty fifo with 3 consumers
+  * \post All consumers read the whole stream
+  *
+  * \test
+  *   \li Gated mode: every consumer receives the whole stream intact
+  *   \li Drop mode: bytes are checked against their stream position, bytes
+  *       read and lost sum to bytes written for every consumer
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_bcast_in
+  *   \li \ref circfifo_bcast_out
+  */
+extern void ut_fifo_bcast_concurrent_test(void);
+
+#endif /*__CIRCFIFO_BCAST_TEST_H__*/
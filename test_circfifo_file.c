@@ -0,0 +1,203 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "circfifo_file.h"
+#include "test_common.h"
+#include "test_circfifo_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#define UT_FILE_SIZE 8192
+#define UT_THREAD_RECORDS 20000
+
+static char ut_path[] = "/tmp/ut_circfifo_file_XXXXXX";
+
+/* record seq has length seq % 100 and bytes derived from seq */
+static unsigned ut_record_fill(uint8_t *buff, unsigned seq)
+{
+   unsigned len = seq % 100;
+   unsigned i;
+
+   for( i = 0; i < len; i++ )
+   {
+      buff[i] = (uint8_t)(seq * 3 + i);
+   }
+   return len;
+}
+
+static bool ut_record_check(unsigned seq, const uint8_t *buff, int len)
+{
+   uint8_t check[128];
+
+   return (len == (int)ut_record_fill(check, seq)) && (0 == memcmp(buff, check, len));
+}
+
+static void ut_new_file(void)
+{
+   int fd;
+
+   strcpy(ut_path, "/tmp/ut_circfifo_file_XXXXXX");
+   fd = mkstemp(ut_path);
+   UT_ASSERT( fd >= 0 );
+   close(fd);
+}
+
+extern void ut_fifo_file_reopen_test(void)
+{
+   circfifo_file_t cf;
+   uint8_t buff[128];
+   unsigned wr_seq = 0, rd_seq = 0;
+   unsigned round, i;
+   int len;
+
+   ut_new_file();
+   for( round = 0; round < 20; round++ )
+   {
+      UT_ASSERT_EQUAL( circfifo_file_open(&cf, ut_path, UT_FILE_SIZE, 1024), 0 );
+      UT_ASSERT_EQUAL( cf.recovered, wr_seq - rd_seq );
+      /* fill until full, what wraps the indexes */
+      while( circfifo_file_put(&cf, buff, ut_record_fill(buff, wr_seq)) )
+      {
+         wr_seq++;
+      }
+      UT_ASSERT( !circfifo_file_put(&cf, buff, UT_FILE_SIZE) );
+      /* consume part of records */
+      for( i = 0; i < 50; i++ )
+      {
+         len = circfifo_file_get(&cf, buff, sizeof(buff));
+         UT_ASSERT( ut_record_check(rd_seq, buff, len) );
+         rd_seq++;
+      }
+      circfifo_file_close(&cf);
+   }
+
+   UT_ASSERT_EQUAL( circfifo_file_open(&cf, ut_path, UT_FILE_SIZE, 0), 0 );
+   while( (len = circfifo_file_get(&cf, buff, sizeof(buff))) >= 0 )
+   {
+      UT_ASSERT( ut_record_check(rd_seq, buff, len) );
+      rd_seq++;
+   }
+   UT_ASSERT_EQUAL( rd_seq, wr_seq );
+   circfifo_file_close(&cf);
+
+   UT_ASSERT( circfifo_file_open(&cf, ut_path, UT_FILE_SIZE * 2, 0) < 0 );
+   unlink(ut_path);
+}
+
+extern void ut_fifo_file_recovery_test(void)
+{
+   circfifo_file_t cf;
+   uint8_t buff[128];
+   unsigned seq;
+   uint32_t wr;
+   int len, fd;
+
+   ut_new_file();
+   UT_ASSERT_EQUAL( circfifo_file_open(&cf, ut_path, UT_FILE_SIZE, ~0u), 0 );
+   for( seq = 0; seq < 100; seq++ )
+   {
+      UT_ASSERT( circfifo_file_put(&cf, buff, ut_record_fill(buff, seq)) );
+   }
+   /* header write index is lost as if it was not flushed before the crash */
+   wr = cf.hdr->wr;
+   cf.hdr->wr = 0;
+   cf.hdr->wr_seq = 0;
+   circfifo_file_close(&cf);
+
+   UT_ASSERT_EQUAL( circfifo_file_open(&cf, ut_path, UT_FILE_SIZE, ~0u), 0 );
+   UT_ASSERT_EQUAL( cf.recovered, 100 );
+   UT_ASSERT_EQUAL( cf.hdr->wr, wr );
+   circfifo_file_close(&cf);
+
+   /* torn last record */
+   fd = open(ut_path, O_RDWR);
+   UT_ASSERT( fd >= 0 );
+   UT_ASSERT_EQUAL( pwrite(fd, "X", 1, 4096 + wr - 3), 1 );
+   close(fd);
+   UT_ASSERT_EQUAL( circfifo_file_open(&cf, ut_path, UT_FILE_SIZE, ~0u), 0 );
+   UT_ASSERT_EQUAL( cf.recovered, 99 );
+   for( seq = 0; seq < 99; seq++ )
+   {
+      len = circfifo_file_get(&cf, buff, sizeof(buff));
+      UT_ASSERT( ut_record_check(seq, buff, len) );
+   }
+   UT_ASSERT_EQUAL( circfifo_file_get(&cf, buff, sizeof(buff)), -1 );
+   circfifo_file_close(&cf);
+
+   /* consumed records from the previous lap are still in the file but they
+    * are not valid after read index */
+   UT_ASSERT_EQUAL( circfifo_file_open(&cf, ut_path, UT_FILE_SIZE, ~0u), 0 );
+   UT_ASSERT_EQUAL( cf.recovered, 0 );
+   cf.hdr->rd = 0;
+   circfifo_file_close(&cf);
+   UT_ASSERT_EQUAL( circfifo_file_open(&cf, ut_path, UT_FILE_SIZE, ~0u), 0 );
+   UT_ASSERT_EQUAL( cf.recovered, 0 );
+   circfifo_file_close(&cf);
+
+   unlink(ut_path);
+}
+
+static void* ut_file_producer(void *arg)
+{
+   circfifo_file_t *cf = arg;
+   uint8_t buff[128];
+   unsigned seq;
+
+   for( seq = 0; seq < UT_THREAD_RECORDS; seq++ )
+   {
+      unsigned len = ut_record_fill(buff, seq);
+
+      while( !circfifo_file_put(cf, buff, len) )
+      {
+         sched_yield();
+      }
+   }
+   return NULL;
+}
+
+extern void ut_fifo_file_thread_test(void)
+{
+   circfifo_file_t cf;
+   pthread_t tid;
+   uint8_t buff[128];
+   unsigned seq = 0;
+   unsigned errors = 0;
+   int len;
+
+   ut_new_file();
+   UT_ASSERT_EQUAL( circfifo_file_open(&cf, ut_path, UT_FILE_SIZE, 4096), 0 );
+   UT_ASSERT_EQUAL( pthread_create(&tid, NULL, ut_file_producer, &cf), 0 );
+   while( seq < UT_THREAD_RECORDS )
+   {
+      len = circfifo_file_get(&cf, buff, sizeof(buff));
+      if( len < 0 )
+      {
+         sched_yield();
+         continue;
+      }
+      errors += !ut_record_check(seq, buff, len);
+      seq++;
+   }
+   pthread_join(tid, NULL);
+   UT_ASSERT_EQUAL( errors, 0 );
+   UT_ASSERT_EQUAL( circfifo_file_get(&cf, buff, sizeof(buff)), -1 );
+   circfifo_file_close(&cf);
+
+   unlink(ut_path);
+}
+
+static const ut_test_info_t ut_fifo_file_suite[] = {
+   { "Reopen", ut_fifo_file_reopen_test },
+   { "Recovery", ut_fifo_file_recovery_test },
+   { "Threads", ut_fifo_file_thread_test },
+};
+
+int main(void)
+{
+   return ut_run_suite(ut_fifo_file_suite, sizeof(ut_fifo_file_suite) / sizeof(ut_fifo_file_suite[0]));
+}
@@ -0,0 +1,54 @@
+#ifndef __CIRCFIFO_FILE_TEST_H__
+#define __CIRCFIFO_FILE_TEST_H__
+
+/**
+  * \brief Records survive close and reopen
+  * \pre New fifo file
+  * \post File removed
+  *
+  * \test
+  *   \li Records written before close are read after reopen, in order
+  *   \li Read index is persistent, consumed records are not returned again
+  *   \li Record which does not fit is rejected, fifo wraps correctly
+  *   \li File with different size is rejected
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_file_open
+  *   \li \ref circfifo_file_put
+  *   \li \ref circfifo_file_get
+  *   \li \ref circfifo_file_close
+  */
+extern void ut_fifo_file_reopen_test(void);
+
+/**
+  * \brief Recovery after simulated crash
+  * \pre Fifo file with records
+  * \post File removed
+  *
+  * \test
+  *   \li Write index in header older than data, recovery finds all records
+  *   \li Torn last record is dropped, all records before it are recovered
+  *   \li Stale records from the previous lap are not recovered
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_file_open
+  *   \li \ref circfifo_file_sync
+  */
+extern void ut_fifo_file_recovery_test(void);
+
+/**
+  * \brief Producer and consumer in different threads
+  * \pre New fifo file
+  * \post File removed
+  *
+  * \test
+  *   \li Producer thread puts records, syncs while consumer reads them
+  *   \li Consumer gets all records in order with correct content
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_file_put
+  *   \li \ref circfifo_file_get
+  */
+extern void ut_fifo_file_thread_test(void);
+
+#endif /*__CIRCFIFO_FILE_TEST_H__*/
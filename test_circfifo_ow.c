@@ -0,0 +1,192 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "circfifo_ow.h"
+#include "test_common.h"
+#include "test_circfifo_ow.h"
+
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define UT_OW_BYTES ((unsigned long)32 << 20)
+#define UT_OW_RECORDS 1000000ul
+
+static circfifo_ow_t ut_fifo;
+static uint8_t ut_fifo_data[1024];
+static volatile bool ut_done;
+
+static inline uint8_t ut_stream_byte(unsigned long pos)
+{
+   return (uint8_t)(pos ^ (pos >> 8) ^ (pos >> 16));
+}
+
+/* record seq has length seq % 50 + 4 and bytes derived from seq */
+static unsigned ut_record_fill(uint8_t *buff, uint32_t seq)
+{
+   unsigned len = seq % 50 + sizeof(seq);
+   unsigned i;
+
+   memcpy(buff, &seq, sizeof(seq));
+   for( i = sizeof(seq); i < len; i++ )
+   {
+      buff[i] = (uint8_t)(seq + i);
+   }
+   return len;
+}
+
+extern void ut_fifo_ow_basic_test(void)
+{
+   uint8_t buff[256];
+   uint8_t check[256];
+   unsigned long i;
+   uint32_t seq;
+
+   for( i = 0; i < sizeof(buff); i++ )
+   {
+      buff[i] = ut_stream_byte(i);
+   }
+
+   circfifo_ow_init(&ut_fifo, ut_fifo_data, 64);
+   UT_ASSERT_EQUAL( circfifo_ow_out(&ut_fifo, check, sizeof(check)), 0 );
+   circfifo_ow_in(&ut_fifo, buff, 40);
+   UT_ASSERT_EQUAL( circfifo_ow_out(&ut_fifo, check, 10), 10 );
+   UT_ASSERT( 0 == memcmp(check, buff, 10) );
+   /* 30 bytes unread, 60 more written, 26 oldest are lost */
+   circfifo_ow_in(&ut_fifo, &buff[40], 60);
+   UT_ASSERT_EQUAL( circfifo_ow_out(&ut_fifo, check, sizeof(check)), 64 );
+   UT_ASSERT( 0 == memcmp(check, &buff[36], 64) );
+   UT_ASSERT_EQUAL( circfifo_ow_lost(&ut_fifo), 26 );
+
+   /* write bigger than fifo */
+   circfifo_ow_in(&ut_fifo, &buff[100], 150);
+   UT_ASSERT_EQUAL( circfifo_ow_out(&ut_fifo, check, sizeof(check)), 64 );
+   UT_ASSERT( 0 == memcmp(check, &buff[186], 64) );
+   UT_ASSERT_EQUAL( circfifo_ow_lost(&ut_fifo), 26 + 86 );
+
+   /* records of 2 + 10 bytes, only 5 fit */
+   circfifo_ow_init(&ut_fifo, ut_fifo_data, 64);
+   UT_ASSERT_EQUAL( circfifo_ow_rec_out(&ut_fifo, check, sizeof(check)), -1 );
+   for( seq = 0; seq < 10; seq++ )
+   {
+      memset(buff, seq, 10);
+      circfifo_ow_rec_in(&ut_fifo, buff, 10);
+   }
+   /* too small buffer leaves the record in fifo */
+   UT_ASSERT_EQUAL( circfifo_ow_rec_out(&ut_fifo, check, 5), 10 );
+   for( seq = 5; seq < 10; seq++ )
+   {
+      UT_ASSERT_EQUAL( circfifo_ow_rec_out(&ut_fifo, check, sizeof(check)), 10 );
+      UT_ASSERT_EQUAL( check[0], seq );
+      UT_ASSERT_EQUAL( check[9], seq );
+   }
+   UT_ASSERT_EQUAL( circfifo_ow_rec_out(&ut_fifo, check, sizeof(check)), -1 );
+   UT_ASSERT_EQUAL( circfifo_ow_lost(&ut_fifo), 5 * 12 );
+}
+
+static void* ut_ow_byte_producer(void *arg)
+{
+   uint8_t buff[256];
+   unsigned long pos = 0;
+   unsigned long i, cnt;
+
+   (void)arg;
+   while( pos < UT_OW_BYTES )
+   {
+      cnt = 1 + random() % sizeof(buff);
+      for( i = 0; i < cnt; i++ )
+      {
+         buff[i] = ut_stream_byte(pos + i);
+      }
+      circfifo_ow_in(&ut_fifo, buff, cnt);
+      pos += cnt;
+   }
+   __atomic_store_n(&ut_done, true, __ATOMIC_RELEASE);
+
+   return NULL;
+}
+
+static void* ut_ow_record_producer(void *arg)
+{
+   uint8_t buff[64];
+   uint32_t seq;
+
+   (void)arg;
+   for( seq = 0; seq < UT_OW_RECORDS; seq++ )
+   {
+      circfifo_ow_rec_in(&ut_fifo, buff, ut_record_fill(buff, seq));
+   }
+   __atomic_store_n(&ut_done, true, __ATOMIC_RELEASE);
+
+   return NULL;
+}
+
+extern void ut_fifo_ow_concurrent_test(void)
+{
+   uint8_t buff[300];
+   uint8_t check[64];
+   pthread_t producer;
+   unsigned long read = 0;
+   unsigned long errors = 0;
+   unsigned long i, cnt, pos;
+   uint32_t seq, last_seq = 0;
+   bool done;
+   long len;
+
+   circfifo_ow_init(&ut_fifo, ut_fifo_data, sizeof(ut_fifo_data));
+   ut_done = false;
+   UT_ASSERT( 0 == pthread_create(&producer, NULL, ut_ow_byte_producer, NULL) );
+   do
+   {
+      done = __atomic_load_n(&ut_done, __ATOMIC_ACQUIRE);
+      cnt = circfifo_ow_out(&ut_fifo, buff, 1 + random() % sizeof(buff));
+      pos = ut_fifo.out.rd - cnt;
+      for( i = 0; i < cnt; i++ )
+      {
+         errors += (buff[i] != ut_stream_byte(pos + i));
+      }
+      read += cnt;
+      if( 0 == cnt )
+      {
+         sched_yield();
+      }
+   }while( !done || (0 != cnt) );
+   pthread_join(producer, NULL);
+   UT_ASSERT_EQUAL( errors, 0 );
+   UT_ASSERT_EQUAL( read + circfifo_ow_lost(&ut_fifo), ut_fifo.in.head );
+
+   circfifo_ow_init(&ut_fifo, ut_fifo_data, sizeof(ut_fifo_data));
+   ut_done = false;
+   read = 0;
+   UT_ASSERT( 0 == pthread_create(&producer, NULL, ut_ow_record_producer, NULL) );
+   do
+   {
+      done = __atomic_load_n(&ut_done, __ATOMIC_ACQUIRE);
+      len = circfifo_ow_rec_out(&ut_fifo, buff, sizeof(buff));
+      if( len < 0 )
+      {
+         sched_yield();
+         continue;
+      }
+      memcpy(&seq, buff, sizeof(seq));
+      errors += ((unsigned long)len != ut_record_fill(check, seq));
+      errors += (0 != memcmp(buff, check, min((unsigned long)len, sizeof(check))));
+      errors += (read > 0) && (seq <= last_seq);
+      last_seq = seq;
+      read++;
+   }while( !done || (len >= 0) );
+   pthread_join(producer, NULL);
+   UT_ASSERT_EQUAL( errors, 0 );
+   UT_ASSERT_EQUAL( last_seq, UT_OW_RECORDS - 1 );
+}
+
+static const ut_test_info_t ut_fifo_ow_suite[] = {
+   { "Basic", ut_fifo_ow_basic_test },
+   { "Concurrent", ut_fifo_ow_concurrent_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_fifo_ow_suite, sizeof(ut_fifo_ow_suite) / sizeof(ut_fifo_ow_suite[0]));
+}
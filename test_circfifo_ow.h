@@ -0,0 +1,41 @@
+#ifndef __CIRCFIFO_OW_TEST_H__
+#define __CIRCFIFO_OW_TEST_H__
+
+/**
+  * \brief Overwrite of the oldest bytes and records
+  * \pre Empty fifo of 64 bytes
+  * \post Empty fifo
+  *
+  * \test
+  *   \li Consumer gets the newest bytes, overwritten ones are counted as lost
+  *   \li Write bigger than fifo keeps only its last bytes
+  *   \li In record mode the oldest whole records are dropped
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_ow_in
+  *   \li \ref circfifo_ow_out
+  *   \li \ref circfifo_ow_rec_in
+  *   \li \ref circfifo_ow_rec_out
+  */
+extern void ut_fifo_ow_basic_test(void);
+
+/**
+  * \brief Producer overruns concurrent consumer
+  * \pre Empty fifo
+  * \post Consumer read all bytes which were not lost
+  *
+  * \test
+  *   \li Bytes are checked against their stream position, torn data is
+  *       never returned
+  *   \li Records are never torn and come in order
+  *   \li Bytes read and lost sum to bytes written
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_ow_in
+  *   \li \ref circfifo_ow_out
+  *   \li \ref circfifo_ow_rec_in
+  *   \li \ref circfifo_ow_rec_out
+  */
+extern void ut_fifo_ow_concurrent_test(void);
+
+#endif /*__CIRCFIFO_OW_TEST_H__*/
@@ -0,0 +1,166 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "circfifo_shm.h"
+#include "test_common.h"
+#include "test_circfifo_shm.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#define UT_SHM_BYTES ((unsigned long)16 << 20)
+
+static char ut_name[64];
+
+static inline uint8_t ut_stream_byte(unsigned long pos)
+{
+   return (uint8_t)(pos ^ (pos >> 8) ^ (pos >> 16));
+}
+
+extern void ut_fifo_shm_attach_test(void)
+{
+   circfifo_shm_t a, b;
+   uint8_t buff[200];
+   unsigned i;
+
+   for( i = 0; i < sizeof(buff); i++ )
+   {
+      buff[i] = ut_stream_byte(i);
+   }
+   UT_ASSERT_EQUAL( circfifo_shm_create(&a, ut_name, 100), 0 );
+   UT_ASSERT_EQUAL( circfifo_shm_create(&b, ut_name, 100), -EEXIST );
+   UT_ASSERT_EQUAL( circfifo_shm_attach(&b, ut_name), 0 );
+   UT_ASSERT( a.buff != b.buff );
+
+   for( i = 0; i < 10; i++ )
+   {
+      uint8_t check[200];
+
+      UT_ASSERT_EQUAL( circfifo_shm_in(&a, buff, sizeof(buff)), 99 );
+      UT_ASSERT_EQUAL( circfifo_shm_in(&a, buff, 1), 0 );
+      UT_ASSERT_EQUAL( circfifo_shm_out(&b, check, 60), 60 );
+      UT_ASSERT_EQUAL( circfifo_shm_out(&b, &check[60], sizeof(check)), 39 );
+      UT_ASSERT( 0 == memcmp(check, buff, 99) );
+      UT_ASSERT_EQUAL( circfifo_shm_out(&b, check, 1), 0 );
+   }
+   circfifo_shm_detach(&b);
+
+   a.hdr->version++;
+   UT_ASSERT_EQUAL( circfifo_shm_attach(&b, ut_name), -EINVAL );
+   a.hdr->version--;
+   a.hdr->size += 4096;
+   UT_ASSERT_EQUAL( circfifo_shm_attach(&b, ut_name), -EINVAL );
+   a.hdr->size -= 4096;
+   UT_ASSERT_EQUAL( circfifo_shm_attach(&b, ut_name), 0 );
+
+   /* header changed by other process after attach is not trusted */
+   UT_ASSERT_EQUAL( circfifo_shm_in(&a, buff, 10), 10 );
+   a.hdr->size += 4096;
+   a.hdr->wr = 150;
+   UT_ASSERT_EQUAL( circfifo_shm_out(&b, buff, sizeof(buff)), 0 );
+   UT_ASSERT_EQUAL( circfifo_shm_in(&a, buff, 10), 0 );
+   /* valid index makes the fifo full, size of the mapping is used */
+   a.hdr->wr = (a.hdr->rd + 99) % 100;
+   UT_ASSERT_EQUAL( circfifo_shm_out(&b, buff, sizeof(buff)), 99 );
+   a.hdr->size -= 4096;
+   circfifo_shm_detach(&b);
+
+   circfifo_shm_detach(&a);
+   UT_ASSERT_EQUAL( circfifo_shm_unlink(ut_name), 0 );
+   UT_ASSERT_EQUAL( circfifo_shm_attach(&b, ut_name), -ENOENT );
+}
+
+static int ut_shm_producer(void)
+{
+   circfifo_shm_t cs;
+   uint8_t buff[1000];
+   unsigned long pos = 0;
+   unsigned i, cnt, done;
+
+   if( 0 != circfifo_shm_attach(&cs, ut_name) )
+   {
+      return 1;
+   }
+   while( pos < UT_SHM_BYTES )
+   {
+      cnt = 1 + random() % sizeof(buff);
+      cnt = min((unsigned long)cnt, UT_SHM_BYTES - pos);
+      for( i = 0; i < cnt; i++ )
+      {
+         buff[i] = ut_stream_byte(pos + i);
+      }
+      for( i = 0; i < cnt; i += done )
+      {
+         done = circfifo_shm_in(&cs, &buff[i], cnt - i);
+         if( 0 == done )
+         {
+            sched_yield();
+         }
+      }
+      pos += cnt;
+   }
+   circfifo_shm_detach(&cs);
+
+   return 0;
+}
+
+extern void ut_fifo_shm_process_test(void)
+{
+   circfifo_shm_t cs;
+   uint8_t buff[777];
+   unsigned long pos = 0;
+   unsigned long errors = 0;
+   unsigned i, cnt;
+   int status;
+   pid_t pid;
+
+   UT_ASSERT_EQUAL( circfifo_shm_create(&cs, ut_name, 4096), 0 );
+   pid = fork();
+   if( 0 == pid )
+   {
+      _exit(ut_shm_producer());
+   }
+   UT_ASSERT( pid > 0 );
+
+   while( pos < UT_SHM_BYTES )
+   {
+      cnt = circfifo_shm_out(&cs, buff, 1 + random() % sizeof(buff));
+      for( i = 0; i < cnt; i++ )
+      {
+         errors += (buff[i] != ut_stream_byte(pos + i));
+      }
+      pos += cnt;
+      if( 0 == cnt )
+      {
+         if( 0 != waitpid(pid, &status, WNOHANG) )
+         {
+            /* producer died before sending everything */
+            break;
+         }
+         sched_yield();
+      }
+   }
+   UT_ASSERT_EQUAL( pos, UT_SHM_BYTES );
+   UT_ASSERT_EQUAL( errors, 0 );
+   UT_ASSERT_EQUAL( waitpid(pid, &status, 0), pid );
+   UT_ASSERT( WIFEXITED(status) && (0 == WEXITSTATUS(status)) );
+
+   circfifo_shm_detach(&cs);
+   UT_ASSERT_EQUAL( circfifo_shm_unlink(ut_name), 0 );
+}
+
+static const ut_test_info_t ut_fifo_shm_suite[] = {
+   { "Attach", ut_fifo_shm_attach_test },
+   { "Processes", ut_fifo_shm_process_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   snprintf(ut_name, sizeof(ut_name), "/ut_circfifo_shm_%d", (int)getpid());
+   return ut_run_suite(ut_fifo_shm_suite, sizeof(ut_fifo_shm_suite) / sizeof(ut_fifo_shm_suite[0]));
+}
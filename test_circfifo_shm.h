@@ -0,0 +1,42 @@
+#ifndef __CIRCFIFO_SHM_TEST_H__
+#define __CIRCFIFO_SHM_TEST_H__
+
+/**
+  * \brief Create, attach and header validation
+  * \pre No shared memory object with test name
+  * \post Object removed
+  *
+  * \test
+  *   \li Second create of the same name fails
+  *   \li Data written through one mapping is read through another one mapped
+  *       at different address
+  *   \li Attach fails for wrong version and for size which does not match
+  *       the object
+  *   \li Size changed after attach is ignored, index out of range stops the
+  *       transfer in both directions
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_shm_create
+  *   \li \ref circfifo_shm_attach
+  *   \li \ref circfifo_shm_in
+  *   \li \ref circfifo_shm_out
+  */
+extern void ut_fifo_shm_attach_test(void);
+
+/**
+  * \brief Producer and consumer in separate processes
+  * \pre Object created by consumer
+  * \post Object removed
+  *
+  * \test
+  *   \li Child process attaches by name and streams data in random chunks
+  *   \li Stream is received intact and in order
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_shm_attach
+  *   \li \ref circfifo_shm_in
+  *   \li \ref circfifo_shm_out
+  */
+extern void ut_fifo_shm_process_test(void);
+
+#endif /*__CIRCFIFO_SHM_TEST_H__*/
@@ -0,0 +1,289 @@
+#define _GNU_SOURCE /* for O_DIRECT */
+
+#include "arch.h"
+#include "gmacros.h"
+#include "circfifo_sink.h"
+#include "test_common.h"
+#include "test_circfifo_sink.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#define UT_SINK_BYTES ((unsigned long)4 << 20)
+#define UT_SINK_FIFO (64 * 1024)
+#define UT_SINK_CHUNK 8192
+
+static inline uint8_t ut_stream_byte(unsigned long pos)
+{
+   return (uint8_t)(pos ^ (pos >> 8) ^ (pos >> 16));
+}
+
+static int ut_sink_tmpfile(char *path, size_t size)
+{
+   snprintf(path, size, "/tmp/ut_circfifo_sink_XXXXXX");
+   return mkstemp(path);
+}
+
+/* checks that file has exactly len bytes of the stream */
+static void ut_sink_verify(int fd, unsigned long len)
+{
+   uint8_t buff[4096];
+   unsigned long pos = 0;
+   unsigned long errors = 0;
+   ssize_t ret;
+   ssize_t i;
+
+   while( (ret = pread(fd, buff, sizeof(buff), pos)) > 0 )
+   {
+      for( i = 0; i < ret; i++ )
+      {
+         errors += (buff[i] != ut_stream_byte(pos + i));
+      }
+      pos += ret;
+   }
+   UT_ASSERT_EQUAL( pos, len );
+   UT_ASSERT_EQUAL( errors, 0 );
+}
+
+/* streams len bytes through the sink in random chunks */
+static void ut_sink_stream(unsigned flags, int fd, circfifo_t *fifo,
+                           unsigned long len)
+{
+   circfifo_sink_t sink;
+   uint8_t chunk[3000];
+   unsigned long pos = 0;
+   unsigned long retired = 0;
+   int ret = 0;
+
+   UT_ASSERT_EQUAL( circfifo_sink_init(&sink, fifo, fd, 16, UT_SINK_CHUNK, flags), 0 );
+   if( 0 == (flags & CIRCFIFO_SINK_THREADS) )
+   {
+      printf("io_uring %s ", circfifo_sink_uring(&sink) ? "used" : "not available");
+   }
+   while( (pos < len) && (ret >= 0) )
+   {
+      unsigned cnt = min(1 + (unsigned long)random() % sizeof(chunk), len - pos);
+      unsigned i;
+
+      for( i = 0; i < cnt; i++ )
+      {
+         chunk[i] = ut_stream_byte(pos + i);
+      }
+      i = 0;
+      while( (i < cnt) && (ret >= 0) )
+      {
+         i += circfifo_in(fifo, &chunk[i], cnt - i);
+         ret = circfifo_sink_poll(&sink);
+         retired += (ret > 0) ? ret : 0;
+      }
+      pos += cnt;
+   }
+   UT_ASSERT( ret >= 0 );
+   UT_ASSERT_EQUAL( circfifo_sink_flush(&sink), 0 );
+   UT_ASSERT_EQUAL( circfifo_count(fifo), 0 );
+   UT_ASSERT( retired <= len );
+   circfifo_sink_destroy(&sink);
+}
+
+static void ut_sink_run(unsigned flags)
+{
+   uint8_t *buff = malloc(UT_SINK_FIFO);
+   circfifo_sink_t sink;
+   circfifo_t fifo;
+   char path[64];
+   int fd = ut_sink_tmpfile(path, sizeof(path));
+   int rofd;
+   int ret;
+
+   UT_ASSERT( fd >= 0 );
+   circfifo_init(&fifo, buff, UT_SINK_FIFO);
+   ut_sink_stream(flags, fd, &fifo, UT_SINK_BYTES);
+   ut_sink_verify(fd, UT_SINK_BYTES);
+
+   /* write into file opened for read only fails */
+   rofd = open(path, O_RDONLY);
+   UT_ASSERT( rofd >= 0 );
+   UT_ASSERT_EQUAL( circfifo_sink_init(&sink, &fifo, rofd, 4, 100, flags), 0 );
+   UT_ASSERT_EQUAL( circfifo_in(&fifo, buff, 1000), 1000 );
+   ret = circfifo_sink_flush(&sink);
+   UT_ASSERT_EQUAL( ret, -EBADF );
+   UT_ASSERT_EQUAL( circfifo_sink_poll(&sink), -EBADF );
+   UT_ASSERT_EQUAL( circfifo_count(&fifo), 1000 );
+   circfifo_sink_destroy(&sink);
+
+   close(rofd);
+   close(fd);
+   unlink(path);
+   free(buff);
+}
+
+extern void ut_sink_uring_test(void)
+{
+   ut_sink_run(0);
+}
+
+extern void ut_sink_threads_test(void)
+{
+   ut_sink_run(CIRCFIFO_SINK_THREADS);
+}
+
+extern void ut_sink_direct_test(void)
+{
+   circfifo_sink_t sink;
+   circfifo_t fifo;
+   uint8_t *buff = NULL;
+   char path[64];
+   unsigned long len = UT_SINK_BYTES + 1234;
+   int fd = ut_sink_tmpfile(path, sizeof(path));
+   int dfd;
+   unsigned flags;
+
+   UT_ASSERT( fd >= 0 );
+   UT_ASSERT_EQUAL( posix_memalign((void**)&buff, CIRCFIFO_SINK_ALIGN, UT_SINK_FIFO), 0 );
+   dfd = open(path, O_WRONLY | O_DIRECT);
+   if( dfd < 0 )
+   {
+      printf("O_DIRECT not supported ");
+   }
+   else
+   {
+      circfifo_init(&fifo, buff + 1, UT_SINK_FIFO - 1);
+      UT_ASSERT_EQUAL( circfifo_sink_init(&sink, &fifo, dfd, 4, UT_SINK_CHUNK, CIRCFIFO_SINK_DIRECT), -EINVAL );
+      circfifo_init(&fifo, buff, UT_SINK_FIFO);
+      UT_ASSERT_EQUAL( circfifo_sink_init(&sink, &fifo, dfd, 4, 1000, CIRCFIFO_SINK_DIRECT), -EINVAL );
+      UT_ASSERT_EQUAL( circfifo_sink_init(&sink, &fifo, dfd, 4, 3 * CIRCFIFO_SINK_ALIGN, CIRCFIFO_SINK_DIRECT), -EINVAL );
+
+      /* tail shorter than chunk stays in fifo until flush */
+      UT_ASSERT_EQUAL( circfifo_sink_init(&sink, &fifo, dfd, 4, UT_SINK_CHUNK, CIRCFIFO_SINK_DIRECT), 0 );
+      UT_ASSERT_EQUAL( circfifo_in(&fifo, buff, 100), 100 );
+      UT_ASSERT_EQUAL( circfifo_sink_poll(&sink), 0 );
+      UT_ASSERT_EQUAL( circfifo_count(&fifo), 100 );
+      circfifo_sink_destroy(&sink);
+      /* read index has to be at chunk boundary */
+      UT_ASSERT_EQUAL( circfifo_sink_init(&sink, &fifo, dfd, 4, UT_SINK_CHUNK, CIRCFIFO_SINK_DIRECT), 0 );
+      UT_ASSERT_EQUAL( circfifo_sink_flush(&sink), 0 );
+      circfifo_sink_destroy(&sink);
+      UT_ASSERT_EQUAL( circfifo_sink_init(&sink, &fifo, dfd, 4, UT_SINK_CHUNK, CIRCFIFO_SINK_DIRECT), -EINVAL );
+
+      for( flags = 0; flags <= CIRCFIFO_SINK_THREADS; flags += CIRCFIFO_SINK_THREADS )
+      {
+         UT_ASSERT_EQUAL( ftruncate(dfd, 0), 0 );
+         UT_ASSERT_EQUAL( lseek(dfd, 0, SEEK_SET), 0 );
+         UT_ASSERT_EQUAL( fcntl(dfd, F_SETFL, fcntl(dfd, F_GETFL) | O_DIRECT), 0 );
+         circfifo_init(&fifo, buff, UT_SINK_FIFO);
+         ut_sink_stream(flags | CIRCFIFO_SINK_DIRECT, dfd, &fifo, len);
+         ut_sink_verify(fd, len);
+      }
+      close(dfd);
+   }
+
+   close(fd);
+   unlink(path);
+   free(buff);
+}
+
+typedef struct {
+   circfifo_t *fifo;
+   unsigned long len;
+   unsigned seed;
+   bool done;
+} ut_sink_producer_t;
+
+/* writes the stream into fifo in random chunks, waits while fifo is full */
+static void* ut_sink_producer(void *arg)
+{
+   ut_sink_producer_t *p = arg;
+   uint8_t chunk[3000];
+   unsigned long pos = 0;
+
+   while( pos < p->len )
+   {
+      unsigned cnt = min(1 + (unsigned long)rand_r(&p->seed) % sizeof(chunk), p->len - pos);
+      unsigned i;
+
+      for( i = 0; i < cnt; i++ )
+      {
+         chunk[i] = ut_stream_byte(pos + i);
+      }
+      i = 0;
+      while( i < cnt )
+      {
+         unsigned ret = circfifo_in(p->fifo, &chunk[i], cnt - i);
+         if( 0 == ret )
+         {
+            sched_yield();
+         }
+         i += ret;
+      }
+      pos += cnt;
+   }
+   __atomic_store_n(&p->done, true, __ATOMIC_RELEASE);
+
+   return NULL;
+}
+
+extern void ut_sink_producer_thread_test(void)
+{
+   uint8_t *buff = malloc(UT_SINK_FIFO);
+   ut_sink_producer_t producer;
+   circfifo_sink_t sink;
+   circfifo_t fifo;
+   pthread_t tid;
+   char path[64];
+   int fd = ut_sink_tmpfile(path, sizeof(path));
+   unsigned flags;
+   int ret;
+
+   UT_ASSERT( fd >= 0 );
+   for( flags = 0; flags <= CIRCFIFO_SINK_THREADS; flags += CIRCFIFO_SINK_THREADS )
+   {
+      UT_ASSERT_EQUAL( ftruncate(fd, 0), 0 );
+      UT_ASSERT_EQUAL( lseek(fd, 0, SEEK_SET), 0 );
+      circfifo_init(&fifo, buff, UT_SINK_FIFO);
+      producer.fifo = &fifo;
+      producer.len = UT_SINK_BYTES;
+      producer.seed = random();
+      producer.done = false;
+      UT_ASSERT_EQUAL( circfifo_sink_init(&sink, &fifo, fd, 16, UT_SINK_CHUNK, flags), 0 );
+      UT_ASSERT_EQUAL( pthread_create(&tid, NULL, ut_sink_producer, &producer), 0 );
+
+      /* sink is polled by this thread while the producer writes */
+      do
+      {
+         ret = circfifo_sink_poll(&sink);
+         if( 0 == ret )
+         {
+            sched_yield();
+         }
+      }while( (ret >= 0) && !__atomic_load_n(&producer.done, __ATOMIC_ACQUIRE) );
+      pthread_join(tid, NULL);
+      UT_ASSERT( ret >= 0 );
+      UT_ASSERT_EQUAL( circfifo_sink_flush(&sink), 0 );
+      UT_ASSERT_EQUAL( circfifo_count(&fifo), 0 );
+      circfifo_sink_destroy(&sink);
+      ut_sink_verify(fd, UT_SINK_BYTES);
+   }
+
+   close(fd);
+   unlink(path);
+   free(buff);
+}
+
+static const ut_test_info_t ut_sink_suite[] = {
+   { "io_uring", ut_sink_uring_test },
+   { "Threads", ut_sink_threads_test },
+   { "O_DIRECT", ut_sink_direct_test },
+   { "Producer thread", ut_sink_producer_thread_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_sink_suite, sizeof(ut_sink_suite) / sizeof(ut_sink_suite[0]));
+}
@@ -0,0 +1,72 @@
+#ifndef __CIRCFIFO_SINK_TEST_H__
+#define __CIRCFIFO_SINK_TEST_H__
+
+/**
+  * \brief Drain through io_uring
+  * \pre Empty temporary file, kernel with io_uring (otherwise thread pool)
+  * \post File removed
+  *
+  * \test
+  *   \li Random chunks written into fifo are stored in the file intact and in
+  *       order, data written while earlier writes are in flight included
+  *   \li Fifo is empty after flush and file has exactly the written length
+  *   \li Failed write is reported by poll and flush
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_sink_init
+  *   \li \ref circfifo_sink_poll
+  *   \li \ref circfifo_sink_flush
+  *   \li \ref circfifo_sink_destroy
+  */
+extern void ut_sink_uring_test(void);
+
+/**
+  * \brief Drain through thread pool fallback
+  * \pre Empty temporary file
+  * \post File removed
+  *
+  * \test
+  *   \li Same as \ref ut_sink_uring_test with CIRCFIFO_SINK_THREADS
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_sink_init
+  *   \li \ref circfifo_sink_poll
+  *   \li \ref circfifo_sink_flush
+  *   \li \ref circfifo_sink_destroy
+  */
+extern void ut_sink_threads_test(void);
+
+/**
+  * \brief Drain into file opened with O_DIRECT (skipped if not supported)
+  * \pre Empty temporary file, aligned fifo buffer
+  * \post File removed
+  *
+  * \test
+  *   \li Unaligned buffer, chunk, fifo size or read index is rejected
+  *   \li Only whole chunks are written before flush, unaligned tail by flush
+  *   \li File content is the same as written into fifo, for both backends
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_sink_init
+  *   \li \ref circfifo_sink_poll
+  *   \li \ref circfifo_sink_flush
+  */
+extern void ut_sink_direct_test(void);
+
+/**
+  * \brief Producer thread writes into fifo while the sink drains it
+  * \pre Empty temporary file
+  * \post File removed
+  *
+  * \test
+  *   \li Producer thread uses circfifo_in(), consumer thread polls the sink,
+  *       with io_uring and with thread pool
+  *   \li File has exactly the stream written by the producer
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_sink_poll
+  *   \li \ref circfifo_sink_flush
+  */
+extern void ut_sink_producer_thread_test(void);
+
+#endif /*__CIRCFIFO_SINK_TEST_H__*/
@@ -0,0 +1,48 @@
+#ifndef __TEST_COMMON_H__
+#define __TEST_COMMON_H__
+
+#include <stdio.h>
+
+/**
+  * Minimal replacement for CUnit asserts, failed assertion is reported but the
+  * test continues so we get the complete picture in single run
+  */
+static unsigned ut_asserts_failed = 0;
+
+#define UT_ASSERT(_expr) \
+   do { \
+      if( !(_expr) ) { \
+         __atomic_add_fetch(&ut_asserts_failed, 1, __ATOMIC_RELAXED); \
+         printf("\n%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #_expr); \
+      } \
+   } while(0)
+
+#define UT_ASSERT_EQUAL(_actual, _expected) UT_ASSERT((_actual) == (_expected))
+
+typedef struct {
+   const char *name;
+   void (*test)(void);
+} ut_test_info_t;
+
+/**
+  * Runs all tests from the suite
+  * \return Program exit code, 0 if all tests passed
+  */
+static inline int ut_run_suite(const ut_test_info_t *suite, unsigned cnt)
+{
+   unsigned i;
+
+   for( i = 0; i < cnt; i++ )
+   {
+      unsigned failed = ut_asserts_failed;
+
+      printf("  Test: %s ...", suite[i].name);
+      fflush(stdout);
+      suite[i].test();
+      printf("%s\n", (failed == ut_asserts_failed) ? " passed" : " FAILED");
+   }
+
+   return ut_asserts_failed ? 1 : 0;
+}
+
+#endif /*__TEST_COMMON_H__*/
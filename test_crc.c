@@ -0,0 +1,244 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "crc.h"
+#include "test_common.h"
+#include "test_crc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define UT_BUFF_SIZE 1024
+#define UT_ALIGN 64
+#define UT_JOBS 2000
+#define UT_BENCH_ROUNDS 20
+#define UT_BENCH_REPEATS 10
+
+/* check value of CRC-16/MODBUS for "123456789" */
+#define UT_CHECK_MODBUS 0x4B37
+
+static uint8_t ut_buff[UT_BUFF_SIZE + UT_ALIGN];
+
+static void ut_fill_random(void)
+{
+   unsigned i;
+
+   for( i = 0; i < sizeof(ut_buff); i++ )
+   {
+      ut_buff[i] = random();
+   }
+}
+
+/* compares given variant with bitwise reference for all lengths up to
+ * UT_BUFF_SIZE, random alignments and random initial values */
+static void ut_crc_compare(uint16_t (*crc_fn)(uint16_t, const void*, unsigned))
+{
+   unsigned size;
+
+   UT_ASSERT_EQUAL( crc_fn(0xFFFF, "123456789", 9), UT_CHECK_MODBUS );
+   for( size = 0; size <= UT_BUFF_SIZE; size++ )
+   {
+      unsigned offset = random() % UT_ALIGN;
+      uint16_t init = random();
+      uint16_t ref = crc16_update_bitwise(init, &ut_buff[offset], size);
+
+      UT_ASSERT_EQUAL( crc_fn(init, &ut_buff[offset], size), ref );
+   }
+}
+
+/* random messages, mostly short, some longer than the lane limit */
+static void ut_jobs_random(crc16_job_t *jobs, uint16_t *ref, unsigned cnt,
+                           unsigned min_size, unsigned max_size)
+{
+   unsigned i;
+
+   for( i = 0; i < cnt; i++ )
+   {
+      unsigned size = min_size + random() % (max_size - min_size + 1);
+      unsigned offset = random() % (sizeof(ut_buff) - size + 1);
+
+      jobs[i].buff = &ut_buff[offset];
+      jobs[i].size = size;
+      jobs[i].crc = random();
+      ref[i] = crc16_update_bitwise(jobs[i].crc, jobs[i].buff, size);
+   }
+}
+
+static void ut_crc_multi_compare(void (*multi_fn)(crc16_job_t*, unsigned))
+{
+   static crc16_job_t jobs[UT_JOBS];
+   static uint16_t ref[UT_JOBS];
+   unsigned cnt;
+   unsigned errors = 0;
+   unsigned i;
+
+   for( cnt = 0; cnt <= UT_JOBS; cnt = 2 * cnt + 1 )
+   {
+      ut_jobs_random(jobs, ref, cnt, 0, (0 == cnt % 3) ? UT_BUFF_SIZE : 160);
+      multi_fn(jobs, cnt);
+      for( i = 0; i < cnt; i++ )
+      {
+         errors += (jobs[i].crc != ref[i]);
+      }
+   }
+   UT_ASSERT_EQUAL( errors, 0 );
+}
+
+extern void ut_crc16_variants_test(void)
+{
+   ut_fill_random();
+
+   UT_ASSERT_EQUAL( crc16_update_bitwise(0xFFFF, "123456789", 9), UT_CHECK_MODBUS );
+   ut_crc_compare(crc16_update);
+#ifdef ARCH_DISPATCH
+   ut_crc_compare(crc16_update_slice8);
+#if defined(__x86_64__) || defined(__i386__)
+   if( arch_cpu_has(ARCH_CPU_SSE2 | ARCH_CPU_PCLMUL) )
+   {
+      ut_crc_compare(crc16_update_pclmul);
+   }
+#endif
+#endif
+}
+
+extern void ut_crc16_chunked_test(void)
+{
+   unsigned pos, chunk;
+   uint16_t crc;
+
+   ut_fill_random();
+
+   /* crc of the message computed in chunks is the same as in one go */
+   for( chunk = 1; chunk <= 200; chunk += 13 )
+   {
+      crc = 0xFFFF;
+      for( pos = 0; pos < UT_BUFF_SIZE; pos += chunk )
+      {
+         crc = crc16_update(crc, &ut_buff[pos], min(chunk, UT_BUFF_SIZE - pos));
+      }
+      UT_ASSERT_EQUAL( crc, crc16_update_bitwise(0xFFFF, ut_buff, UT_BUFF_SIZE) );
+   }
+}
+
+extern void ut_crc16_dispatch_test(void)
+{
+#ifdef ARCH_DISPATCH
+   unsigned features = arch_cpu_features;
+
+   ut_fill_random();
+
+   setenv("GENERICS_CPU", "generic", 1);
+   arch_init();
+   UT_ASSERT_EQUAL( arch_cpu_features, 0 );
+   UT_ASSERT( arch_dispatch.crc16_update == crc16_update_slice8 );
+   UT_ASSERT( arch_dispatch.crc16_update_multi == crc16_update_multi_scalar );
+   ut_crc_compare(crc16_update);
+   ut_crc_multi_compare(crc16_update_multi);
+
+   setenv("GENERICS_CPU", "sse2,pclmul,unknown", 1);
+   arch_init();
+   UT_ASSERT_EQUAL( arch_cpu_features & ~(ARCH_CPU_SSE2 | ARCH_CPU_PCLMUL), 0 );
+   ut_crc_compare(crc16_update);
+
+   setenv("GENERICS_CPU", "avx2", 1);
+   arch_init();
+   UT_ASSERT_EQUAL( arch_cpu_features & ~ARCH_CPU_AVX2, 0 );
+   ut_crc_multi_compare(crc16_update_multi);
+
+   unsetenv("GENERICS_CPU");
+   arch_init();
+   UT_ASSERT_EQUAL( arch_cpu_features, features );
+#endif
+}
+
+static double ut_elapsed(const struct timespec *t0, const struct timespec *t1)
+{
+   return (t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec) * 1e-9;
+}
+
+/* best time of batch or separate calls out of UT_BENCH_REPEATS */
+static double ut_crc_bench(crc16_job_t *jobs, unsigned cnt, bool multi)
+{
+   struct timespec t0, t1;
+   double best = 0;
+   unsigned repeat, round;
+   unsigned i;
+
+   for( repeat = 0; repeat < UT_BENCH_REPEATS; repeat++ )
+   {
+      clock_gettime(CLOCK_MONOTONIC, &t0);
+      for( round = 0; round < UT_BENCH_ROUNDS; round++ )
+      {
+         if( multi )
+         {
+            crc16_update_multi(jobs, cnt);
+            continue;
+         }
+         for( i = 0; i < cnt; i++ )
+         {
+            jobs[i].crc = crc16_update(jobs[i].crc, jobs[i].buff, jobs[i].size);
+         }
+      }
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      if( (0 == repeat) || (ut_elapsed(&t0, &t1) < best) )
+      {
+         best = ut_elapsed(&t0, &t1);
+      }
+   }
+   return best;
+}
+
+extern void ut_crc16_multi_test(void)
+{
+   static const unsigned sizes[][2] = { { 20, 63 }, { 64, 127 }, { 128, 200 } };
+   static crc16_job_t jobs[UT_JOBS];
+   static uint16_t ref[UT_JOBS];
+   unsigned long bytes;
+   unsigned s;
+   unsigned i;
+
+   ut_fill_random();
+
+   ut_crc_multi_compare(crc16_update_multi);
+#ifdef ARCH_DISPATCH
+   ut_crc_multi_compare(crc16_update_multi_scalar);
+#if defined(__x86_64__) || defined(__i386__)
+   if( arch_cpu_has(ARCH_CPU_AVX2) )
+   {
+      ut_crc_multi_compare(crc16_update_multi_avx2);
+   }
+   if( arch_cpu_has(ARCH_CPU_AVX512) )
+   {
+      ut_crc_multi_compare(crc16_update_multi_avx512);
+   }
+#endif
+#endif
+
+   /* messages of 20 - 200 bytes, batch against separate calls */
+   for( s = 0; s < table_size(sizes); s++ )
+   {
+      ut_jobs_random(jobs, ref, UT_JOBS, sizes[s][0], sizes[s][1]);
+      bytes = 0;
+      for( i = 0; i < UT_JOBS; i++ )
+      {
+         bytes += jobs[i].size;
+      }
+      printf("%u-%u: multi %.0f single %.0f MB/s%s", sizes[s][0], sizes[s][1],
+             bytes * UT_BENCH_ROUNDS / ut_crc_bench(jobs, UT_JOBS, true) / 1e6,
+             bytes * UT_BENCH_ROUNDS / ut_crc_bench(jobs, UT_JOBS, false) / 1e6,
+             (s + 1 < table_size(sizes)) ? ", " : " ");
+   }
+}
+
+static const ut_test_info_t ut_crc_suite[] = {
+   { "Variants", ut_crc16_variants_test },
+   { "Chunked", ut_crc16_chunked_test },
+   { "Dispatch", ut_crc16_dispatch_test },
+   { "Multi buffer", ut_crc16_multi_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_crc_suite, sizeof(ut_crc_suite) / sizeof(ut_crc_suite[0]));
+}
@@ -0,0 +1,70 @@
+#ifndef __CRC_TEST_H__
+#define __CRC_TEST_H__
+
+/**
+  * \brief All CRC16 variants give bit exact results
+  * \pre Buffer of random data
+  * \post None
+  *
+  * \test
+  *   \li Check value of CRC-16/MODBUS for "123456789"
+  *   \li Each variant supported by the CPU is compared with bitwise reference
+  *       for all lengths up to 1024 bytes, random alignment and initial value
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref crc16_update
+  *   \li \ref crc16_update_slice8
+  *   \li \ref crc16_update_pclmul
+  */
+extern void ut_crc16_variants_test(void);
+
+/**
+  * \brief CRC16 computed in chunks
+  * \pre Buffer of random data
+  * \post None
+  *
+  * \test
+  *   \li CRC updated with consecutive chunks of different sizes is equal to
+  *       CRC of whole buffer
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref crc16_update
+  */
+extern void ut_crc16_chunked_test(void);
+
+/**
+  * \brief Runtime CPU dispatch and its GENERICS_CPU override
+  * \pre Dispatch table initialized at startup
+  * \post Dispatch table initialized for all detected features
+  *
+  * \test
+  *   \li "generic" disables all features and selects portable code
+  *   \li Unknown names are ignored, features are limited to listed ones
+  *   \li Result of crc16_update and crc16_update_multi does not depend on
+  *       selected implementation
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref arch_init
+  *   \li \ref crc16_update
+  */
+extern void ut_crc16_dispatch_test(void);
+
+/**
+  * \brief Multi buffer CRC of many messages
+  * \pre Random buffer
+  * \post None
+  *
+  * \test
+  *   \li Each variant supported by the CPU gives the same results as bitwise
+  *       reference for batches of different sizes, random lengths, alignments
+  *       and initial values, including messages shorter than one block and
+  *       longer than the lane limit
+  *   \li Best throughput for messages of 20 - 63, 64 - 127 and 128 - 200 bytes
+  *       is reported for the batch and for separate crc16_update calls
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref crc16_update_multi
+  */
+extern void ut_crc16_multi_test(void);
+
+#endif /*__CRC_TEST_H__*/
@@ -0,0 +1,184 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "fastdiv.h"
+#include "test_common.h"
+#include "test_fastdiv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define UT_RANDOM_DIVISORS 500
+#define UT_RANDOM_DIVIDENDS 2000
+#define UT_BENCH_OPS 10000000
+
+static uint64_t ut_random64(void)
+{
+   uint64_t r = ((uint64_t)random() << 62) ^ ((uint64_t)random() << 31) ^ random();
+
+   /* random bit length so small values are also frequent */
+   return r >> (random() % 64);
+}
+
+/* checks all four operations, returns number of mismatches */
+#define UT_FASTDIV_CHECK(_bits, _fd, _n) ({ \
+   uint##_bits##_t __n = (_n); \
+   uint##_bits##_t __d = (_fd)->d; \
+   uint##_bits##_t __q = __n / __d; \
+   uint##_bits##_t __r = __n % __d; \
+   (fastdiv_u##_bits##_div(_fd, __n) != __q) + \
+   (fastdiv_u##_bits##_mod(_fd, __n) != __r) + \
+   (fastdiv_u##_bits##_ceil_div(_fd, __n) != (uint##_bits##_t)(__q + (0 != __r))) + \
+   (fastdiv_u##_bits##_divisible(_fd, __n) != (0 == __r)); })
+
+/* checks dividends around multiples of divisor and around maximum */
+#define UT_FASTDIV_EDGES(_bits, _fd) ({ \
+   uint##_bits##_t __max = (uint##_bits##_t)~(uint##_bits##_t)0; \
+   unsigned long __err = 0; \
+   unsigned __k; \
+   for( __k = 0; __k < 4; __k++ ) \
+   { \
+      uint##_bits##_t __m = (_fd)->d * __k; \
+      __err += UT_FASTDIV_CHECK(_bits, _fd, __m); \
+      __err += UT_FASTDIV_CHECK(_bits, _fd, __m - 1); \
+      __err += UT_FASTDIV_CHECK(_bits, _fd, __m + 1); \
+      __err += UT_FASTDIV_CHECK(_bits, _fd, __max - __k); \
+      __err += UT_FASTDIV_CHECK(_bits, _fd, (__max / (_fd)->d - __k) * (_fd)->d); \
+      __err += UT_FASTDIV_CHECK(_bits, _fd, (__max / (_fd)->d - __k) * (_fd)->d - 1); \
+   } \
+   __err; })
+
+extern void ut_fastdiv_small_test(void)
+{
+   unsigned long errors = 0;
+   fastdiv_u8_t fd8;
+   fastdiv_u16_t fd16;
+   unsigned d;
+   unsigned n;
+   unsigned i;
+
+   for( d = 1; d <= 0xFF; d++ )
+   {
+      fastdiv_u8_init(&fd8, d);
+      for( n = 0; n <= 0xFF; n++ )
+      {
+         errors += UT_FASTDIV_CHECK(8, &fd8, n);
+      }
+   }
+   UT_ASSERT_EQUAL( errors, 0 );
+
+   for( i = 0; i < 1024 + 16 * 3 + UT_RANDOM_DIVISORS; i++ )
+   {
+      if( i < 1024 )
+      {
+         d = i + 1;
+      }
+      else if( i < 1024 + 16 * 3 )
+      {
+         d = (1 << ((i - 1024) / 3)) + (i - 1024) % 3 - 1;
+      }
+      else
+      {
+         d = 1 + random() % 0xFFFF;
+      }
+      if( (0 == d) || (d > 0xFFFF) )
+      {
+         continue;
+      }
+      fastdiv_u16_init(&fd16, d);
+      for( n = 0; n <= 0xFFFF; n++ )
+      {
+         errors += UT_FASTDIV_CHECK(16, &fd16, n);
+      }
+   }
+   for( d = 1; d <= 0xFFFF; d++ )
+   {
+      fastdiv_u16_init(&fd16, d);
+      errors += UT_FASTDIV_EDGES(16, &fd16);
+   }
+   UT_ASSERT_EQUAL( errors, 0 );
+}
+
+extern void ut_fastdiv_wide_test(void)
+{
+   static uint32_t nums[UT_BENCH_OPS / 1000];
+   unsigned long errors = 0;
+   fastdiv_u32_t fd32;
+   fastdiv_u64_t fd64;
+   struct timespec t0, t1, t2;
+   uint32_t sum[2] = { 0, 0 };
+   volatile uint32_t vd;
+   unsigned i;
+   unsigned j;
+
+   for( i = 0; i < 64 * 3 + UT_RANDOM_DIVISORS; i++ )
+   {
+      uint64_t d64;
+
+      if( i < 64 * 3 )
+      {
+         /* around powers of 2 */
+         d64 = ((uint64_t)1 << (i / 3)) + i % 3 - 1;
+      }
+      else
+      {
+         d64 = ut_random64();
+      }
+      if( 0 == d64 )
+      {
+         d64 = ~(uint64_t)0 - random() % 16;
+      }
+
+      fastdiv_u64_init(&fd64, d64);
+      errors += UT_FASTDIV_EDGES(64, &fd64);
+      for( j = 0; j < UT_RANDOM_DIVIDENDS; j++ )
+      {
+         errors += UT_FASTDIV_CHECK(64, &fd64, ut_random64());
+      }
+
+      if( 0 != (uint32_t)d64 )
+      {
+         fastdiv_u32_init(&fd32, d64);
+         errors += UT_FASTDIV_EDGES(32, &fd32);
+         for( j = 0; j < UT_RANDOM_DIVIDENDS; j++ )
+         {
+            errors += UT_FASTDIV_CHECK(32, &fd32, ut_random64());
+         }
+      }
+   }
+   UT_ASSERT_EQUAL( errors, 0 );
+
+   /* divisor hidden from compiler */
+   vd = 1 + random() % 1000;
+   fastdiv_u32_init(&fd32, vd);
+   for( i = 0; i < table_size(nums); i++ )
+   {
+      nums[i] = random();
+   }
+   clock_gettime(CLOCK_MONOTONIC, &t0);
+   for( i = 0; i < UT_BENCH_OPS; i++ )
+   {
+      sum[0] += fastdiv_u32_div(&fd32, nums[i % table_size(nums)] + i);
+   }
+   clock_gettime(CLOCK_MONOTONIC, &t1);
+   for( i = 0; i < UT_BENCH_OPS; i++ )
+   {
+      sum[1] += (nums[i % table_size(nums)] + i) / vd;
+   }
+   clock_gettime(CLOCK_MONOTONIC, &t2);
+   UT_ASSERT_EQUAL( sum[0], sum[1] );
+   printf("u32 ns/op fastdiv %.2f div %.2f ",
+          ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / UT_BENCH_OPS,
+          ((t2.tv_sec - t1.tv_sec) * 1e9 + (t2.tv_nsec - t1.tv_nsec)) / UT_BENCH_OPS);
+}
+
+static const ut_test_info_t ut_fastdiv_suite[] = {
+   { "Small", ut_fastdiv_small_test },
+   { "Wide", ut_fastdiv_wide_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_fastdiv_suite, sizeof(ut_fastdiv_suite) / sizeof(ut_fastdiv_suite[0]));
+}
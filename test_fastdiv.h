@@ -0,0 +1,46 @@
+#ifndef __FASTDIV_TEST_H__
+#define __FASTDIV_TEST_H__
+
+/**
+  * \brief 8 and 16 bit division compared with / and %
+  * \pre None
+  * \post None
+  *
+  * \test
+  *   \li All 8 bit dividends with all divisors
+  *   \li All 16 bit dividends with divisors up to 1024, around powers of 2 and
+  *       random ones, all divisors with dividends around the limits
+  *   \li div, mod, ceil_div and divisible
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref fastdiv_u8_init
+  *   \li \ref fastdiv_u8_div
+  *   \li \ref fastdiv_u8_mod
+  *   \li \ref fastdiv_u8_ceil_div
+  *   \li \ref fastdiv_u8_divisible
+  *   \li \ref fastdiv_u16_init
+  *   \li \ref fastdiv_u16_div
+  */
+extern void ut_fastdiv_small_test(void);
+
+/**
+  * \brief 32 and 64 bit division compared with / and %
+  * \pre None
+  * \post None
+  *
+  * \test
+  *   \li Divisors of every bit length, around powers of 2, close to the
+  *       type maximum and random ones
+  *   \li Dividends 0, 1, around multiples of divisor, around the type maximum
+  *       and random ones
+  *   \li Speed of fastdiv and hardware division is reported
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref fastdiv_u32_init
+  *   \li \ref fastdiv_u32_div
+  *   \li \ref fastdiv_u64_init
+  *   \li \ref fastdiv_u64_div
+  */
+extern void ut_fastdiv_wide_test(void);
+
+#endif /*__FASTDIV_TEST_H__*/
@@ -0,0 +1,318 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "circfifo.h"
+#include "framing.h"
+#include "test_common.h"
+#include "test_framing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define UT_FRAME_MAX 700
+#define UT_FRAMES 3000
+
+typedef struct {
+   const uint8_t *raw;
+   unsigned raw_len;
+   const uint8_t *enc;
+   unsigned enc_len;
+} ut_vector_t;
+
+/* both codecs behind one interface, so round trip test is shared */
+typedef struct {
+   bool cobs;
+   cobs_enc_t cobs_enc;
+   cobs_dec_t cobs_dec;
+   slip_enc_t slip_enc;
+   slip_dec_t slip_dec;
+} ut_codec_t;
+
+static void ut_codec_init(ut_codec_t *c, bool cobs, bool use_crc)
+{
+   c->cobs = cobs;
+   cobs_enc_init(&c->cobs_enc, use_crc);
+   cobs_dec_init(&c->cobs_dec, use_crc);
+   slip_enc_init(&c->slip_enc, use_crc);
+   slip_dec_init(&c->slip_dec, use_crc);
+}
+
+static unsigned ut_encode(ut_codec_t *c, circfifo_t *out, const void *buff, unsigned size)
+{
+   return c->cobs ? cobs_encode(&c->cobs_enc, out, buff, size) : slip_encode(&c->slip_enc, out, buff, size);
+}
+
+static unsigned ut_encode_fifo(ut_codec_t *c, circfifo_t *out, circfifo_t *in)
+{
+   return c->cobs ? cobs_encode_fifo(&c->cobs_enc, out, in) : slip_encode_fifo(&c->slip_enc, out, in);
+}
+
+static bool ut_encode_end(ut_codec_t *c, circfifo_t *out)
+{
+   return c->cobs ? cobs_encode_end(&c->cobs_enc, out) : slip_encode_end(&c->slip_enc, out);
+}
+
+static int ut_decode(ut_codec_t *c, circfifo_t *out, circfifo_t *in)
+{
+   return c->cobs ? cobs_decode(&c->cobs_dec, out, in) : slip_decode(&c->slip_dec, out, in);
+}
+
+/* encodes one frame at once and compares with expected encoding */
+static void ut_check_vector(ut_codec_t *c, const ut_vector_t *v)
+{
+   uint8_t fifo_buff[1024];
+   uint8_t enc[1024];
+   circfifo_t fifo;
+   unsigned len;
+
+   circfifo_init(&fifo, fifo_buff, sizeof(fifo_buff));
+   UT_ASSERT_EQUAL( ut_encode(c, &fifo, v->raw, v->raw_len), v->raw_len );
+   UT_ASSERT( ut_encode_end(c, &fifo) );
+   len = circfifo_count(&fifo);
+   UT_ASSERT_EQUAL( len, v->enc_len );
+   if( len == v->enc_len )
+   {
+      UT_ASSERT_EQUAL( circfifo_out(&fifo, enc, len), len );
+      UT_ASSERT( 0 == memcmp(enc, v->enc, len) );
+   }
+
+   /* and back */
+   circfifo_init(&fifo, fifo_buff, sizeof(fifo_buff));
+   UT_ASSERT_EQUAL( circfifo_in(&fifo, v->enc, v->enc_len), v->enc_len );
+   {
+      uint8_t out_buff[1024];
+      circfifo_t out;
+
+      circfifo_init(&out, out_buff, sizeof(out_buff));
+      UT_ASSERT_EQUAL( ut_decode(c, &out, &fifo), FRAMING_FRAME );
+      UT_ASSERT_EQUAL( circfifo_count(&out), v->raw_len );
+      if( v->raw_len > 0 )
+      {
+         UT_ASSERT_EQUAL( circfifo_out(&out, enc, v->raw_len), v->raw_len );
+         UT_ASSERT( 0 == memcmp(enc, v->raw, v->raw_len) );
+      }
+   }
+}
+
+extern void ut_framing_vector_test(void)
+{
+   static const uint8_t r1[] = { 0x00 };
+   static const uint8_t e1[] = { 0x01, 0x01, 0x00 };
+   static const uint8_t r2[] = { 0x00, 0x00 };
+   static const uint8_t e2[] = { 0x01, 0x01, 0x01, 0x00 };
+   static const uint8_t r3[] = { 0x11, 0x22, 0x00, 0x33 };
+   static const uint8_t e3[] = { 0x03, 0x11, 0x22, 0x02, 0x33, 0x00 };
+   static const uint8_t r4[] = { 0x11, 0x00, 0x00, 0x00 };
+   static const uint8_t e4[] = { 0x02, 0x11, 0x01, 0x01, 0x01, 0x00 };
+   static const uint8_t e5[] = { 0x01, 0x00 };
+   static const uint8_t r6[] = { 0xC0, 0xDB, 0x11 };
+   static const uint8_t e6[] = { 0xDB, 0xDC, 0xDB, 0xDD, 0x11, 0xC0 };
+   uint8_t r7[255], e7[257], e8[258];
+   ut_vector_t v;
+   ut_codec_t c;
+   unsigned i;
+
+   ut_codec_init(&c, true, false);
+   ut_check_vector(&c, &(ut_vector_t){ r1, sizeof(r1), e1, sizeof(e1) });
+   ut_check_vector(&c, &(ut_vector_t){ r2, sizeof(r2), e2, sizeof(e2) });
+   ut_check_vector(&c, &(ut_vector_t){ r3, sizeof(r3), e3, sizeof(e3) });
+   ut_check_vector(&c, &(ut_vector_t){ r4, sizeof(r4), e4, sizeof(e4) });
+   ut_check_vector(&c, &(ut_vector_t){ NULL, 0, e5, sizeof(e5) });
+
+   /* 254 non zero bytes fill the block, no empty block follows */
+   for( i = 0; i < 255; i++ )
+   {
+      r7[i] = i + 1;
+   }
+   e7[0] = 0xFF;
+   memcpy(&e7[1], r7, 254);
+   e7[255] = 0x00;
+   v = (ut_vector_t){ r7, 254, e7, 256 };
+   ut_check_vector(&c, &v);
+   /* 255 non zero bytes need second block */
+   e8[0] = 0xFF;
+   memcpy(&e8[1], r7, 254);
+   e8[255] = 0x02;
+   e8[256] = 0xFF;
+   e8[257] = 0x00;
+   v = (ut_vector_t){ r7, 255, e8, 258 };
+   ut_check_vector(&c, &v);
+
+   ut_codec_init(&c, false, false);
+   ut_check_vector(&c, &(ut_vector_t){ r6, sizeof(r6), e6, sizeof(e6) });
+}
+
+static uint8_t ut_random_byte(void)
+{
+   /* bytes which need encoding are frequent */
+   static const uint8_t special[] = { 0x00, SLIP_END, SLIP_ESC, SLIP_ESC_END, 0xFF };
+   return (0 == random() % 4) ? special[random() % sizeof(special)] : random();
+}
+
+/* streams random frames through encoder, fifo of encoded data and decoder,
+ * each stage works on random sized pieces */
+static void ut_framing_roundtrip(bool cobs, bool use_crc)
+{
+   static uint8_t frames[UT_FRAMES][UT_FRAME_MAX];
+   static unsigned frame_len[UT_FRAMES];
+   uint8_t in_buff[97];
+   uint8_t enc_buff[COBS_FIFO_MIN + 33];
+   uint8_t out_buff[UT_FRAME_MAX + 3];
+   uint8_t check[UT_FRAME_MAX];
+   circfifo_t in, enc, out;
+   ut_codec_t c;
+   unsigned tx = 0, tx_pos = 0, rx = 0;
+   unsigned i, len;
+   unsigned long loops = 0;
+   int ret;
+
+   ut_codec_init(&c, cobs, use_crc);
+   circfifo_init(&in, in_buff, sizeof(in_buff));
+   circfifo_init(&enc, enc_buff, sizeof(enc_buff));
+   circfifo_init(&out, out_buff, sizeof(out_buff));
+   for( i = 0; i < UT_FRAMES; i++ )
+   {
+      frame_len[i] = (0 == random() % 8) ? (unsigned)random() % UT_FRAME_MAX : (unsigned)random() % 40;
+      /* empty SLIP frame is just SLIP_END, decoder ignores it */
+      frame_len[i] += (!cobs && (0 == frame_len[i])) ? 1 : 0;
+      for( len = 0; len < frame_len[i]; len++ )
+      {
+         frames[i][len] = ut_random_byte();
+      }
+   }
+
+   while( (rx < UT_FRAMES) && (loops++ < 100 * UT_FRAMES) )
+   {
+      if( tx < UT_FRAMES )
+      {
+         /* even frames go through the input fifo, odd are encoded directly */
+         len = min(frame_len[tx] - tx_pos, (unsigned)random() % 64);
+         if( tx & 1 )
+         {
+            tx_pos += ut_encode(&c, &enc, &frames[tx][tx_pos], len);
+         }
+         else
+         {
+            if( len > 0 )
+            {
+               tx_pos += circfifo_in(&in, &frames[tx][tx_pos], len);
+            }
+            (void)ut_encode_fifo(&c, &enc, &in);
+         }
+         if( (tx_pos == frame_len[tx]) && (0 == circfifo_count(&in)) && ut_encode_end(&c, &enc) )
+         {
+            tx++;
+            tx_pos = 0;
+         }
+      }
+
+      if( random() % 2 )
+      {
+         ret = ut_decode(&c, &out, &enc);
+         UT_ASSERT( FRAMING_ERROR != ret );
+         if( FRAMING_FRAME == ret )
+         {
+            len = circfifo_count(&out);
+            UT_ASSERT_EQUAL( len, frame_len[rx] );
+            if( len > 0 )
+            {
+               UT_ASSERT_EQUAL( circfifo_out(&out, check, len), len );
+               UT_ASSERT( 0 == memcmp(check, frames[rx], len) );
+            }
+            rx++;
+         }
+      }
+   }
+   UT_ASSERT_EQUAL( rx, UT_FRAMES );
+}
+
+extern void ut_framing_roundtrip_test(void)
+{
+   ut_framing_roundtrip(true, false);
+   ut_framing_roundtrip(true, true);
+   ut_framing_roundtrip(false, false);
+   ut_framing_roundtrip(false, true);
+}
+
+/* encodes frame and returns it in linear buffer */
+static unsigned ut_encode_frame(ut_codec_t *c, const uint8_t *frame, unsigned len, uint8_t *encoded)
+{
+   uint8_t fifo_buff[1024];
+   circfifo_t fifo;
+
+   circfifo_init(&fifo, fifo_buff, sizeof(fifo_buff));
+   UT_ASSERT_EQUAL( ut_encode(c, &fifo, frame, len), len );
+   UT_ASSERT( ut_encode_end(c, &fifo) );
+   return circfifo_out(&fifo, encoded, sizeof(fifo_buff));
+}
+
+extern void ut_framing_error_test(void)
+{
+   uint8_t frame[300];
+   uint8_t encoded[1024];
+   uint8_t enc_buff[1024];
+   uint8_t out_buff[128];
+   circfifo_t enc, out;
+   ut_codec_t c;
+   unsigned len, i, pos;
+   int cobs;
+
+   for( i = 0; i < sizeof(frame); i++ )
+   {
+      /* no bytes which need encoding, so encoded data starts at fixed offset */
+      frame[i] = 1 + random() % 0xBF;
+   }
+
+   for( cobs = 0; cobs < 2; cobs++ )
+   {
+      ut_codec_init(&c, cobs, true);
+      circfifo_init(&enc, enc_buff, sizeof(enc_buff));
+      circfifo_init(&out, out_buff, sizeof(out_buff));
+
+      /* every single byte corruption is detected by CRC */
+      for( pos = 0; pos < 20; pos++ )
+      {
+         len = ut_encode_frame(&c, frame, 20, encoded);
+         /* corrupted byte stays in the range of frame bytes, so it is not
+            taken for a delimiter which would split the frame */
+         encoded[cobs + pos] = 1 + (encoded[cobs + pos] + random() % 0xBE) % 0xBF;
+         UT_ASSERT_EQUAL( circfifo_in(&enc, encoded, len), len );
+         UT_ASSERT_EQUAL( ut_decode(&c, &out, &enc), FRAMING_ERROR );
+         UT_ASSERT_EQUAL( circfifo_count(&out), 0 );
+      }
+
+      /* frame longer than the output fifo is dropped, the next one passes */
+      len = ut_encode_frame(&c, frame, 200, encoded);
+      len += ut_encode_frame(&c, frame, 100, &encoded[len]);
+      UT_ASSERT_EQUAL( circfifo_in(&enc, encoded, len), len );
+      UT_ASSERT_EQUAL( ut_decode(&c, &out, &enc), FRAMING_ERROR );
+      UT_ASSERT_EQUAL( ut_decode(&c, &out, &enc), FRAMING_FRAME );
+      UT_ASSERT_EQUAL( circfifo_count(&out), 100 );
+      UT_ASSERT_EQUAL( circfifo_out(&out, encoded, 100), 100 );
+      UT_ASSERT( 0 == memcmp(encoded, frame, 100) );
+
+      /* frame truncated by the delimiter */
+      len = ut_encode_frame(&c, frame, 50, encoded);
+      encoded[10] = cobs ? 0x00 : SLIP_END;
+      UT_ASSERT_EQUAL( circfifo_in(&enc, encoded, 11), 11 );
+      UT_ASSERT_EQUAL( ut_decode(&c, &out, &enc), FRAMING_ERROR );
+      UT_ASSERT_EQUAL( ut_decode(&c, &out, &enc), FRAMING_MORE );
+      UT_ASSERT_EQUAL( circfifo_count(&out), 0 );
+   }
+}
+
+static const ut_test_info_t ut_framing_suite[] = {
+   { "Vectors", ut_framing_vector_test },
+   { "Round trip", ut_framing_roundtrip_test },
+   { "Errors", ut_framing_error_test },
+};
+
+int main(void)
+{
+   long seed = time(NULL);
+
+   srandom(seed);
+   printf("Random seed = %li\n", seed);
+
+   return ut_run_suite(ut_framing_suite, sizeof(ut_framing_suite) / sizeof(ut_framing_suite[0]));
+}
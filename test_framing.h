@@ -0,0 +1,64 @@
+#ifndef __FRAMING_TEST_H__
+#define __FRAMING_TEST_H__
+
+/**
+  * \brief Known encodings
+  * \pre None
+  * \post None
+  *
+  * \test
+  *   \li COBS encoding of zeros, full 254 byte block and 255 bytes
+  *   \li COBS encoding of empty frame
+  *   \li SLIP escaping of SLIP_END and SLIP_ESC
+  *   \li Each encoding decodes back to the original frame
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref cobs_encode
+  *   \li \ref cobs_encode_end
+  *   \li \ref cobs_decode
+  *   \li \ref slip_encode
+  *   \li \ref slip_encode_end
+  *   \li \ref slip_decode
+  */
+extern void ut_framing_vector_test(void);
+
+/**
+  * \brief Random frames streamed through encoder and decoder
+  * \pre Small input, encoded and output fifos
+  * \post All fifos empty
+  *
+  * \test
+  *   \li COBS and SLIP, with and without CRC
+  *   \li Encoder is fed from linear buffer and from input fifo in random
+  *       pieces, decoder is called at random, all stages resume on partial
+  *       data and on full output fifo
+  *   \li Each frame is received intact and in order
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref cobs_encode
+  *   \li \ref cobs_encode_fifo
+  *   \li \ref cobs_decode
+  *   \li \ref slip_encode
+  *   \li \ref slip_encode_fifo
+  *   \li \ref slip_decode
+  */
+extern void ut_framing_roundtrip_test(void);
+
+/**
+  * \brief Dropping of invalid frames
+  * \pre Empty fifos
+  * \post Empty fifos
+  *
+  * \test
+  *   \li Single byte corruption is detected by CRC
+  *   \li Frame longer than output fifo is dropped and the next one is received
+  *   \li Truncated frame is dropped
+  *   \li Nothing of dropped frame is committed into the output fifo
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref cobs_decode
+  *   \li \ref slip_decode
+  */
+extern void ut_framing_error_test(void);
+
+#endif /*__FRAMING_TEST_H__*/
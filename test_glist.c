@@ -0,0 +1,413 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "glist.h"
+#include "ebr.h"
+#include "test_common.h"
+#include "test_glist.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define UT_ITEMS 1000
+#define UT_KEY_RANGE 50
+#define UT_ROUNDS 100
+#define UT_RCU_KEYS 32
+#define UT_RCU_NODES 256
+#define UT_RCU_READERS 3
+#define UT_RCU_OPS 20000
+
+typedef struct {
+   list_t list;
+   int key;
+   unsigned seq;
+} ut_item_t;
+
+static ut_item_t ut_items[UT_ITEMS];
+static listprio_t ut_prio[2][UT_ITEMS];
+
+static int ut_item_cmp(const list_t *a, const list_t *b)
+{
+   int ka = list_entry(a, ut_item_t, list)->key;
+   int kb = list_entry(b, ut_item_t, list)->key;
+
+   return (ka > kb) - (ka < kb);
+}
+
+/* checks that list holds items of given seq numbers in both directions */
+static void ut_check_list(const list_t *l, const unsigned *seq, unsigned cnt)
+{
+   const list_t *itr;
+   unsigned i = 0;
+
+   for( itr = list_itr_begin(l); !list_itr_end(l, itr) && (i < cnt); itr = itr->next, i++ )
+   {
+      UT_ASSERT_EQUAL( itr->next->prev, itr );
+      UT_ASSERT_EQUAL( list_entry(itr, ut_item_t, list)->seq, seq[i] );
+   }
+   UT_ASSERT_EQUAL( i, cnt );
+   UT_ASSERT( list_itr_end(l, itr) );
+   for( itr = l->prev; !list_itr_end(l, itr) && (i > 0); itr = itr->prev )
+   {
+      UT_ASSERT_EQUAL( list_entry(itr, ut_item_t, list)->seq, seq[--i] );
+   }
+   UT_ASSERT_EQUAL( i, 0 );
+   UT_ASSERT( list_itr_end(l, itr) );
+}
+
+/* fills list with items [first, first + cnt) */
+static void ut_fill(list_t *l, unsigned first, unsigned cnt)
+{
+   unsigned i;
+
+   list_init(l);
+   for( i = first; i < first + cnt; i++ )
+   {
+      ut_items[i].seq = i;
+      list_append(l, &ut_items[i].list);
+   }
+}
+
+extern void ut_list_splice_test(void)
+{
+   unsigned seq[20];
+   list_t a, b, c;
+   list_t *itr;
+   unsigned cut;
+   unsigned i;
+
+   for( i = 0; i < 20; i++ )
+   {
+      seq[i] = i;
+   }
+
+   ut_fill(&a, 0, 5);
+   ut_fill(&b, 5, 5);
+   list_splice_append(&a, &b);
+   ut_check_list(&a, seq, 10);
+   UT_ASSERT( list_is_empty(&b) );
+   list_splice_append(&a, &b);
+   list_splice_prepend(&a, &b);
+   ut_check_list(&a, seq, 10);
+   list_splice_append(&b, &a);
+   ut_check_list(&b, seq, 10);
+   UT_ASSERT( list_is_empty(&a) );
+
+   ut_fill(&a, 10, 10);
+   list_splice_prepend(&a, &b);
+   ut_check_list(&a, seq, 20);
+
+   for( cut = 0; cut <= 20; cut++ )
+   {
+      ut_fill(&a, 0, 20);
+      itr = &a;
+      for( i = 0; i < cut; i++ )
+      {
+         itr = itr->next;
+      }
+      list_cut(&a, itr, &c);
+      ut_check_list(&c, seq, cut);
+      ut_check_list(&a, &seq[cut], 20 - cut);
+      list_splice_prepend(&a, &c);
+      ut_check_list(&a, seq, 20);
+   }
+}
+
+extern void ut_list_sort_test(void)
+{
+   unsigned seq[UT_ITEMS];
+   unsigned round;
+   list_t l;
+   listprio_t h[2];
+   list_t *itr;
+   unsigned cnt;
+   unsigned i;
+
+   for( round = 0; round < UT_ROUNDS; round++ )
+   {
+      const ut_item_t *prev = NULL;
+
+      cnt = (0 == round % 10) ? (round / 10) : (unsigned)(random() % UT_ITEMS);
+      ut_fill(&l, 0, cnt);
+      for( i = 0; i < cnt; i++ )
+      {
+         ut_items[i].key = random() % UT_KEY_RANGE;
+      }
+      list_sort(&l, ut_item_cmp);
+
+      i = 0;
+      list_for_each(itr, &l)
+      {
+         const ut_item_t *item = list_entry(itr, ut_item_t, list);
+
+         UT_ASSERT_EQUAL( itr->next->prev, itr );
+         if( NULL != prev )
+         {
+            UT_ASSERT( (prev->key < item->key) ||
+                       ((prev->key == item->key) && (prev->seq < item->seq)) );
+         }
+         prev = item;
+         seq[i++] = item->seq;
+      }
+      UT_ASSERT_EQUAL( i, cnt );
+      ut_check_list(&l, seq, cnt);
+
+      /* the same prio list built by inserts and by single sort */
+      list_init(&h[0].list);
+      list_init(&h[1].list);
+      for( i = 0; i < cnt; i++ )
+      {
+         ut_prio[0][i].prio = ut_prio[1][i].prio = random() % UT_KEY_RANGE;
+         listprio_append(&h[0], &ut_prio[0][i]);
+         list_append(&h[1].list, &ut_prio[1][i].list);
+      }
+      listprio_sort(&h[1]);
+      for( i = 0; i < cnt; i++ )
+      {
+         listprio_t *e0 = listprio_detachfirst(&h[0]);
+         listprio_t *e1 = listprio_detachfirst(&h[1]);
+
+         UT_ASSERT( (NULL != e0) && (NULL != e1) );
+         UT_ASSERT_EQUAL( e0 - ut_prio[0], e1 - ut_prio[1] );
+      }
+      UT_ASSERT( list_is_empty(&h[0].list) && list_is_empty(&h[1].list) );
+   }
+}
+
+extern void ut_list_rcu_test(void)
+{
+   unsigned seq[] = { 1, 0, 2, 3, 4 };
+   unsigned seq2[] = { 2, 4 };
+   unsigned seq3[] = { 1, 5, 4 };
+   ut_item_t *item;
+   list_t *itr;
+   list_t l;
+   unsigned i;
+
+   for( i = 0; i < 6; i++ )
+   {
+      ut_items[i].seq = i;
+   }
+   list_init(&l);
+   UT_ASSERT( list_rcu_is_empty(&l) );
+   list_rcu_append(&l, &ut_items[2].list);
+   list_rcu_prepend(&l, &ut_items[0].list);
+   list_rcu_put_after(&ut_items[2].list, &ut_items[4].list);
+   list_rcu_put_before(&ut_items[4].list, &ut_items[3].list);
+   list_rcu_put_before(&ut_items[0].list, &ut_items[1].list);
+   UT_ASSERT( !list_rcu_is_empty(&l) );
+   ut_check_list(&l, seq, 5);
+
+   /* unlinked element still leads the reader back to the list */
+   list_rcu_unlink(&ut_items[1].list);
+   UT_ASSERT( ut_items[1].list.next == &ut_items[0].list );
+   list_rcu_unlink(&ut_items[0].list);
+   list_rcu_unlink(&ut_items[3].list);
+   UT_ASSERT( ut_items[3].list.next == &ut_items[4].list );
+   ut_check_list(&l, seq2, 2);
+
+   list_rcu_replace(&ut_items[2].list, &ut_items[5].list);
+   list_rcu_put_after(&l, &ut_items[1].list);
+   ut_check_list(&l, seq3, 3);
+   i = 0;
+   list_for_each_rcu(itr, &l)
+   {
+      UT_ASSERT( (i < 3) && (list_entry(itr, ut_item_t, list)->seq == seq3[i]) );
+      i++;
+   }
+   UT_ASSERT_EQUAL( i, 3 );
+   i = 0;
+   list_for_each_entry_rcu(item, &l, list)
+   {
+      i += item->seq;
+   }
+   UT_ASSERT_EQUAL( i, 10 );
+}
+
+typedef struct {
+   list_t list;
+   ebr_node_t ebr;
+   unsigned key;
+   bool alive;
+} ut_rcu_item_t;
+
+typedef struct {
+   list_t head;
+   ebr_t ebr;
+   bool stop;
+   /* pool of free items, used only by the writer and its reclaim callback */
+   ut_rcu_item_t items[UT_RCU_NODES];
+   ut_rcu_item_t *free[UT_RCU_NODES];
+   unsigned free_cnt;
+} ut_rcu_shared_t;
+
+typedef struct {
+   ut_rcu_shared_t *shared;
+   ebr_thread_t ebr;
+   unsigned long scans;
+} ut_rcu_reader_t;
+
+static ut_rcu_shared_t ut_rcu;
+
+static void ut_rcu_reclaim(ebr_node_t *node)
+{
+   ut_rcu_item_t *item = container_of(node, ut_rcu_item_t, ebr);
+
+   __atomic_store_n(&item->alive, false, __ATOMIC_RELAXED);
+   item->key = ~0u;
+   ut_rcu.free[ut_rcu.free_cnt++] = item;
+}
+
+static ut_rcu_item_t* ut_rcu_alloc(ebr_thread_t *self, unsigned key)
+{
+   ut_rcu_item_t *item;
+
+   if( 0 == ut_rcu.free_cnt )
+   {
+      ebr_synchronize(self);
+   }
+   item = ut_rcu.free[--ut_rcu.free_cnt];
+   item->key = key;
+   __atomic_store_n(&item->alive, true, __ATOMIC_RELAXED);
+
+   return item;
+}
+
+static void* ut_rcu_reader(void *arg)
+{
+   ut_rcu_reader_t *t = arg;
+
+   ebr_register(&t->shared->ebr, &t->ebr);
+   while( !__atomic_load_n(&t->shared->stop, __ATOMIC_ACQUIRE) )
+   {
+      ut_rcu_item_t *item;
+      unsigned prev = 0;
+      unsigned cnt = 0;
+
+      ebr_enter(&t->ebr);
+      list_for_each_entry_rcu(item, &t->shared->head, list)
+      {
+         unsigned key = item->key;
+
+         /* key of element does not change until it is reused, the yield lets
+          * the writer run while the reader holds the element also on single
+          * CPU */
+         UT_ASSERT( key >= prev );
+         if( 0 == (cnt & 7) )
+         {
+            sched_yield();
+         }
+         UT_ASSERT( __atomic_load_n(&item->alive, __ATOMIC_RELAXED) );
+         UT_ASSERT_EQUAL( item->key, key );
+         prev = key + 1;
+         if( ++cnt > UT_RCU_KEYS )
+         {
+            UT_ASSERT( 0 );
+            break;
+         }
+      }
+      ebr_exit(&t->ebr);
+      __atomic_store_n(&t->scans, t->scans + 1, __ATOMIC_RELAXED);
+   }
+   ebr_unregister(&t->ebr);
+
+   return NULL;
+}
+
+extern void ut_list_rcu_concurrent_test(void)
+{
+   static ut_rcu_reader_t readers[UT_RCU_READERS];
+   pthread_t tid[UT_RCU_READERS];
+   ebr_thread_t self = { 0 };
+   ut_rcu_item_t *item;
+   unsigned op;
+   unsigned i;
+
+   memset(&ut_rcu, 0, sizeof(ut_rcu));
+   list_init(&ut_rcu.head);
+   ebr_init(&ut_rcu.ebr);
+   for( i = 0; i < UT_RCU_NODES; i++ )
+   {
+      ut_rcu.free[ut_rcu.free_cnt++] = &ut_rcu.items[i];
+   }
+   ebr_register(&ut_rcu.ebr, &self);
+   for( i = 0; i < UT_RCU_READERS; i++ )
+   {
+      memset(&readers[i], 0, sizeof(readers[i]));
+      readers[i].shared = &ut_rcu;
+      UT_ASSERT( 0 == pthread_create(&tid[i], NULL, ut_rcu_reader, &readers[i]) );
+   }
+   /* all readers walk the list before the first change */
+   for( i = 0; i < UT_RCU_READERS; i++ )
+   {
+      while( 0 == __atomic_load_n(&readers[i].scans, __ATOMIC_RELAXED) )
+      {
+         sched_yield();
+      }
+   }
+
+   /* single writer keeps the list sorted by key, so it walks the list
+    * without critical section, and from time to time gives the CPU to
+    * readers */
+   for( op = 0; op < UT_RCU_OPS; op++ )
+   {
+      unsigned key = random() % UT_RCU_KEYS;
+      list_t *itr;
+
+      list_for_each(itr, &ut_rcu.head)
+      {
+         if( list_entry(itr, ut_rcu_item_t, list)->key >= key )
+         {
+            break;
+         }
+      }
+      item = list_entry(itr, ut_rcu_item_t, list);
+      if( (itr == &ut_rcu.head) || (item->key != key) )
+      {
+         list_rcu_put_before(itr, &ut_rcu_alloc(&self, key)->list);
+      }
+      else if( random() & 1 )
+      {
+         list_rcu_unlink(&item->list);
+         ebr_retire(&self, &item->ebr, ut_rcu_reclaim);
+      }
+      else
+      {
+         list_rcu_replace(&item->list, &ut_rcu_alloc(&self, key)->list);
+         ebr_retire(&self, &item->ebr, ut_rcu_reclaim);
+      }
+      if( 0 == (op & 63) )
+      {
+         sched_yield();
+      }
+   }
+
+   __atomic_store_n(&ut_rcu.stop, true, __ATOMIC_RELEASE);
+   for( i = 0; i < UT_RCU_READERS; i++ )
+   {
+      pthread_join(tid[i], NULL);
+      UT_ASSERT( readers[i].scans > 0 );
+   }
+   ebr_unregister(&self);
+   i = 0;
+   list_for_each_entry(item, &ut_rcu.head, list)
+   {
+      UT_ASSERT( item->alive );
+      i++;
+   }
+   UT_ASSERT_EQUAL( i + ut_rcu.free_cnt, UT_RCU_NODES );
+}
+
+static const ut_test_info_t ut_list_suite[] = {
+   { "Splice", ut_list_splice_test },
+   { "Sort", ut_list_sort_test },
+   { "RCU", ut_list_rcu_test },
+   { "RCU concurrent", ut_list_rcu_concurrent_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_list_suite, sizeof(ut_list_suite) / sizeof(ut_list_suite[0]));
+}
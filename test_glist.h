@@ -0,0 +1,79 @@
+#ifndef __GLIST_TEST_H__
+#define __GLIST_TEST_H__
+
+/**
+  * \brief Bulk moves of element chains
+  * \pre Two lists with elements
+  * \post Lists with elements in expected order
+  *
+  * \test
+  *   \li Splice at the end and at the begining, also of empty list
+  *   \li Cut at the header, at the first, middle and last element
+  *   \li Both next and prev links are consistent after each operation
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref list_splice_append
+  *   \li \ref list_splice_prepend
+  *   \li \ref list_cut
+  */
+extern void ut_list_splice_test(void);
+
+/**
+  * \brief Merge sort
+  * \pre Lists of random length with random keys from small range
+  * \post Sorted lists
+  *
+  * \test
+  *   \li Elements are in order of keys, elements with equal keys keep their
+  *       original order
+  *   \li Prio list sorted once is the same as built by listprio_append
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref list_sort
+  *   \li \ref listprio_sort
+  */
+extern void ut_list_sort_test(void);
+
+/**
+  * \brief RCU list operations in single thread
+  * \pre Empty list
+  * \post List with three elements
+  *
+  * \test
+  *   \li Publishing at both ends, before and after given element
+  *   \li Unlinked element still points to its successor in the list
+  *   \li Replaced element is at the same position, links are consistent
+  *   \li Reader side iteration visits the same elements
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref list_rcu_prepend
+  *   \li \ref list_rcu_append
+  *   \li \ref list_rcu_put_after
+  *   \li \ref list_rcu_put_before
+  *   \li \ref list_rcu_unlink
+  *   \li \ref list_rcu_replace
+  *   \li \ref list_rcu_is_empty
+  */
+extern void ut_list_rcu_test(void);
+
+/**
+  * \brief Readers walk the list while single writer modifies it
+  * \pre Empty list guarded by ebr_t, pool of elements
+  * \post List with random elements, all other elements back in pool
+  *
+  * \test
+  *   \li Writer inserts, unlinks and replaces elements of sorted list,
+  *       removed elements return to the pool through ebr_retire()
+  *   \li Readers see keys in order and no element is reused while a reader
+  *       holds it, also when reader yields inside critical section
+  *   \li All retired elements are reclaimed after ebr_unregister()
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref list_for_each_entry_rcu
+  *   \li \ref list_rcu_put_before
+  *   \li \ref list_rcu_unlink
+  *   \li \ref list_rcu_replace
+  */
+extern void ut_list_rcu_concurrent_test(void);
+
+#endif /*__GLIST_TEST_H__*/
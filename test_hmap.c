@@ -0,0 +1,173 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "hmap.h"
+#include "test_common.h"
+#include "test_hmap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define UT_CAPACITY 1024
+#define UT_KEY_RANGE 2048
+#define UT_OPS 300000
+
+static inline uint32_t ut_hash(const uint32_t *key)
+{
+   /* murmur3 finalizer */
+   uint32_t h = *key;
+
+   h ^= h >> 16;
+   h *= 0x85ebca6b;
+   h ^= h >> 13;
+   h *= 0xc2b2ae35;
+   h ^= h >> 16;
+   return h;
+}
+
+/* 8 home slots in the last group, h2 collides for keys 128 apart */
+static inline uint32_t ut_weak_hash(const uint32_t *key)
+{
+   return ((UT_CAPACITY - 8 + (*key % 8)) << 7) | (*key & 0x7F);
+}
+
+#define ut_eq(_a, _b) (*(_a) == *(_b))
+
+HMAP_DEFINE(ut_map, uint32_t, uint32_t, ut_hash, ut_eq)
+HMAP_DEFINE(ut_weak, uint32_t, uint32_t, ut_weak_hash, ut_eq)
+
+static uint8_t ut_ctrl[HMAP_CTRL_SIZE(UT_CAPACITY)];
+static ut_map_slot_t ut_slots[UT_CAPACITY];
+static ut_weak_slot_t ut_weak_slots[UT_CAPACITY];
+/* reference, value + 1 or 0 if key is not present */
+static uint32_t ut_ref[UT_KEY_RANGE];
+
+extern void ut_hmap_random_test(void)
+{
+   ut_map_t map;
+   ut_map_slot_t *slot;
+   unsigned count = 0;
+   unsigned pos;
+   unsigned i;
+
+   ut_map_init(&map, ut_ctrl, ut_slots, UT_CAPACITY);
+   memset(ut_ref, 0, sizeof(ut_ref));
+
+   for( i = 0; i < UT_OPS; i++ )
+   {
+      uint32_t key = random() % UT_KEY_RANGE;
+      uint32_t val = random();
+      uint32_t *found = ut_map_find(&map, &key);
+
+      UT_ASSERT_EQUAL( NULL != found, 0 != ut_ref[key] );
+      if( NULL != found )
+      {
+         UT_ASSERT_EQUAL( *found + 1, ut_ref[key] );
+      }
+
+      /* bias to inserts so the map is full often */
+      if( random() % 8 < 5 )
+      {
+         uint32_t *stored = ut_map_insert(&map, &key, &val);
+
+         if( (NULL == found) && (count >= map.h.max) )
+         {
+            UT_ASSERT( NULL == stored );
+            UT_ASSERT( NULL == ut_map_find(&map, &key) );
+            continue;
+         }
+         UT_ASSERT( (NULL != stored) && (val == *stored) );
+         UT_ASSERT( (NULL == found) || (found == stored) );
+         count += (NULL == found);
+         ut_ref[key] = val + 1;
+      }
+      else
+      {
+         UT_ASSERT_EQUAL( ut_map_remove(&map, &key), NULL != found );
+         UT_ASSERT( NULL == ut_map_find(&map, &key) );
+         count -= (NULL != found);
+         ut_ref[key] = 0;
+      }
+      UT_ASSERT_EQUAL( ut_map_count(&map), count );
+   }
+
+   pos = 0;
+   i = 0;
+   while( NULL != (slot = ut_map_next(&map, &pos)) )
+   {
+      UT_ASSERT( slot->key < UT_KEY_RANGE );
+      UT_ASSERT_EQUAL( slot->val + 1, ut_ref[slot->key] );
+      ut_ref[slot->key] = 0;
+      i++;
+   }
+   UT_ASSERT_EQUAL( i, count );
+}
+
+extern void ut_hmap_cluster_test(void)
+{
+   static uint8_t present[UT_KEY_RANGE];
+   ut_weak_t map;
+   unsigned round;
+   uint32_t key;
+
+   ut_weak_init(&map, ut_ctrl, ut_weak_slots, UT_CAPACITY);
+   memset(present, 0, sizeof(present));
+
+   for( round = 0; round < 20; round++ )
+   {
+      unsigned count = ut_weak_count(&map);
+
+      /* fill up */
+      while( count < map.h.max )
+      {
+         key = random() % UT_KEY_RANGE;
+         UT_ASSERT( NULL != ut_weak_insert(&map, &key, &key) );
+         count += !present[key];
+         present[key] = 1;
+      }
+      UT_ASSERT_EQUAL( ut_weak_count(&map), count );
+      key = UT_KEY_RANGE;
+      UT_ASSERT( NULL == ut_weak_insert(&map, &key, &key) );
+
+      /* remove random half */
+      for( key = 0; key < UT_KEY_RANGE; key++ )
+      {
+         if( present[key] && (random() % 2) )
+         {
+            UT_ASSERT( ut_weak_remove(&map, &key) );
+            present[key] = 0;
+            count--;
+         }
+      }
+      UT_ASSERT_EQUAL( ut_weak_count(&map), count );
+
+      for( key = 0; key < UT_KEY_RANGE; key++ )
+      {
+         uint32_t *val = ut_weak_find(&map, &key);
+
+         UT_ASSERT_EQUAL( NULL != val, present[key] );
+         UT_ASSERT( (NULL == val) || (key == *val) );
+      }
+   }
+
+   for( key = 0; key < UT_KEY_RANGE; key++ )
+   {
+      UT_ASSERT_EQUAL( ut_weak_remove(&map, &key), present[key] );
+   }
+   UT_ASSERT_EQUAL( ut_weak_count(&map), 0 );
+   for( key = 0; key < HMAP_CTRL_SIZE(UT_CAPACITY); key++ )
+   {
+      UT_ASSERT_EQUAL( ut_ctrl[key], HMAP_EMPTY );
+   }
+}
+
+static const ut_test_info_t ut_hmap_suite[] = {
+   { "Random", ut_hmap_random_test },
+   { "Clusters", ut_hmap_cluster_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_hmap_suite, sizeof(ut_hmap_suite) / sizeof(ut_hmap_suite[0]));
+}
@@ -0,0 +1,38 @@
+#ifndef __HMAP_TEST_H__
+#define __HMAP_TEST_H__
+
+/**
+  * \brief Random operations compared with direct mapped reference table
+  * \pre Empty map of 1024 slots, keys from range of 2048
+  * \post Map with random content
+  *
+  * \test
+  *   \li Insert of new key, replace of existing one, find and remove return
+  *       the same as the reference
+  *   \li Insert into full map (7/8 of capacity) fails and does not change it
+  *   \li Iteration visits each stored key once
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref hmap_init
+  *   \li \ref HMAP_DEFINE
+  */
+extern void ut_hmap_random_test(void);
+
+/**
+  * \brief Long clusters with weak hash
+  * \pre Empty map, hash which maps keys to few home slots close to the end of
+  *      the slot array
+  * \post Empty map
+  *
+  * \test
+  *   \li Clusters which wrap around the end of slot array are probed through
+  *       the copied control bytes
+  *   \li After random removals every remaining key is found, missing keys are
+  *       not found, no slot is lost (map can be filled again)
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref HMAP_DEFINE
+  */
+extern void ut_hmap_cluster_test(void);
+
+#endif /*__HMAP_TEST_H__*/
@@ -0,0 +1,230 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "glist.h"
+#include "ilist.h"
+#include "test_common.h"
+#include "test_ilist.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define UT_NODES 500
+#define UT_LISTS 4
+#define UT_OPS 100000
+#define UT_PRIO_RANGE 20
+/* index 255 is ILIST_NIL, 254 is the header */
+#define UT_PRIO8_NODES 254
+
+/* node UT_NODES + i is header of list i */
+static ilist16_t ut_nodes16[UT_NODES + UT_LISTS];
+static ilist32_t ut_nodes32[UT_NODES + UT_LISTS];
+static list_t ut_ref[UT_NODES + UT_LISTS];
+static int ut_owner[UT_NODES];
+
+typedef struct {
+   uint8_t payload;
+   ilink16_t link;
+} ut_obj_t;
+
+ILIST_DEFINE(ut_obj, ut_obj_t, link, uint16_t)
+
+/* compares ilist with reference list in both directions */
+#define UT_ILIST_CHECK(_name, _base, _l) \
+do { \
+   list_t *itr = ut_ref[_l].next; \
+   unsigned pos = (_l); \
+   unsigned n; \
+   for( n = 0; n <= UT_NODES; n++ ) \
+   { \
+      UT_ASSERT_EQUAL( _name##_prev(_base, _name##_next(_base, pos)), pos ); \
+      pos = _name##_next(_base, pos); \
+      UT_ASSERT_EQUAL( pos, (unsigned)(itr - ut_ref) ); \
+      if( pos == (unsigned)(_l) ) \
+      { \
+         break; \
+      } \
+      itr = itr->next; \
+   } \
+} while(0)
+
+extern void ut_ilist_ops_test(void)
+{
+   unsigned i;
+
+   UT_ASSERT_EQUAL( sizeof(ilink8_t), 2 );
+   UT_ASSERT_EQUAL( sizeof(ilink16_t), 4 );
+   UT_ASSERT_EQUAL( sizeof(ilink32_t), 8 );
+   UT_ASSERT_EQUAL( sizeof(ilistprio16_t), 6 );
+
+   for( i = 0; i < UT_NODES + UT_LISTS; i++ )
+   {
+      ilist16_init(ut_nodes16, i);
+      ilist32_init(ut_nodes32, i);
+      list_init(&ut_ref[i]);
+   }
+   for( i = 0; i < UT_NODES; i++ )
+   {
+      ut_owner[i] = -1;
+   }
+
+   for( i = 0; i < UT_OPS; i++ )
+   {
+      unsigned l = UT_NODES + random() % UT_LISTS;
+      unsigned elem = random() % UT_NODES;
+      unsigned op = random() % 6;
+
+      if( ut_owner[elem] >= 0 )
+      {
+         if( 0 == op % 2 )
+         {
+            ilist16_unlink(ut_nodes16, elem);
+            ilist32_unlink(ut_nodes32, elem);
+            list_unlink(&ut_ref[elem]);
+            ut_owner[elem] = -1;
+         }
+         else
+         {
+            unsigned owner = ut_owner[elem];
+            list_t *ref = list_detachfirst(&ut_ref[owner]);
+
+            UT_ASSERT_EQUAL( ilist16_detachfirst(ut_nodes16, owner), (unsigned)(ref - ut_ref) );
+            UT_ASSERT_EQUAL( ilist32_detachfirst(ut_nodes32, owner), (unsigned)(ref - ut_ref) );
+            ut_owner[ref - ut_ref] = -1;
+            l = owner;
+         }
+      }
+      else if( (op < 2) || list_is_empty(&ut_ref[l]) )
+      {
+         if( 0 == op % 2 )
+         {
+            ilist16_append(ut_nodes16, l, elem);
+            ilist32_append(ut_nodes32, l, elem);
+            list_append(&ut_ref[l], &ut_ref[elem]);
+         }
+         else
+         {
+            ilist16_prepend(ut_nodes16, l, elem);
+            ilist32_prepend(ut_nodes32, l, elem);
+            list_prepend(&ut_ref[l], &ut_ref[elem]);
+         }
+         ut_owner[elem] = l;
+      }
+      else
+      {
+         /* next to the last element */
+         unsigned itr = ut_ref[l].prev - ut_ref;
+
+         if( 0 == op % 2 )
+         {
+            ilist16_put_after(ut_nodes16, itr, elem);
+            ilist32_put_after(ut_nodes32, itr, elem);
+            list_put_after(&ut_ref[itr], &ut_ref[elem]);
+         }
+         else
+         {
+            ilist16_put_before(ut_nodes16, itr, elem);
+            ilist32_put_before(ut_nodes32, itr, elem);
+            list_put_before(&ut_ref[itr], &ut_ref[elem]);
+         }
+         ut_owner[elem] = l;
+      }
+      if( 0 == i % 100 )
+      {
+         UT_ILIST_CHECK(ilist16, ut_nodes16, l);
+         UT_ILIST_CHECK(ilist32, ut_nodes32, l);
+      }
+   }
+
+   for( i = UT_NODES; i < UT_NODES + UT_LISTS; i++ )
+   {
+      UT_ILIST_CHECK(ilist16, ut_nodes16, i);
+      UT_ILIST_CHECK(ilist32, ut_nodes32, i);
+      UT_ASSERT_EQUAL( ilist16_is_empty(ut_nodes16, i), list_is_empty(&ut_ref[i]) );
+      while( ILIST_NIL(uint16_t) != ilist16_detachfirst(ut_nodes16, i) );
+      while( ILIST_NIL(uint32_t) != ilist32_detachfirst(ut_nodes32, i) );
+      UT_ASSERT( ilist16_is_empty(ut_nodes16, i) );
+      UT_ASSERT( ilist32_is_empty(ut_nodes32, i) );
+      UT_ASSERT_EQUAL( ilist16_peekfirst(ut_nodes16, i), ILIST_NIL(uint16_t) );
+   }
+}
+
+extern void ut_ilist_prio_test(void)
+{
+   static ilistprio8_t p8[UT_PRIO8_NODES + 1];
+   static ilistprio16_t p16[UT_NODES + 1];
+   static ilistprio32_t p32[UT_NODES + 1];
+   static listprio_t ref[UT_NODES];
+   static ut_obj_t obj[UT_NODES + 1];
+   listprio_t h;
+   uint16_t pos;
+   uint16_t n;
+   unsigned i;
+
+   ilistprio16_init(p16, UT_NODES);
+   ilistprio32_init(p32, UT_NODES);
+   list_init(&h.list);
+   for( i = 0; i < UT_NODES; i++ )
+   {
+      p16[i].prio = p32[i].prio = ref[i].prio = random() % UT_PRIO_RANGE;
+      ilistprio16_insert(p16, UT_NODES, i);
+      ilistprio32_insert(p32, UT_NODES, i);
+      listprio_append(&h, &ref[i]);
+   }
+   for( i = 0; i < UT_NODES; i++ )
+   {
+      unsigned idx = listprio_detachfirst(&h) - ref;
+
+      UT_ASSERT_EQUAL( ilistprio16_detachfirst(p16, UT_NODES), idx );
+      UT_ASSERT_EQUAL( ilistprio32_detachfirst(p32, UT_NODES), idx );
+   }
+   UT_ASSERT( ilistprio16_is_empty(p16, UT_NODES) );
+   UT_ASSERT( ilistprio32_is_empty(p32, UT_NODES) );
+
+   /* 8 bit indexes, reference list built from the first nodes */
+   ilistprio8_init(p8, UT_PRIO8_NODES);
+   for( i = 0; i < UT_PRIO8_NODES; i++ )
+   {
+      p8[i].prio = ref[i].prio;
+      ilistprio8_insert(p8, UT_PRIO8_NODES, i);
+      listprio_append(&h, &ref[i]);
+   }
+   for( i = 0; i < UT_PRIO8_NODES; i++ )
+   {
+      UT_ASSERT_EQUAL( ilistprio8_detachfirst(p8, UT_PRIO8_NODES), listprio_detachfirst(&h) - ref );
+   }
+   UT_ASSERT_EQUAL( ilistprio8_detachfirst(p8, UT_PRIO8_NODES), ILIST_NIL(uint8_t) );
+
+   /* links embedded in own structure, every second object removed */
+   ut_obj_init(obj, UT_NODES);
+   for( i = 0; i < UT_NODES; i++ )
+   {
+      obj[i].payload = i;
+      ut_obj_append(obj, UT_NODES, i);
+   }
+   ilist_for_each_safe(pos, n, obj, UT_NODES, link)
+   {
+      if( pos % 2 )
+      {
+         ut_obj_unlink(obj, pos);
+      }
+   }
+   i = 0;
+   ilist_for_each(pos, obj, UT_NODES, link)
+   {
+      UT_ASSERT_EQUAL( pos, i );
+      UT_ASSERT_EQUAL( obj[pos].payload, (uint8_t)i );
+      i += 2;
+   }
+   UT_ASSERT_EQUAL( i, UT_NODES );
+}
+
+static const ut_test_info_t ut_ilist_suite[] = {
+   { "Operations", ut_ilist_ops_test },
+   { "Prio", ut_ilist_prio_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_ilist_suite, sizeof(ut_ilist_suite) / sizeof(ut_ilist_suite[0]));
+}
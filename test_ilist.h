@@ -0,0 +1,45 @@
+#ifndef __ILIST_TEST_H__
+#define __ILIST_TEST_H__
+
+/**
+  * \brief Random operations mirrored on glist
+  * \pre Arrays of 16 and 32 bit index nodes, list_t nodes
+  * \post Lists with random elements
+  *
+  * \test
+  *   \li Random append, prepend, put after/before, unlink and detachfirst
+  *       give the same order as the same operations on list_t
+  *   \li Links are consistent in both directions
+  *   \li Links take 2, 4 and 8 bytes
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref ilist16_append
+  *   \li \ref ilist16_prepend
+  *   \li \ref ilist16_put_after
+  *   \li \ref ilist16_put_before
+  *   \li \ref ilist16_unlink
+  *   \li \ref ilist16_detachfirst
+  *   \li \ref ilist32_append
+  *   \li \ref ilist32_unlink
+  */
+extern void ut_ilist_ops_test(void);
+
+/**
+  * \brief Priority insert and links embedded in user structure
+  * \pre Prio nodes with random prio
+  * \post Empty lists
+  *
+  * \test
+  *   \li Order is the same as created by listprio_append, for 8, 16 and 32
+  *       bit indexes
+  *   \li Functions generated by ILIST_DEFINE for own structure
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref ilistprio8_insert
+  *   \li \ref ilistprio16_insert
+  *   \li \ref ilistprio32_insert
+  *   \li \ref ILIST_DEFINE
+  */
+extern void ut_ilist_prio_test(void);
+
+#endif /*__ILIST_TEST_H__*/
@@ -0,0 +1,335 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "circfifo.h"
+#include "lz.h"
+#include "test_common.h"
+#include "test_lz.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define UT_DATA_SIZE 200000
+#define UT_CHUNK_MAX 300
+
+static uint8_t ut_data[UT_DATA_SIZE];
+static uint8_t ut_result[UT_DATA_SIZE];
+
+/* words from small dictionary with some random bytes between them */
+static void ut_fill_text(uint8_t *buff, unsigned size)
+{
+   static const char *words[] = {
+      "sensor ", "value ", "timestamp ", "42 ", "status OK ", "temperature ",
+      "pressure ", "0x1F ", "-12.5 ", "\n", "id=", "node ",
+   };
+   unsigned i = 0;
+   unsigned n;
+   const char *w;
+
+   while( i < size )
+   {
+      if( 0 == random() % 8 )
+      {
+         buff[i++] = random();
+         continue;
+      }
+      w = words[random() % (sizeof(words) / sizeof(words[0]))];
+      n = min((unsigned)strlen(w), size - i);
+      memcpy(&buff[i], w, n);
+      i += n;
+   }
+}
+
+static void ut_fill_random(uint8_t *buff, unsigned size)
+{
+   unsigned i;
+
+   for( i = 0; i < size; i++ )
+   {
+      buff[i] = random();
+   }
+}
+
+/* passes data through encoder and decoder with random chunks on both ends and
+ * flushes after random amount of data (never if flush_every is 0), checks the
+ * result and returns size of compressed stream */
+static unsigned ut_roundtrip(const uint8_t *data, unsigned size, unsigned window,
+                             unsigned in_size, unsigned mid_size, unsigned out_size,
+                             unsigned flush_every)
+{
+   uint8_t *in_buff = malloc(in_size);
+   uint8_t *mid_buff = malloc(mid_size);
+   uint8_t *out_buff = malloc(out_size);
+   circfifo_t in, mid, out;
+   lz_enc_t *enc = malloc(sizeof(*enc));
+   lz_dec_t dec;
+   unsigned wr = 0, rd = 0, compressed = 0;
+   unsigned next_flush = flush_every ? 1 + random() % flush_every : size;
+   unsigned rounds = 0;
+   unsigned count;
+   bool flushed = false;
+   int ret;
+
+   circfifo_init(&in, in_buff, in_size);
+   circfifo_init(&mid, mid_buff, mid_size);
+   circfifo_init(&out, out_buff, out_size);
+   lz_enc_init(enc, window);
+   lz_dec_init(&dec);
+
+   while( ((rd < size) || !flushed) && (rounds++ < size + 10000) )
+   {
+      if( wr < size )
+      {
+         wr += circfifo_in(&in, &data[wr], min(1 + (unsigned)random() % UT_CHUNK_MAX, size - wr));
+      }
+      if( (wr >= next_flush) || (wr == size) )
+      {
+         flushed = lz_encode_flush(enc, &mid, &in);
+         if( flushed && (wr < size) )
+         {
+            next_flush = wr + 1 + random() % flush_every;
+         }
+      }
+      else
+      {
+         (void)lz_encode(enc, &mid, &in);
+      }
+
+      count = circfifo_count(&mid);
+      ret = lz_decode(&dec, &out, &mid);
+      UT_ASSERT( ret >= 0 );
+      if( ret < 0 )
+      {
+         break;
+      }
+      compressed += count - circfifo_count(&mid);
+      if( rd < size )
+      {
+         rd += circfifo_out(&out, &ut_result[rd], min(1 + (unsigned)random() % UT_CHUNK_MAX, size - rd));
+      }
+   }
+   UT_ASSERT_EQUAL( rd, size );
+   UT_ASSERT( 0 == memcmp(ut_result, data, size) );
+
+   free(enc);
+   free(out_buff);
+   free(mid_buff);
+   free(in_buff);
+
+   return compressed;
+}
+
+/* the smallest fifos allowed with the window, plus random extra space */
+static unsigned ut_roundtrip_min(const uint8_t *data, unsigned size, unsigned window,
+                                 unsigned flush_every)
+{
+   return ut_roundtrip(data, size, window,
+                       window + LZ_LIT_MAX + LZ_MATCH_MIN + 1 + random() % 1000,
+                       LZ_SEQ_MAX + 1 + random() % 1000,
+                       window + 1 + random() % 1000,
+                       flush_every);
+}
+
+extern void ut_lz_roundtrip_test(void)
+{
+   unsigned compressed;
+   unsigned i;
+
+   ut_fill_text(ut_data, UT_DATA_SIZE);
+   for( i = 0; i < 10; i++ )
+   {
+      compressed = ut_roundtrip_min(ut_data, UT_DATA_SIZE, 256 + random() % 4096, 0);
+      UT_ASSERT( compressed < UT_DATA_SIZE / 2 );
+      compressed = ut_roundtrip_min(ut_data, UT_DATA_SIZE, 256 + random() % 4096, 1 + random() % 5000);
+      UT_ASSERT( compressed < UT_DATA_SIZE * 3 / 4 );
+      /* tiny windows */
+      (void)ut_roundtrip_min(ut_data, UT_DATA_SIZE / 10, 1 + random() % 16, 1 + random() % 100);
+   }
+   compressed = ut_roundtrip_min(ut_data, UT_DATA_SIZE, LZ_WINDOW_MAX, 0);
+   UT_ASSERT( compressed < UT_DATA_SIZE / 2 );
+   printf("text %u -> %u ", UT_DATA_SIZE, compressed);
+
+   /* long runs are split in matches of LZ_MATCH_MAX, more often when the
+      input fifo is full */
+   memset(ut_data, 0, UT_DATA_SIZE);
+   compressed = ut_roundtrip_min(ut_data, UT_DATA_SIZE, 1000, 0);
+   UT_ASSERT( compressed < UT_DATA_SIZE / 30 );
+
+   /* data which does not compress grows by sequence headers only */
+   ut_fill_random(ut_data, UT_DATA_SIZE);
+   compressed = ut_roundtrip_min(ut_data, UT_DATA_SIZE, 1000, 0);
+   UT_ASSERT( compressed < UT_DATA_SIZE + UT_DATA_SIZE / 64 );
+   printf("random %u -> %u ", UT_DATA_SIZE, compressed);
+}
+
+extern void ut_lz_history_test(void)
+{
+   unsigned block = 2000;
+   uint8_t in_buff[4096], mid_buff[4096], out_buff[4096];
+   circfifo_t in, mid, out;
+   lz_enc_t enc;
+   lz_dec_t dec;
+   unsigned sizes[3];
+   unsigned i;
+
+   ut_fill_random(ut_data, block);
+   circfifo_init(&in, in_buff, sizeof(in_buff));
+   circfifo_init(&mid, mid_buff, sizeof(mid_buff));
+   circfifo_init(&out, out_buff, sizeof(out_buff));
+   lz_enc_init(&enc, 2048);
+   lz_dec_init(&dec);
+
+   /* the same block three times, each one flushed and decoded separately */
+   for( i = 0; i < 3; i++ )
+   {
+      UT_ASSERT_EQUAL( circfifo_in(&in, ut_data, block), block );
+      UT_ASSERT( lz_encode_flush(&enc, &mid, &in) );
+      sizes[i] = circfifo_count(&mid);
+      UT_ASSERT_EQUAL( lz_decode(&dec, &out, &mid), (int)block );
+      UT_ASSERT_EQUAL( circfifo_out(&out, ut_result, block), block );
+      UT_ASSERT( 0 == memcmp(ut_result, ut_data, block) );
+   }
+   UT_ASSERT( sizes[0] > block );
+   UT_ASSERT( sizes[1] < block / 10 );
+   UT_ASSERT( sizes[2] < block / 10 );
+
+   /* window shorter than the block, history does not help */
+   circfifo_init(&in, in_buff, sizeof(in_buff));
+   lz_enc_init(&enc, 1000);
+   lz_dec_init(&dec);
+   for( i = 0; i < 2; i++ )
+   {
+      UT_ASSERT_EQUAL( circfifo_in(&in, ut_data, block), block );
+      UT_ASSERT( lz_encode_flush(&enc, &mid, &in) );
+      sizes[i] = circfifo_count(&mid);
+      UT_ASSERT_EQUAL( lz_decode(&dec, &out, &mid), (int)block );
+      UT_ASSERT_EQUAL( circfifo_out(&out, ut_result, block), block );
+      UT_ASSERT( 0 == memcmp(ut_result, ut_data, block) );
+   }
+   UT_ASSERT( sizes[1] > block );
+}
+
+static int ut_decode_stream(const uint8_t *stream, unsigned len)
+{
+   uint8_t mid_buff[64], out_buff[64];
+   circfifo_t mid, out;
+   lz_dec_t dec;
+
+   circfifo_init(&mid, mid_buff, sizeof(mid_buff));
+   circfifo_init(&out, out_buff, sizeof(out_buff));
+   lz_dec_init(&dec);
+   UT_ASSERT_EQUAL( circfifo_in(&mid, stream, len), len );
+   return lz_decode(&dec, &out, &mid);
+}
+
+extern void ut_lz_error_test(void)
+{
+   /* 3 literals, match of 5 at distance 3, literals only with empty match */
+   static const uint8_t valid[] = { 0x31, 'a', 'b', 'c', 0x03, 0x00, 0x10, 'd', 0x00, 0x00 };
+   /* match at distance 4 after 3 bytes */
+   static const uint8_t far[] = { 0x30, 'a', 'b', 'c', 0x04, 0x00 };
+   /* literals only with non zero match length */
+   static const uint8_t len[] = { 0x31, 'a', 'b', 'c', 0x00, 0x00 };
+   /* match in empty history */
+   static const uint8_t empty[] = { 0x00, 0x01, 0x00 };
+
+   UT_ASSERT_EQUAL( ut_decode_stream(valid, sizeof(valid)), 9 );
+   UT_ASSERT_EQUAL( ut_decode_stream(far, sizeof(far)), LZ_ERROR );
+   UT_ASSERT_EQUAL( ut_decode_stream(len, sizeof(len)), LZ_ERROR );
+   UT_ASSERT_EQUAL( ut_decode_stream(empty, sizeof(empty)), LZ_ERROR );
+}
+
+/* moves everything from fifo to the end of stream */
+static void ut_drain(circfifo_t *fifo, uint8_t *stream, unsigned *len)
+{
+   if( 0 != circfifo_count(fifo) )
+   {
+      *len += circfifo_out(fifo, &stream[*len], circfifo_count(fifo));
+   }
+}
+
+extern void ut_lz_interrupted_flush_test(void)
+{
+   static uint8_t stream[16384];
+   uint8_t in_buff[4096], mid_buff[1024], out_buff[8192];
+   uint8_t filler[1024];
+   circfifo_t in, mid, out;
+   lz_enc_t enc;
+   lz_dec_t dec;
+   unsigned trial, size, extra, len, filled, chunk;
+   unsigned long_lit = 0;
+
+   for( trial = 0; trial < 50; trial++ )
+   {
+      circfifo_init(&in, in_buff, sizeof(in_buff));
+      circfifo_init(&mid, mid_buff, sizeof(mid_buff));
+      lz_enc_init(&enc, 1000);
+      ut_fill_random(ut_data, 8192);
+      len = 0;
+
+      /* random data makes big literal steps, then chunks shorter than
+       * LZ_MATCH_MIN wait for more data until pending literals and the
+       * waiting bytes exceed LZ_LIT_MAX */
+      size = LZ_LIT_MAX + random() % 1000;
+      UT_ASSERT_EQUAL( circfifo_in(&in, ut_data, size), size );
+      (void)lz_encode(&enc, &mid, &in);
+      ut_drain(&mid, stream, &len);
+      while( (enc.lit + circfifo_count(&in) - enc.done <= LZ_LIT_MAX) && (size < 4000) )
+      {
+         chunk = 1 + random() % (LZ_MATCH_MIN - 1);
+         UT_ASSERT_EQUAL( circfifo_in(&in, &ut_data[size], chunk), chunk );
+         size += chunk;
+         (void)lz_encode(&enc, &mid, &in);
+         ut_drain(&mid, stream, &len);
+      }
+
+      /* flush fails on the first sequence, output has no space */
+      filled = circfifo_in(&mid, filler, circfifo_space(&mid) - LZ_SEQ_MAX + 1);
+      UT_ASSERT( !lz_encode_flush(&enc, &mid, &in) );
+      long_lit += (enc.lit > LZ_LIT_MAX);
+      UT_ASSERT_EQUAL( circfifo_out(&mid, filler, filled), filled );
+      UT_ASSERT_EQUAL( circfifo_count(&mid), 0 );
+
+      /* caller continues with more data instead of repeating the flush,
+       * data repeats what was just written, so the literals are followed by
+       * a match */
+      extra = 1 + random() % 1000;
+      memmove(&ut_data[size], &ut_data[size - 600], extra);
+      UT_ASSERT_EQUAL( circfifo_in(&in, &ut_data[size], extra), extra );
+      (void)lz_encode(&enc, &mid, &in);
+      ut_drain(&mid, stream, &len);
+      while( !lz_encode_flush(&enc, &mid, &in) )
+      {
+         UT_ASSERT( circfifo_count(&mid) > 0 );
+         ut_drain(&mid, stream, &len);
+      }
+      ut_drain(&mid, stream, &len);
+
+      circfifo_init(&mid, stream, sizeof(stream));
+      mid.wr = len;
+      circfifo_init(&out, out_buff, sizeof(out_buff));
+      lz_dec_init(&dec);
+      UT_ASSERT_EQUAL( lz_decode(&dec, &out, &mid), (int)(size + extra) );
+      UT_ASSERT_EQUAL( circfifo_out(&out, ut_result, size + extra), size + extra );
+      UT_ASSERT( 0 == memcmp(ut_result, ut_data, size + extra) );
+   }
+   /* most of trials left more than LZ_LIT_MAX pending literals */
+   UT_ASSERT( long_lit > 0 );
+}
+
+static const ut_test_info_t ut_lz_suite[] = {
+   { "Round trip", ut_lz_roundtrip_test },
+   { "History", ut_lz_history_test },
+   { "Errors", ut_lz_error_test },
+   { "Interrupted flush", ut_lz_interrupted_flush_test },
+};
+
+int main(void)
+{
+   long seed = time(NULL);
+
+   srandom(seed);
+   printf("Random seed = %li\n", seed);
+
+   return ut_run_suite(ut_lz_suite, sizeof(ut_lz_suite) / sizeof(ut_lz_suite[0]));
+}
@@ -0,0 +1,72 @@
+#ifndef __LZ_TEST_H__
+#define __LZ_TEST_H__
+
+/**
+  * \brief Compression and decompression through three fifos
+  * \pre Text like, zero and random data
+  * \post None
+  *
+  * \test
+  *   \li Random chunks are written and read on both ends, fifos have random
+  *       sizes from the smallest allowed, so data wraps at any position
+  *   \li Random windows, with and without flushes in random places
+  *   \li Decoded data is the same as the original
+  *   \li Text compresses to less than half, zeros to less than 1/30
+  *   \li Random data grows less than 1/64
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref lz_encode
+  *   \li \ref lz_encode_flush
+  *   \li \ref lz_decode
+  */
+extern void ut_lz_roundtrip_test(void);
+
+/**
+  * \brief History is kept across flushes
+  * \pre Random block of 2000 bytes
+  * \post None
+  *
+  * \test
+  *   \li Each flushed block is decoded completely
+  *   \li Repeated block is encoded as matches when it is within the window
+  *   \li Repeated block does not compress when window is shorter
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref lz_encode_flush
+  *   \li \ref lz_decode
+  */
+extern void ut_lz_history_test(void);
+
+/**
+  * \brief Corrupted streams
+  * \pre None
+  * \post None
+  *
+  * \test
+  *   \li Valid hand made stream with overlapping match is decoded
+  *   \li Match beyond the decoded data is rejected
+  *   \li Sequence without match but with match length is rejected
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref lz_decode
+  */
+extern void ut_lz_error_test(void);
+
+/**
+  * \brief Encoding continues after failed flush
+  * \pre Random data fed in chunks shorter than LZ_MATCH_MIN
+  * \post None
+  *
+  * \test
+  *   \li Flush which fails on the first sequence leaves more than
+  *       LZ_LIT_MAX pending literals
+  *   \li lz_encode with more data, literals followed by match, and the next
+  *       flush produce stream which decodes to the original data
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref lz_encode
+  *   \li \ref lz_encode_flush
+  */
+extern void ut_lz_interrupted_flush_test(void);
+
+#endif /*__LZ_TEST_H__*/
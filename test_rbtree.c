@@ -0,0 +1,193 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "rbtree.h"
+#include "test_common.h"
+#include "test_rbtree.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define UT_NODES 4096
+#define UT_KEY_RANGE 1024
+#define UT_OPS 200000
+
+typedef struct {
+   int key;
+   unsigned seq;
+   bool linked;
+   rbnode_t node;
+} ut_item_t;
+
+static int ut_item_cmp(const rbnode_t *node, const void *key)
+{
+   int a = container_of(node, ut_item_t, node)->key;
+   int b = *(const int*)key;
+
+   return (a > b) - (a < b);
+}
+
+static ut_item_t* ut_item(const rbnode_t *node)
+{
+   return container_of(node, ut_item_t, node);
+}
+
+/* returns black height of subtree, -1 on violation */
+static int ut_check_subtree(const rbnode_t *n, const rbnode_t *parent, unsigned depth, unsigned *max_depth)
+{
+   int lh, rh;
+
+   if( NULL == n )
+   {
+      return 1;
+   }
+   *max_depth = max(*max_depth, depth);
+   UT_ASSERT( (n->parent_color & ~(uintptr_t)1) == (uintptr_t)parent );
+   if( 0 == (n->parent_color & 1) )
+   {
+      /* red node has only black children */
+      UT_ASSERT( (NULL == n->left) || (n->left->parent_color & 1) );
+      UT_ASSERT( (NULL == n->right) || (n->right->parent_color & 1) );
+   }
+   lh = ut_check_subtree(n->left, n, depth + 1, max_depth);
+   rh = ut_check_subtree(n->right, n, depth + 1, max_depth);
+   UT_ASSERT( (lh == rh) && (lh > 0) );
+   if( (lh != rh) || (lh < 0) )
+   {
+      return -1;
+   }
+   return lh + (int)(n->parent_color & 1);
+}
+
+static void ut_check_tree(const rbtree_t *t, unsigned count)
+{
+   const rbnode_t *n;
+   const ut_item_t *prev = NULL;
+   unsigned depth = 0;
+   unsigned cnt = 0;
+
+   UT_ASSERT( (NULL == t->root) || (t->root->parent_color & 1) );
+   UT_ASSERT( ut_check_subtree(t->root, NULL, 1, &depth) > 0 );
+   /* red-black tree height is at most 2 * log2(n + 1) */
+   UT_ASSERT( (1u << (depth / 2)) <= count + 1 );
+
+   for( n = t->root; (NULL != n) && (NULL != n->left); n = n->left );
+   UT_ASSERT( rbtree_first(t) == n );
+   for( n = rbtree_first(t); NULL != n; n = rbtree_next(n) )
+   {
+      const ut_item_t *item = ut_item(n);
+      if( NULL != prev )
+      {
+         UT_ASSERT( (prev->key < item->key) || ((prev->key == item->key) && (prev->seq < item->seq)) );
+      }
+      prev = item;
+      cnt++;
+   }
+   UT_ASSERT_EQUAL( cnt, count );
+   UT_ASSERT( rbtree_last(t) == ((NULL == prev) ? NULL : &prev->node) );
+}
+
+extern void ut_rbtree_query_test(void)
+{
+   static const int keys[] = { 5, 1, 9, 5, 3, 5, 7 };
+   ut_item_t items[sizeof(keys) / sizeof(keys[0])];
+   rbtree_t t;
+   rbnode_t *n;
+   unsigned i;
+   int key;
+
+   rbtree_init(&t, ut_item_cmp);
+   UT_ASSERT( rbtree_is_empty(&t) );
+   UT_ASSERT( NULL == rbtree_first(&t) );
+   UT_ASSERT( NULL == rbtree_last(&t) );
+
+   for( i = 0; i < sizeof(keys) / sizeof(keys[0]); i++ )
+   {
+      items[i].key = keys[i];
+      items[i].seq = i;
+      rbtree_insert(&t, &items[i].node, &items[i].key);
+   }
+   ut_check_tree(&t, sizeof(keys) / sizeof(keys[0]));
+
+   key = 5;
+   /* first of equal keys in insertion order */
+   UT_ASSERT( rbtree_find(&t, &key) == &items[0].node );
+   UT_ASSERT( rbtree_next(&items[0].node) == &items[3].node );
+   UT_ASSERT( rbtree_next(&items[3].node) == &items[5].node );
+   UT_ASSERT( rbtree_upper_bound(&t, &key) == &items[6].node );
+   UT_ASSERT( rbtree_prev(&items[0].node) == &items[4].node );
+   key = 4;
+   UT_ASSERT( NULL == rbtree_find(&t, &key) );
+   UT_ASSERT( rbtree_lower_bound(&t, &key) == &items[0].node );
+   key = 10;
+   UT_ASSERT( NULL == rbtree_lower_bound(&t, &key) );
+   UT_ASSERT( rbtree_first(&t) == &items[1].node );
+   UT_ASSERT( rbtree_last(&t) == &items[2].node );
+   UT_ASSERT( NULL == rbtree_prev(&items[1].node) );
+   UT_ASSERT( NULL == rbtree_next(&items[2].node) );
+
+   while( NULL != (n = rbtree_first(&t)) )
+   {
+      rbtree_erase(&t, n);
+   }
+   UT_ASSERT( rbtree_is_empty(&t) );
+}
+
+extern void ut_rbtree_random_test(void)
+{
+   static ut_item_t items[UT_NODES];
+   rbtree_t t;
+   unsigned count = 0;
+   unsigned seq = 0;
+   unsigned op;
+   unsigned i;
+
+   rbtree_init(&t, ut_item_cmp);
+   memset(items, 0, sizeof(items));
+
+   for( op = 0; op < UT_OPS; op++ )
+   {
+      ut_item_t *item = &items[random() % UT_NODES];
+
+      if( item->linked )
+      {
+         rbtree_erase(&t, &item->node);
+         item->linked = false;
+         count--;
+      }
+      else
+      {
+         item->key = random() % UT_KEY_RANGE;
+         item->seq = seq++;
+         item->linked = true;
+         rbtree_insert(&t, &item->node, &item->key);
+         count++;
+      }
+      if( 0 == (op % 1000) )
+      {
+         ut_check_tree(&t, count);
+      }
+   }
+   ut_check_tree(&t, count);
+
+   for( i = 0; i < UT_NODES; i++ )
+   {
+      if( items[i].linked )
+      {
+         rbtree_erase(&t, &items[i].node);
+         count--;
+      }
+   }
+   ut_check_tree(&t, count);
+   UT_ASSERT( rbtree_is_empty(&t) );
+}
+
+static const ut_test_info_t ut_rbtree_suite[] = {
+   { "Queries", ut_rbtree_query_test },
+   { "Random", ut_rbtree_random_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_rbtree_suite, sizeof(ut_rbtree_suite) / sizeof(ut_rbtree_suite[0]));
+}
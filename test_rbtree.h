@@ -0,0 +1,41 @@
+#ifndef __RBTREE_TEST_H__
+#define __RBTREE_TEST_H__
+
+/**
+  * \brief Queries on small tree with duplicated keys
+  * \pre Empty tree
+  * \post Empty tree
+  *
+  * \test
+  *   \li Equal keys are iterated in insertion order
+  *   \li Find, lower and upper bound, first, last, next and prev
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref rbtree_insert
+  *   \li \ref rbtree_find
+  *   \li \ref rbtree_lower_bound
+  *   \li \ref rbtree_upper_bound
+  *   \li \ref rbtree_first
+  *   \li \ref rbtree_last
+  *   \li \ref rbtree_next
+  *   \li \ref rbtree_prev
+  */
+extern void ut_rbtree_query_test(void);
+
+/**
+  * \brief Random inserts and erases with invariant checking
+  * \pre Empty tree
+  * \post Empty tree
+  *
+  * \test
+  *   \li No red node has red child, all paths have the same black height
+  *   \li Parent links, in-order sequence and cached leftmost node are correct
+  *   \li Tree height stays logarithmic
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref rbtree_insert
+  *   \li \ref rbtree_erase
+  */
+extern void ut_rbtree_random_test(void);
+
+#endif /*__RBTREE_TEST_H__*/
@@ -0,0 +1,369 @@
+#include "arch.h"
+#include "gmacros.h"
+#include "skiplist.h"
+#include "test_common.h"
+#include "test_skiplist.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#define UT_BASIC_KEYS 1000
+#define UT_WRITERS 4
+#define UT_READERS 2
+#define UT_KEYS 4096
+#define UT_OPS 200000
+#define UT_SAME_KEYS 16
+#define UT_SAME_OPS 100000
+
+typedef struct {
+   long key;
+   skiplist_node_t node;
+} ut_item_t;
+
+static int ut_item_cmp(const skiplist_node_t *node, const void *key)
+{
+   long a = container_of(node, ut_item_t, node)->key;
+   long b = *(const long*)key;
+
+   return (a > b) - (a < b);
+}
+
+static long ut_key(skiplist_node_t *node)
+{
+   return container_of(node, ut_item_t, node)->key;
+}
+
+static void ut_item_reclaim(ebr_node_t *node)
+{
+   ut_item_t *item = container_of(container_of(node, skiplist_node_t, ebr), ut_item_t, node);
+
+   /* poison, reader which still uses the node will see broken order */
+   item->key = -1;
+   free(item);
+}
+
+extern void ut_skiplist_basic_test(void)
+{
+   static ut_item_t items[UT_BASIC_KEYS];
+   static ut_item_t dup;
+   skiplist_t sl;
+   skiplist_node_t *node;
+   long order[UT_BASIC_KEYS];
+   long i, key, prev;
+
+   skiplist_init(&sl, ut_item_cmp);
+   UT_ASSERT( NULL == skiplist_first(&sl) );
+
+   /* keys are even numbers inserted in random order */
+   for( i = 0; i < UT_BASIC_KEYS; i++ )
+   {
+      order[i] = i;
+   }
+   for( i = UT_BASIC_KEYS - 1; i > 0; i-- )
+   {
+      long j = random() % (i + 1);
+      long t = order[i];
+      order[i] = order[j];
+      order[j] = t;
+   }
+   for( i = 0; i < UT_BASIC_KEYS; i++ )
+   {
+      items[order[i]].key = order[i] * 2;
+      UT_ASSERT( skiplist_insert(&sl, &items[order[i]].node, &items[order[i]].key) );
+   }
+   dup.key = 10;
+   UT_ASSERT( !skiplist_insert(&sl, &dup.node, &dup.key) );
+
+   for( i = 0, node = skiplist_first(&sl); NULL != node; node = skiplist_next(node), i++ )
+   {
+      UT_ASSERT_EQUAL( ut_key(node), i * 2 );
+   }
+   UT_ASSERT_EQUAL( i, UT_BASIC_KEYS );
+
+   key = 11;
+   UT_ASSERT( NULL == skiplist_find(&sl, &key) );
+   UT_ASSERT_EQUAL( ut_key(skiplist_lower_bound(&sl, &key)), 12 );
+   key = 12;
+   UT_ASSERT( &items[6].node == skiplist_find(&sl, &key) );
+   key = UT_BASIC_KEYS * 2;
+   UT_ASSERT( NULL == skiplist_lower_bound(&sl, &key) );
+
+   /* delete every key divisible by 4 */
+   for( i = 0; i < UT_BASIC_KEYS; i += 2 )
+   {
+      key = i * 2;
+      UT_ASSERT( &items[i].node == skiplist_delete(&sl, &key) );
+      UT_ASSERT( NULL == skiplist_delete(&sl, &key) );
+   }
+   prev = -1;
+   for( i = 0, node = skiplist_first(&sl); NULL != node; node = skiplist_next(node), i++ )
+   {
+      UT_ASSERT( ut_key(node) > prev );
+      UT_ASSERT_EQUAL( ut_key(node) % 4, 2 );
+      prev = ut_key(node);
+   }
+   UT_ASSERT_EQUAL( i, UT_BASIC_KEYS / 2 );
+
+   for( i = 1; i < UT_BASIC_KEYS; i += 2 )
+   {
+      key = i * 2;
+      UT_ASSERT( &items[i].node == skiplist_delete(&sl, &key) );
+   }
+   UT_ASSERT( NULL == skiplist_first(&sl) );
+}
+
+typedef struct {
+   skiplist_t sl;
+   ebr_t ebr;
+   bool stop;
+} ut_shared_t;
+
+typedef struct {
+   ut_shared_t *shared;
+   ebr_thread_t ebr;
+   unsigned id;
+   bool present[UT_KEYS];
+   unsigned long scans;
+} ut_thread_t;
+
+static void* ut_writer(void *arg)
+{
+   ut_thread_t *t = arg;
+   unsigned seed = t->id;
+   unsigned op;
+
+   ebr_register(&t->shared->ebr, &t->ebr);
+   for( op = 0; op < UT_OPS; op++ )
+   {
+      /* writer owns keys equal to its id modulo number of writers */
+      long key = (rand_r(&seed) % (UT_KEYS / UT_WRITERS)) * UT_WRITERS + t->id;
+      long other = rand_r(&seed) % UT_KEYS;
+      skiplist_node_t *node;
+
+      ebr_enter(&t->ebr);
+      if( t->present[key] )
+      {
+         node = skiplist_delete(&t->shared->sl, &key);
+         UT_ASSERT( (NULL != node) && (ut_key(node) == key) );
+         if( NULL != node )
+         {
+            ebr_retire(&t->ebr, &node->ebr, ut_item_reclaim);
+         }
+         t->present[key] = false;
+      }
+      else
+      {
+         ut_item_t *item = malloc(sizeof(*item));
+         item->key = key;
+         UT_ASSERT( skiplist_insert(&t->shared->sl, &item->node, &item->key) );
+         t->present[key] = true;
+      }
+      node = skiplist_find(&t->shared->sl, &other);
+      UT_ASSERT( (NULL == node) || (ut_key(node) == other) );
+      ebr_exit(&t->ebr);
+   }
+   ebr_unregister(&t->ebr);
+
+   return NULL;
+}
+
+static void* ut_reader(void *arg)
+{
+   ut_thread_t *t = arg;
+
+   ebr_register(&t->shared->ebr, &t->ebr);
+   while( !__atomic_load_n(&t->shared->stop, __ATOMIC_ACQUIRE) )
+   {
+      skiplist_node_t *node;
+      long prev = -1;
+
+      ebr_enter(&t->ebr);
+      for( node = skiplist_first(&t->shared->sl); NULL != node; node = skiplist_next(node) )
+      {
+         long key = ut_key(node);
+         UT_ASSERT( key > prev );
+         prev = key;
+      }
+      ebr_exit(&t->ebr);
+      t->scans++;
+   }
+   ebr_unregister(&t->ebr);
+
+   return NULL;
+}
+
+extern void ut_skiplist_concurrent_test(void)
+{
+   static ut_shared_t shared;
+   static ut_thread_t threads[UT_WRITERS + UT_READERS];
+   pthread_t tid[UT_WRITERS + UT_READERS];
+   ebr_thread_t self;
+   skiplist_node_t *node;
+   unsigned i;
+   long key;
+
+   skiplist_init(&shared.sl, ut_item_cmp);
+   ebr_init(&shared.ebr);
+   memset(threads, 0, sizeof(threads));
+   for( i = 0; i < UT_WRITERS + UT_READERS; i++ )
+   {
+      threads[i].shared = &shared;
+      threads[i].id = i;
+      UT_ASSERT_EQUAL( pthread_create(&tid[i], NULL,
+                                      (i < UT_WRITERS) ? ut_writer : ut_reader,
+                                      &threads[i]), 0 );
+   }
+   for( i = 0; i < UT_WRITERS; i++ )
+   {
+      pthread_join(tid[i], NULL);
+   }
+   __atomic_store_n(&shared.stop, true, __ATOMIC_RELEASE);
+   for( i = UT_WRITERS; i < UT_WRITERS + UT_READERS; i++ )
+   {
+      pthread_join(tid[i], NULL);
+      UT_ASSERT( threads[i].scans > 0 );
+   }
+
+   /* set has to contain exactly the keys writers think are present */
+   for( key = 0, node = skiplist_first(&shared.sl); key < UT_KEYS; key++ )
+   {
+      if( threads[key % UT_WRITERS].present[key] )
+      {
+         UT_ASSERT( (NULL != node) && (ut_key(node) == key) );
+         node = (NULL != node) ? skiplist_next(node) : NULL;
+      }
+   }
+   UT_ASSERT( NULL == node );
+
+   /* cleanup */
+   memset(&self, 0, sizeof(self));
+   ebr_register(&shared.ebr, &self);
+   while( NULL != (node = skiplist_first(&shared.sl)) )
+   {
+      key = ut_key(node);
+      UT_ASSERT( node == skiplist_delete(&shared.sl, &key) );
+      ebr_retire(&self, &node->ebr, ut_item_reclaim);
+   }
+   ebr_unregister(&self);
+}
+
+typedef struct {
+   ut_shared_t *shared;
+   ebr_thread_t ebr;
+   unsigned id;
+   unsigned long inserted;
+   unsigned long deleted;
+} ut_same_thread_t;
+
+/* all writers insert and delete the same few keys, so deletes often hit the
+ * nodes which are still being linked on upper levels */
+static void* ut_same_writer(void *arg)
+{
+   ut_same_thread_t *t = arg;
+   unsigned seed = t->id;
+   unsigned op;
+
+   ebr_register(&t->shared->ebr, &t->ebr);
+   for( op = 0; op < UT_SAME_OPS; op++ )
+   {
+      long key = rand_r(&seed) % UT_SAME_KEYS;
+      skiplist_node_t *node;
+
+      ebr_enter(&t->ebr);
+      if( rand_r(&seed) & 1 )
+      {
+         node = skiplist_delete(&t->shared->sl, &key);
+         UT_ASSERT( (NULL == node) || (ut_key(node) == key) );
+         if( NULL != node )
+         {
+            ebr_retire(&t->ebr, &node->ebr, ut_item_reclaim);
+            t->deleted++;
+         }
+      }
+      else
+      {
+         ut_item_t *item = malloc(sizeof(*item));
+         item->key = key;
+         if( skiplist_insert(&t->shared->sl, &item->node, &item->key) )
+         {
+            t->inserted++;
+         }
+         else
+         {
+            /* never linked, nobody can see it */
+            free(item);
+         }
+      }
+      node = skiplist_find(&t->shared->sl, &key);
+      UT_ASSERT( (NULL == node) || (ut_key(node) == key) );
+      ebr_exit(&t->ebr);
+   }
+   ebr_unregister(&t->ebr);
+
+   return NULL;
+}
+
+extern void ut_skiplist_same_keys_test(void)
+{
+   static ut_shared_t shared;
+   static ut_same_thread_t writers[UT_WRITERS];
+   static ut_thread_t readers[UT_READERS];
+   pthread_t tid[UT_WRITERS + UT_READERS];
+   ebr_thread_t self;
+   skiplist_node_t *node;
+   unsigned long present = 0;
+   unsigned i;
+   long key;
+
+   skiplist_init(&shared.sl, ut_item_cmp);
+   ebr_init(&shared.ebr);
+   shared.stop = false;
+   memset(writers, 0, sizeof(writers));
+   memset(readers, 0, sizeof(readers));
+   for( i = 0; i < UT_WRITERS; i++ )
+   {
+      writers[i].shared = &shared;
+      writers[i].id = i;
+      UT_ASSERT_EQUAL( pthread_create(&tid[i], NULL, ut_same_writer, &writers[i]), 0 );
+   }
+   for( i = 0; i < UT_READERS; i++ )
+   {
+      readers[i].shared = &shared;
+      UT_ASSERT_EQUAL( pthread_create(&tid[UT_WRITERS + i], NULL, ut_reader, &readers[i]), 0 );
+   }
+   for( i = 0; i < UT_WRITERS; i++ )
+   {
+      pthread_join(tid[i], NULL);
+      present += writers[i].inserted - writers[i].deleted;
+   }
+   __atomic_store_n(&shared.stop, true, __ATOMIC_RELEASE);
+   for( i = 0; i < UT_READERS; i++ )
+   {
+      pthread_join(tid[UT_WRITERS + i], NULL);
+   }
+
+   /* successful inserts minus successful deletes are left, no key twice */
+   memset(&self, 0, sizeof(self));
+   ebr_register(&shared.ebr, &self);
+   while( NULL != (node = skiplist_first(&shared.sl)) )
+   {
+      key = ut_key(node);
+      UT_ASSERT( (key >= 0) && (key < UT_SAME_KEYS) );
+      UT_ASSERT( node == skiplist_delete(&shared.sl, &key) );
+      ebr_retire(&self, &node->ebr, ut_item_reclaim);
+      UT_ASSERT( present-- > 0 );
+   }
+   UT_ASSERT_EQUAL( present, 0 );
+   ebr_unregister(&self);
+}
+
+static const ut_test_info_t ut_skiplist_suite[] = {
+   { "Basic", ut_skiplist_basic_test },
+   { "Concurrent", ut_skiplist_concurrent_test },
+   { "Same keys", ut_skiplist_same_keys_test },
+};
+
+int main(void)
+{
+   return ut_run_suite(ut_skiplist_suite, sizeof(ut_skiplist_suite) / sizeof(ut_skiplist_suite[0]));
+}
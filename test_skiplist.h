@@ -0,0 +1,67 @@
+#ifndef __SKIPLIST_TEST_H__
+#define __SKIPLIST_TEST_H__
+
+/**
+  * \brief Single threaded set operations
+  * \pre Empty skiplist
+  * \post Empty skiplist
+  *
+  * \test
+  *   \li Keys inserted in random order are iterated in ascending order
+  *   \li Duplicated key is rejected
+  *   \li Find, lower bound and delete of existing and missing keys
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref skiplist_insert
+  *   \li \ref skiplist_delete
+  *   \li \ref skiplist_find
+  *   \li \ref skiplist_lower_bound
+  *   \li \ref skiplist_first
+  *   \li \ref skiplist_next
+  */
+extern void ut_skiplist_basic_test(void);
+
+/**
+  * \brief Concurrent writers and range scanning readers
+  * \pre Empty skiplist
+  * \post Empty skiplist, all nodes reclaimed
+  *
+  * \test
+  *   \li Each writer owns a subset of keys and randomly inserts and deletes
+  *       them while others do the same on interleaved keys
+  *   \li Readers scan the whole set and check that keys are strictly ascending
+  *   \li Deleted nodes are reclaimed through ebr_retire and poisoned
+  *   \li At the end the set contains exactly the keys which writers expect
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref skiplist_insert
+  *   \li \ref skiplist_delete
+  *   \li \ref skiplist_find
+  *   \li \ref skiplist_first
+  *   \li \ref skiplist_next
+  *   \li \ref ebr_retire
+  */
+extern void ut_skiplist_concurrent_test(void);
+
+/**
+  * \brief Concurrent inserts and deletes of the same keys
+  * \pre Empty skiplist
+  * \post Empty skiplist, all nodes reclaimed
+  *
+  * \test
+  *   \li All writers randomly insert and delete the same few keys, deletes
+  *       race with inserts which are still linking upper levels
+  *   \li Readers scan the whole set and check that keys are strictly ascending
+  *   \li Retired nodes are poisoned and freed, in test_skiplist_asan any
+  *       access to reclaimed node is reported by AddressSanitizer
+  *   \li At the end the set contains as many nodes as inserts minus deletes
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref skiplist_insert
+  *   \li \ref skiplist_delete
+  *   \li \ref skiplist_find
+  *   \li \ref ebr_retire
+  */
+extern void ut_skiplist_same_keys_test(void);
+
+#endif /*__SKIPLIST_TEST_H__*/
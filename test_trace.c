@@ -0,0 +1,284 @@
+/* glist.h includes trace.h before circfifo.h, with CONFIG_CIRCFIFO_INLINE the
+ * inline circfifo functions have to see the TRACE macros anyway */
+#include "glist.h"
+#include "arch.h"
+#include "gmacros.h"
+#include "trace.h"
+#include "circfifo.h"
+#include "test_common.h"
+#include "test_trace.h"
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define UT_EV_NAMED (TRACE_ID_USER + 1)
+#define UT_EV_UNNAMED (TRACE_ID_USER + 2)
+#define UT_DUMP_MAX (64 * 1024)
+
+static char ut_dump[UT_DUMP_MAX];
+
+/* minimal JSON syntax check, returns pointer after the value or NULL */
+static const char* ut_json_value(const char *p);
+
+static const char* ut_json_ws(const char *p)
+{
+   while( isspace((unsigned char)*p) )
+   {
+      p++;
+   }
+   return p;
+}
+
+static const char* ut_json_string(const char *p)
+{
+   if( '"' != *p++ )
+   {
+      return NULL;
+   }
+   for( ; '"' != *p; p++ )
+   {
+      if( (unsigned char)*p < 0x20 )
+      {
+         return NULL; /* also the end of string */
+      }
+      if( '\\' == *p )
+      {
+         p++;
+         if( 'u' == *p )
+         {
+            if( !isxdigit((unsigned char)p[1]) || !isxdigit((unsigned char)p[2]) ||
+                !isxdigit((unsigned char)p[3]) || !isxdigit((unsigned char)p[4]) )
+            {
+               return NULL;
+            }
+            p += 4;
+         }
+         else if( NULL == strchr("\"\\/bfnrt", *p) || ('\0' == *p) )
+         {
+            return NULL;
+         }
+      }
+   }
+   return p + 1;
+}
+
+static const char* ut_json_number(const char *p)
+{
+   const char *start;
+
+   p += ('-' == *p);
+   start = p;
+   while( isdigit((unsigned char)*p) || ('.' == *p) || ('e' == *p) || ('E' == *p) ||
+          ('+' == *p) || ('-' == *p) )
+   {
+      p++;
+   }
+   return (p != start) ? p : NULL;
+}
+
+/* object or array, items separated by comma, object items are "key": value */
+static const char* ut_json_list(const char *p, char end, bool object)
+{
+   p = ut_json_ws(p + 1);
+   if( end == *p )
+   {
+      return p + 1;
+   }
+   for( ;; )
+   {
+      if( object )
+      {
+         p = ut_json_string(p);
+         if( NULL == p )
+         {
+            return NULL;
+         }
+         p = ut_json_ws(p);
+         if( ':' != *p )
+         {
+            return NULL;
+         }
+         p = ut_json_ws(p + 1);
+      }
+      p = ut_json_value(p);
+      if( NULL == p )
+      {
+         return NULL;
+      }
+      p = ut_json_ws(p);
+      if( end == *p )
+      {
+         return p + 1;
+      }
+      if( ',' != *p )
+      {
+         return NULL;
+      }
+      p = ut_json_ws(p + 1);
+   }
+}
+
+static const char* ut_json_value(const char *p)
+{
+   switch( *p )
+   {
+   case '{':
+      return ut_json_list(p, '}', true);
+   case '[':
+      return ut_json_list(p, ']', false);
+   case '"':
+      return ut_json_string(p);
+   case 't':
+      return (0 == strncmp(p, "true", 4)) ? p + 4 : NULL;
+   case 'f':
+      return (0 == strncmp(p, "false", 5)) ? p + 5 : NULL;
+   case 'n':
+      return (0 == strncmp(p, "null", 4)) ? p + 4 : NULL;
+   default:
+      return ut_json_number(p);
+   }
+}
+
+static unsigned ut_count(const char *str, const char *pattern)
+{
+   unsigned cnt = 0;
+
+   while( NULL != (str = strstr(str, pattern)) )
+   {
+      cnt++;
+      str += strlen(pattern);
+   }
+   return cnt;
+}
+
+/* dumps the trace into temporary file and reads it into ut_dump */
+static long ut_trace_dump(void)
+{
+   char path[] = "/tmp/ut_trace_XXXXXX";
+   int fd = mkstemp(path);
+   long cnt;
+   FILE *f;
+   size_t len;
+
+   UT_ASSERT( fd >= 0 );
+   close(fd);
+   cnt = trace_dump(path);
+   f = fopen(path, "r");
+   UT_ASSERT( NULL != f );
+   len = (NULL != f) ? fread(ut_dump, 1, sizeof(ut_dump) - 1, f) : 0;
+   UT_ASSERT( len < sizeof(ut_dump) - 1 );
+   ut_dump[len] = '\0';
+   if( NULL != f )
+   {
+      fclose(f);
+   }
+   unlink(path);
+
+   return cnt;
+}
+
+static void* ut_trace_worker(void *arg)
+{
+   (void)arg;
+   trace_thread_name("worker");
+   TRACE_BEGIN(UT_EV_NAMED, 1, 2);
+   TRACE_END(UT_EV_NAMED, 3, 4);
+
+   return NULL;
+}
+
+extern void ut_trace_dump_test(void)
+{
+   const char *end;
+   pthread_t tid;
+   long cnt;
+
+   trace_thread_name("main\"x\\\n");
+   trace_event_name(UT_EV_NAMED, "user \"ev\"\t");
+   TRACE(UT_EV_NAMED, 5, 6);
+   TRACE(UT_EV_UNNAMED, 7, 8);
+   TRACE(UT_EV_NAMED, 9, 10);
+   UT_ASSERT_EQUAL( pthread_create(&tid, NULL, ut_trace_worker, NULL), 0 );
+   pthread_join(tid, NULL);
+
+   cnt = ut_trace_dump();
+   UT_ASSERT_EQUAL( cnt, 5 );
+   end = ut_json_value(ut_json_ws(ut_dump));
+   UT_ASSERT( NULL != end );
+   UT_ASSERT( (NULL != end) && ('\0' == *ut_json_ws(end)) );
+
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"name\":\"thread_name\""), 2 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"name\":\"main\\\"x\\\\\\u000a\""), 1 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"name\":\"worker\""), 1 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"name\":\"user \\\"ev\\\"\\u0009\""), 4 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"name\":\"ev_258\""), 1 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"ph\":\"B\""), 1 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"ph\":\"E\""), 1 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"args\":{\"a\":9,\"b\":10}"), 1 );
+
+   /* rings are drained, next dump has only thread names */
+   UT_ASSERT_EQUAL( ut_trace_dump(), 0 );
+   UT_ASSERT( NULL != ut_json_value(ut_json_ws(ut_dump)) );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"name\":\"thread_name\""), 2 );
+}
+
+static void* ut_trace_burst(void *arg)
+{
+   unsigned i;
+
+   (void)arg;
+   for( i = 0; i < 5; i++ )
+   {
+      TRACE(UT_EV_UNNAMED, i, 0);
+   }
+
+   return NULL;
+}
+
+extern void ut_trace_lost_test(void)
+{
+   pthread_t tid;
+
+   /* ring of new thread holds events - 1 events, the rest is lost */
+   trace_init(4);
+   UT_ASSERT_EQUAL( pthread_create(&tid, NULL, ut_trace_burst, NULL), 0 );
+   pthread_join(tid, NULL);
+   UT_ASSERT_EQUAL( ut_trace_dump(), 3 );
+   UT_ASSERT( NULL != ut_json_value(ut_json_ws(ut_dump)) );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"lost\":2}"), 1 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"args\":{\"a\":2,"), 1 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"args\":{\"a\":3,"), 0 );
+}
+
+extern void ut_trace_circfifo_test(void)
+{
+   static uint8_t buff[64];
+   uint8_t data[8] = { 0 };
+   circfifo_t fifo;
+
+   ut_trace_dump();
+   circfifo_init(&fifo, buff, sizeof(buff));
+   UT_ASSERT_EQUAL( circfifo_in(&fifo, data, 5), 5 );
+   UT_ASSERT_EQUAL( circfifo_out(&fifo, data, sizeof(data)), 5 );
+
+   UT_ASSERT_EQUAL( ut_trace_dump(), 2 );
+   UT_ASSERT( NULL != ut_json_value(ut_json_ws(ut_dump)) );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"name\":\"circfifo_in\""), 1 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"name\":\"circfifo_out\""), 1 );
+   UT_ASSERT_EQUAL( ut_count(ut_dump, "\"args\":{\"a\":5,\"b\":5}"), 1 );
+}
+
+static const ut_test_info_t ut_trace_suite[] = {
+   { "Dump", ut_trace_dump_test },
+   { "Small rings", ut_trace_lost_test },
+   { "Inline circfifo", ut_trace_circfifo_test },
+};
+
+int main(void)
+{
+   srandom(time(NULL));
+   return ut_run_suite(ut_trace_suite, sizeof(ut_trace_suite) / sizeof(ut_trace_suite[0]));
+}
@@ -0,0 +1,54 @@
+#ifndef __TRACE_TEST_H__
+#define __TRACE_TEST_H__
+
+/**
+  * \brief Dump of events recorded by two threads (only with CONFIG_TRACE)
+  * \pre No events recorded
+  * \post Rings drained
+  *
+  * \test
+  *   \li Dump returns the number of events of both threads
+  *   \li Output is valid JSON also for thread and event names with quotes,
+  *       backslashes and control characters
+  *   \li Each thread and event has the expected name, unnamed user event is
+  *       named ev_<id>, begin and end phases are kept
+  *   \li Second dump has no events, thread names are still there
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref trace_thread_name
+  *   \li \ref trace_event_name
+  *   \li \ref trace_dump
+  */
+extern void ut_trace_dump_test(void);
+
+/**
+  * \brief Events which do not fit in the ring
+  * \pre Ring size set to 4 events
+  * \post Rings drained
+  *
+  * \test
+  *   \li Only the oldest events fit, the rest is counted as lost in the dump
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref trace_init
+  *   \li \ref trace_dump
+  */
+extern void ut_trace_lost_test(void);
+
+/**
+  * \brief Events of inline circfifo functions (also CONFIG_CIRCFIFO_INLINE)
+  * \pre Test includes glist.h first, so trace.h is processed before circfifo.h
+  * \post Rings drained
+  *
+  * \test
+  *   \li Inline circfifo_in and circfifo_out compile with TRACE macros
+  *   \li Both record their event with request and transferred bytes
+  *
+  * <b>Tested functions:</b><br>
+  *   \li \ref circfifo_in
+  *   \li \ref circfifo_out
+  *   \li \ref trace_dump
+  */
+extern void ut_trace_circfifo_test(void);
+
+#endif /*__TRACE_TEST_H__*/
@@ -0,0 +1,317 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE /* for syscall */
+
+#include "trace.h"
+
+#ifdef CONFIG_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+__thread trace_ring_t *trace_ring_self = NULL;
+
+/* list of rings of all threads, rings are only added */
+static trace_ring_t *trace_rings = NULL;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned trace_ring_events = TRACE_RING_EVENTS;
+static const char *trace_names[TRACE_ID_USER] = {
+   [TRACE_ID_CIRCFIFO_IN] = "circfifo_in",
+   [TRACE_ID_CIRCFIFO_OUT] = "circfifo_out",
+   [TRACE_ID_LISTPRIO_APPEND] = "listprio_append",
+   [TRACE_ID_CRC16_UPDATE] = "crc16_update",
+};
+static const char **trace_user_names = NULL;
+
+/* clock reference points taken at first event and on dump, used to convert the
+ * trace_clock() ticks to microseconds */
+static uint64_t trace_ref_tick;
+static uint64_t trace_ref_ns;
+
+static uint64_t trace_ns(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void trace_init(unsigned events)
+{
+   assert(events >= 2);
+
+   pthread_mutex_lock(&trace_lock);
+   trace_ring_events = events;
+   pthread_mutex_unlock(&trace_lock);
+}
+
+trace_ring_t* trace_ring_attach(void)
+{
+   trace_ring_t *ring;
+   void *buff;
+   unsigned events;
+
+   pthread_mutex_lock(&trace_lock);
+   events = trace_ring_events;
+   if( 0 == trace_ref_ns )
+   {
+      trace_ref_tick = trace_clock();
+      trace_ref_ns = trace_ns();
+   }
+   pthread_mutex_unlock(&trace_lock);
+
+   ring = calloc(1, sizeof(*ring));
+   buff = malloc((size_t)events * sizeof(trace_event_t));
+   if( (NULL == ring) || (NULL == buff) )
+   {
+      free(ring);
+      free(buff);
+      return NULL;
+   }
+   circfifo_init(&ring->fifo, buff, events * sizeof(trace_event_t));
+   ring->tid = (int)syscall(SYS_gettid);
+   snprintf(ring->name, sizeof(ring->name), "%d", ring->tid);
+
+   pthread_mutex_lock(&trace_lock);
+   ring->next = trace_rings;
+   trace_rings = ring;
+   pthread_mutex_unlock(&trace_lock);
+
+   trace_ring_self = ring;
+   return ring;
+}
+
+void trace_thread_name(const char *name)
+{
+   trace_ring_t *ring = trace_ring_self;
+
+   if( NULL == ring )
+   {
+      ring = trace_ring_attach();
+      if( NULL == ring )
+      {
+         return;
+      }
+   }
+   pthread_mutex_lock(&trace_lock);
+   snprintf(ring->name, sizeof(ring->name), "%s", name);
+   pthread_mutex_unlock(&trace_lock);
+}
+
+void trace_event_name(uint16_t id, const char *name)
+{
+   pthread_mutex_lock(&trace_lock);
+   if( id < TRACE_ID_USER )
+   {
+      trace_names[id] = name;
+   }
+   else
+   {
+      if( NULL == trace_user_names )
+      {
+         trace_user_names = calloc(TRACE_ID_MAX + 1 - TRACE_ID_USER, sizeof(char*));
+      }
+      if( NULL != trace_user_names )
+      {
+         trace_user_names[id - TRACE_ID_USER] = name;
+      }
+   }
+   pthread_mutex_unlock(&trace_lock);
+}
+
+/* writes the string as content of JSON string, quote, backslash and control
+ * characters are escaped so any name gives valid JSON */
+static void trace_json_str(FILE *out, const char *str)
+{
+   for( ; '\0' != *str; str++ )
+   {
+      unsigned char c = (unsigned char)*str;
+
+      if( ('"' == c) || ('\\' == c) )
+      {
+         fputc('\\', out);
+         fputc(c, out);
+      }
+      else if( c < 0x20 )
+      {
+         fprintf(out, "\\u%04x", c);
+      }
+      else
+      {
+         fputc(c, out);
+      }
+   }
+}
+
+typedef struct {
+   trace_event_t ev;
+   const trace_ring_t *ring;
+} trace_dump_event_t;
+
+static int trace_dump_cmp(const void *a, const void *b)
+{
+   uint64_t x = ((const trace_dump_event_t*)a)->ev.ts;
+   uint64_t y = ((const trace_dump_event_t*)b)->ev.ts;
+
+   return (x > y) - (x < y);
+}
+
+/* takes all events from the ring, the same algorithm as circfifo_out() */
+static size_t trace_drain(trace_ring_t *ring, trace_dump_event_t *out)
+{
+   int rd = ring->fifo.rd;
+   int wr = __atomic_load_n(&ring->fifo.wr, __ATOMIC_ACQUIRE);
+   size_t cnt = 0;
+
+   while( rd != wr )
+   {
+      memcpy(&out[cnt].ev, &ring->fifo.buff[rd], sizeof(trace_event_t));
+      out[cnt].ring = ring;
+      cnt++;
+      rd += sizeof(trace_event_t);
+      rd = (rd == ring->fifo.size) ? 0 : rd;
+   }
+   __atomic_store_n(&ring->fifo.rd, rd, __ATOMIC_RELEASE);
+
+   return cnt;
+}
+
+long trace_dump(const char *path)
+{
+   static const char ph[] = { 'i', 'B', 'E', 'i' };
+   trace_ring_t *ring;
+   trace_dump_event_t *events;
+   size_t capacity = 0;
+   size_t cnt = 0;
+   size_t i;
+   uint64_t tick, ns, ref_ns;
+   double us_per_tick;
+   FILE *out;
+   int pid = (int)getpid();
+   const char *sep = "";
+
+   /* the longer is the period between reference points the more precise is
+    * the tick to time conversion, wait without the lock which would block
+    * the threads which record their first event */
+   pthread_mutex_lock(&trace_lock);
+   if( 0 == trace_ref_ns )
+   {
+      trace_ref_tick = trace_clock();
+      trace_ref_ns = trace_ns();
+   }
+   ref_ns = trace_ref_ns;
+   pthread_mutex_unlock(&trace_lock);
+   ns = trace_ns();
+   while( (ns - ref_ns) < 10000000ull )
+   {
+      usleep(1000);
+      ns = trace_ns();
+   }
+   tick = trace_clock();
+
+   pthread_mutex_lock(&trace_lock);
+
+   for( ring = trace_rings; NULL != ring; ring = ring->next )
+   {
+      capacity += ring->fifo.size / sizeof(trace_event_t);
+   }
+   events = malloc((capacity ? capacity : 1) * sizeof(*events));
+   out = fopen(path, "w");
+   if( (NULL == events) || (NULL == out) )
+   {
+      pthread_mutex_unlock(&trace_lock);
+      free(events);
+      if( NULL != out )
+      {
+         fclose(out);
+      }
+      return -1;
+   }
+
+   for( ring = trace_rings; NULL != ring; ring = ring->next )
+   {
+      cnt += trace_drain(ring, &events[cnt]);
+   }
+   qsort(events, cnt, sizeof(*events), trace_dump_cmp);
+
+   us_per_tick = (double)(ns - trace_ref_ns) / 1e3 / (double)(tick - trace_ref_tick);
+
+   fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+   for( ring = trace_rings; NULL != ring; ring = ring->next )
+   {
+      fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                   "\"args\":{\"name\":\"", sep, pid, ring->tid);
+      trace_json_str(out, ring->name);
+      fprintf(out, "\",\"lost\":%lu}}", __atomic_load_n(&ring->lost, __ATOMIC_RELAXED));
+      sep = ",\n";
+   }
+   for( i = 0; i < cnt; i++ )
+   {
+      const trace_event_t *ev = &events[i].ev;
+      uint16_t id = (uint16_t)ev->id;
+      const char *name = (id < TRACE_ID_USER) ? trace_names[id] :
+         ((NULL != trace_user_names) ? trace_user_names[id - TRACE_ID_USER] : NULL);
+
+      fprintf(out, "%s{\"name\":\"", sep);
+      sep = ",\n";
+      if( NULL != name )
+      {
+         trace_json_str(out, name);
+      }
+      else
+      {
+         fprintf(out, "ev_%u", id);
+      }
+      fprintf(out, "\",\"ph\":\"%c\",%s\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                   "\"args\":{\"a\":%llu,\"b\":%llu}}",
+              ph[(ev->id >> 16) & 3],
+              (TRACE_PH_INSTANT == ((ev->id >> 16) & 3)) ? "\"s\":\"t\"," : "",
+              (double)(int64_t)(ev->ts - trace_ref_tick) * us_per_tick,
+              pid, events[i].ring->tid,
+              (unsigned long long)ev->a, (unsigned long long)ev->b);
+   }
+   fprintf(out, "\n]}\n");
+
+   pthread_mutex_unlock(&trace_lock);
+
+   free(events);
+   if( 0 != fclose(out) )
+   {
+      return -1;
+   }
+   return (long)cnt;
+}
+
+#endif /* CONFIG_TRACE */
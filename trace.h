@@ -0,0 +1,206 @@
+/*
+ * This file is a part of Generics project
+ * Copyright (c) 2013, Radoslaw Biernaki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'Generics' project
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE GENERICS PROJET AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __TRACE_H_
+#define __TRACE_H_ 1
+
+#include "arch.h"
+
+/**
+ * Low overhead event tracing, enabled by CONFIG_TRACE (make TRACE=1)
+ *
+ * Each thread records fixed size binary events into its own ring, so there is
+ * no synchronization between traced threads. Ring uses the circfifo_t layout
+ * (buff, size, wr, rd) with the event as the unit of transfer, the traced
+ * thread is the only writer of wr and trace_dump() the only writer of rd. When
+ * the ring is full new events are dropped and counted as lost.
+ *
+ * trace_dump() drains the rings of all threads, merges the events by time and
+ * writes them in Chrome trace format (chrome://tracing, Perfetto).
+ *
+ * Without CONFIG_TRACE all TRACE macros compile to nothing.
+ */
+
+/** Event ids used by library itself */
+enum {
+   TRACE_ID_CIRCFIFO_IN = 1,
+   TRACE_ID_CIRCFIFO_OUT,
+   TRACE_ID_LISTPRIO_APPEND,
+   TRACE_ID_CRC16_UPDATE,
+   /** first id available for user events */
+   TRACE_ID_USER = 0x100,
+   /** ids are 16 bit */
+   TRACE_ID_MAX = 0xFFFF
+};
+
+#ifdef CONFIG_TRACE
+
+/** event phase, stored in bits 16..17 of trace_event_t::id */
+#define TRACE_PH_INSTANT 0
+#define TRACE_PH_BEGIN 1
+#define TRACE_PH_END 2
+
+/* the macros have to be defined before circfifo.h, the inline circfifo
+ * functions (CONFIG_CIRCFIFO_INLINE) use them and circfifo.h includes this
+ * header while it is being processed when trace.h is included first */
+static inline void trace_event(uint32_t id, uint64_t a, uint64_t b);
+
+/** Instant event */
+#define TRACE(_id, _a, _b) \
+   trace_event((uint32_t)(_id), (uint64_t)(_a), (uint64_t)(_b))
+/** Start of duration event, has to be paired with TRACE_END in the same thread */
+#define TRACE_BEGIN(_id, _a, _b) \
+   trace_event((uint32_t)(_id) | (TRACE_PH_BEGIN << 16), (uint64_t)(_a), (uint64_t)(_b))
+/** End of duration event */
+#define TRACE_END(_id, _a, _b) \
+   trace_event((uint32_t)(_id) | (TRACE_PH_END << 16), (uint64_t)(_a), (uint64_t)(_b))
+
+#include <time.h>
+#include "circfifo.h"
+
+/** default number of events in ring of each thread */
+#define TRACE_RING_EVENTS 8192
+
+typedef struct trace_event_tag {
+   /** rdtsc ticks on x86 otherwise nanoseconds from CLOCK_MONOTONIC */
+   uint64_t ts;
+   /** event id and phase */
+   uint32_t id;
+   uint32_t reserved;
+   /** user payload */
+   uint64_t a;
+   uint64_t b;
+} trace_event_t;
+
+typedef struct trace_ring_tag {
+   /** circular buffer of events, indexes are in bytes */
+   circfifo_t fifo;
+   /** events dropped because ring was full */
+   unsigned long lost;
+   /** next ring in list of all rings */
+   struct trace_ring_tag *next;
+   /** system thread id */
+   int tid;
+   char name[16];
+} trace_ring_t;
+
+extern __thread trace_ring_t *trace_ring_self;
+
+/**
+ * Function allocates and registers the ring for calling thread. Rings are never
+ * freed, so events of thread which already finished can still be dumped.
+ * Internal function, called on first event in thread.
+ */
+trace_ring_t* trace_ring_attach(void);
+
+static inline uint64_t trace_clock(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+   return __builtin_ia32_rdtsc();
+#else
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static inline void trace_event(uint32_t id, uint64_t a, uint64_t b)
+{
+   trace_ring_t *ring = trace_ring_self;
+   trace_event_t *ev;
+   int wr, next;
+
+   if( __builtin_expect(NULL == ring, 0) )
+   {
+      ring = trace_ring_attach();
+      if( NULL == ring )
+      {
+         return;
+      }
+   }
+
+   wr = ring->fifo.wr;
+   next = wr + (int)sizeof(trace_event_t);
+   next = (next == ring->fifo.size) ? 0 : next;
+   /* same as for circfifo, wr + 1 == rd means ring is full */
+   if( __builtin_expect(next == __atomic_load_n(&ring->fifo.rd, __ATOMIC_ACQUIRE), 0) )
+   {
+      __atomic_fetch_add(&ring->lost, 1, __ATOMIC_RELAXED);
+      return;
+   }
+
+   ev = (trace_event_t*)&ring->fifo.buff[wr];
+   ev->ts = trace_clock();
+   ev->id = id;
+   ev->a = a;
+   ev->b = b;
+   __atomic_store_n(&ring->fifo.wr, next, __ATOMIC_RELEASE);
+}
+
+/**
+ * Function sets the size of rings allocated for threads which did not record
+ * any event yet. Optional, should be called before first event.
+ *
+ * @param events Number of events in ring, at least 2
+ */
+void trace_init(unsigned events);
+
+/**
+ * Function sets the name of calling thread which is visible in trace viewer
+ */
+void trace_thread_name(const char *name);
+
+/**
+ * Function sets the name of event id which is visible in trace viewer, by
+ * default user events are named ev_<id>
+ */
+void trace_event_name(uint16_t id, const char *name);
+
+/**
+ * Function drains rings of all threads and writes the events sorted by time
+ * into file in Chrome trace (JSON) format. Can be called while other threads
+ * are tracing.
+ *
+ * @param path Output file path
+ * @return Number of written events, -1 on error
+ */
+long trace_dump(const char *path);
+
+#else
+
+#define TRACE(_id, _a, _b) do {} while(0)
+#define TRACE_BEGIN(_id, _a, _b) do {} while(0)
+#define TRACE_END(_id, _a, _b) do {} while(0)
+
+#endif /* CONFIG_TRACE */
+
+#endif /* __TRACE_H_ */